@@ -3,6 +3,7 @@ import m5
 from m5.objects import *
 from m5.defines import buildEnv
 from Ruby import send_evicts
+from m5.util import fatal
 
 acc_types = [
     'Deblur_Modified',
@@ -56,15 +57,140 @@ def define_options(parser):
                       help="number of MSHRs in LCAcc TLBs")
     parser.add_option("--iommu", action="store_true",
                       help="simulate the behavior of an IOMMU")
+    parser.add_option("--mmu_policy", action="store", type="string", default="",
+                      help="accelerator MMU model (ideal, full_iommu, ats_only, border_control, "
+                           "cryptommu_serial, cryptommu_parallel, cryptommu_read_acc)")
+    parser.add_option("--mac_latency", action="store", type="int", default=0,
+                      help="cycles to compute a MAC when verifying a translation, on top "
+                           "of what the TD and DMA controller charge")
     parser.add_option("--dma_issue_width", action="store", type="int", default=64,
                       help="LCAcc DMA issue width")
+    parser.add_option("--netport_priority", action="store_true",
+                      help="give accelerator port messages priority in the garnet fixed network")
+    parser.add_option("--merge_write_checks", action="store_true",
+                      help="LCAcc write hits wait for a check of their page already in flight")
+    parser.add_option("--dma_stream_stores", action="store_true",
+                      help="write LCAcc DMA stores to the L2 without allocating in the L1")
+    parser.add_option("--acc_compute_threads", action="store", type="int", default=0,
+                      help="host threads running LCAcc compute kernels, 0 runs them inline")
+    parser.add_option("--acc_compute_quantum", action="store", type="int", default=1,
+                      help="cycles of LCAcc compute kernels run as one parallel batch")
     parser.add_option("--td_tlb_latency", action="store", type="int", default=3,
                       help="TD TLB lookup latency")
+    parser.add_option("--td_tlb_assoc", action="store", type="int", default=4,
+                      help="TD TLB associativity, 0 for fully associative")
     parser.add_option("--lcacc_tlb_latency", action="store", type="int", default=1,
                       help="LCAcc TLB lookup latency")
+    parser.add_option("--td_prefetch", action="store_true",
+                      help="prefetch translations of upcoming TD tasks")
+    parser.add_option("--td_prefetch_tasks", action="store", type="int", default=4,
+                      help="number of tasks ahead of dispatch covered by TD prefetch")
+    parser.add_option("--td_prefetch_max_inflight", action="store", type="int", default=8,
+                      help="max number of outstanding TD translation prefetches")
+    parser.add_option("--td_prefetch_verify", action="store_true",
+                      help="pre-verify TD prefetched translations")
+    parser.add_option("--td_concurrent_loads", action="store", type="int", default=4,
+                      help="max number of program reads in flight in the TD")
+    parser.add_option("--td_tenant_weights", action="store", type="string", default="",
+                      help="TD fair queueing weights as process:weight[,process:weight]")
+    parser.add_option("--prot_table_base", action="store", type="string", default="0x800000",
+                      help="base address of the protection table")
+    parser.add_option("--prot_table_size", action="store", type="string", default="0x1800000",
+                      help="bytes from the base holding the protection tables of all devices")
+    parser.add_option("--prot_table_device_stride", action="store", type="string", default="0",
+                      help="distance between per-device protection tables, 0 to share one")
+    parser.add_option("--prot_table_packed", action="store_true",
+                      help="pack per-page protection entries into lines (the mac_bits, pages_per_line and pack_devices options apply only then)")
+    parser.add_option("--prot_table_mac_bits", action="store", type="int", default=5,
+                      help="MAC tag bits per protection table entry")
+    parser.add_option("--prot_table_pages_per_line", action="store", type="int", default=0,
+                      help="pages per protection table line, 0 for as many as fit")
+    parser.add_option("--prot_table_pack_devices", action="store", type="int", default=1,
+                      help="number of devices sharing a protection table line")
+    parser.add_option("--l2_metadata_ways", action="store", type="int", default=0,
+                      help="L2 ways per set reserved for protection table lines, 0 to share all ways")
+    parser.add_option("--metadata_cache_size", action="store", type="string", default="0B",
+                      help="size of the protection table cache in front of each memory controller, 0B for none")
+    parser.add_option("--metadata_cache_assoc", action="store", type="int", default=8,
+                      help="metadata cache associativity")
+    parser.add_option("--metadata_cache_latency", action="store", type="int", default=4,
+                      help="metadata cache hit latency in directory cycles")
+    parser.add_option("--metadata_cache_queue", action="store", type="int", default=16,
+                      help="requests the metadata cache holds for memory before the directory must retry")
+    parser.add_option("--metadata_cache_mmu", metavar="POLICY[,POLICY]", action="store",
+                      type="string", default="",
+                      help="MMU policies the metadata cache is active for, empty for all")
+    parser.add_option("--dram_write_drain", type="choice", default="watermark",
+                      choices=["watermark", "opportunistic"],
+                      help="when DRAM controllers drain their write queue")
+    parser.add_option("--dram_write_high_thresh", action="store", type="int", default=None,
+                      help="write queue percentage that forces a DRAM write drain")
+    parser.add_option("--dram_write_low_thresh", action="store", type="int", default=None,
+                      help="write queue percentage that starts a DRAM write drain when no reads wait")
+    parser.add_option("--dram_write_combining", action="store_true",
+                      help="combine all partial writes to the same DRAM burst")
+    parser.add_option("--prot_fetch_max_outstanding", action="store", type="int", default=4,
+                      help="max number of protection table reads in flight")
+    parser.add_option("--prot_fetch_latency", action="store", type="int", default=0,
+                      help="cycles a protection table read takes without --prot_fetch_port, 0 to resolve BCC misses like hits")
+    parser.add_option("--bcc_entries", action="store", type="int", default=10,
+                      help="number of BCC entries per network interrupt")
+    parser.add_option("--bcc_assoc", action="store", type="int", default=10,
+                      help="BCC associativity")
+    parser.add_option("--host_ptw_walkers", action="store", type="int", default=1,
+                      help="max number of host page table walks in flight per network interrupt")
+    parser.add_option("--prot_fetch_port", action="store_true",
+                      help="give protection table reads their own memory port")
+    parser.add_option("--translation_warmup_tasks", action="store", type="int", default=0,
+                      help="tasks per program whose translations are warmed up without timing")
+    parser.add_option("--translation_trace", action="store", type="string", default="",
+                      help="write a binary translation pipeline trace to this file in the output directory")
+    parser.add_option("--translation_trace_entries", action="store", type="int", default=65536,
+                      help="records buffered before the translation trace is written out")
+    parser.add_option("--acc_mem_ports", action="store", type="int", default=0,
+                      help="number of per-accelerator memory interfaces, 0 to share one")
+    parser.add_option("--acc_mem_max_outstanding", action="store", type="int", default=16,
+                      help="max number of timing requests in flight per memory interface")
+    parser.add_option("--protection_memobj", action="store_true",
+                      help="check the traffic of each accelerator memory port against the protection table")
+    parser.add_option("--protection_allow_untracked", action="store_true",
+                      help="let the protection memobj pass pages no accelerator was granted")
 
 
 def create_accelerators(options, system):
     # For now, use same clock as cpus.
-    accelerator = MemoryInterface(clk_domain=system.cpu_clk_domain)
+    accelerator = MemoryInterface(clk_domain=system.cpu_clk_domain,
+                                  max_outstanding=options.acc_mem_max_outstanding)
     exec("system.accelerator = accelerator")
+
+    # accelerators are spread over these by accelerator id, and the ports
+    # over the host's cache ports
+    system.acc_mem_ports = [MemoryInterface(clk_domain=system.cpu_clk_domain,
+                                            port_id=i,
+                                            max_outstanding=options.acc_mem_max_outstanding)
+                            for i in xrange(options.acc_mem_ports)]
+    # with --protection_memobj every port goes through its own checker,
+    # which only passes pages translated for the requesting accelerator
+    if options.protection_memobj and options.acc_mem_ports == 0:
+        fatal("--protection_memobj needs --acc_mem_ports")
+    system.acc_mem_checks = [ProtectionMemobj(clk_domain=system.cpu_clk_domain,
+                                              max_outstanding=options.acc_mem_max_outstanding,
+                                              allow_untracked=options.protection_allow_untracked)
+                             for i in xrange(options.acc_mem_ports)
+                             if options.protection_memobj]
+    for (i, port) in enumerate(system.acc_mem_ports):
+        cpu_ports = system.ruby._cpu_ports
+        if options.protection_memobj:
+            check = system.acc_mem_checks[i]
+            port.master_port = check.data_port
+            check.mem_side = cpu_ports[i % len(cpu_ports)].slave
+        else:
+            port.master_port = cpu_ports[i % len(cpu_ports)].slave
+
+    # protection table reads use their own port into the host's caches;
+    # without it the fetch unit charges --prot_fetch_latency, if any
+    if options.prot_fetch_port:
+        system.prot_fetch_port = MemoryInterface(clk_domain=system.cpu_clk_domain,
+                                                 protection_port=True,
+                                                 max_outstanding=options.prot_fetch_max_outstanding)
+        system.prot_fetch_port.master_port = system.ruby._cpu_ports[0].slave
@@ -51,7 +51,10 @@ class L2Cache(RubyCache):
     latency = 15
 
 def define_options(parser):
-    return
+    parser.add_option("--cache-tag-index", action="store", type="choice",
+                      choices=["hash", "flat"], default="hash",
+                      help="Ruby cache tag lookup: one hash map per cache "
+                           "or a tag array per set")
 
 def create_system(options, full_system, system, dma_ports, ruby_system):
 
@@ -66,15 +69,44 @@ def create_system(options, full_system, system, dma_ports, ruby_system):
     ruby_system.tlb_hack             = options.tlb_hack
     ruby_system.ideal_mmu            = options.ideal_mmu
     ruby_system.iommu                = options.iommu
+    ruby_system.mmu_policy           = options.mmu_policy
+    ruby_system.mac_latency          = options.mac_latency
 
     ruby_system.td_tlb_latency       = options.td_tlb_latency
     ruby_system.td_tlb_size          = options.td_tlb_size
+    ruby_system.td_tlb_assoc         = options.td_tlb_assoc
+    ruby_system.td_prefetch          = options.td_prefetch
+    ruby_system.td_prefetch_tasks    = options.td_prefetch_tasks
+    ruby_system.td_prefetch_max_inflight = options.td_prefetch_max_inflight
+    ruby_system.td_prefetch_verify   = options.td_prefetch_verify
+    ruby_system.td_concurrent_loads  = options.td_concurrent_loads
+    ruby_system.td_tenant_weights    = options.td_tenant_weights
+
+    ruby_system.prot_table_base      = options.prot_table_base
+    ruby_system.prot_table_size      = options.prot_table_size
+    ruby_system.prot_table_device_stride = options.prot_table_device_stride
+    ruby_system.prot_table_packed    = options.prot_table_packed
+    ruby_system.prot_table_mac_bits  = options.prot_table_mac_bits
+    ruby_system.prot_table_pages_per_line = options.prot_table_pages_per_line
+    ruby_system.prot_table_pack_devices = options.prot_table_pack_devices
+    ruby_system.prot_fetch_max_outstanding = options.prot_fetch_max_outstanding
+    ruby_system.prot_fetch_latency   = options.prot_fetch_latency
+    ruby_system.bcc_entries          = options.bcc_entries
+    ruby_system.bcc_assoc            = options.bcc_assoc
+    ruby_system.host_ptw_walkers     = options.host_ptw_walkers
+    ruby_system.translation_warmup_tasks = options.translation_warmup_tasks
+    ruby_system.translation_trace    = options.translation_trace
+    ruby_system.translation_trace_entries = options.translation_trace_entries
 
     ruby_system.lcacc_tlb_latency    = options.lcacc_tlb_latency
     ruby_system.lcacc_tlb_size       = options.lcacc_tlb_size
     ruby_system.lcacc_tlb_mshr       = options.lcacc_tlb_mshr
 
     ruby_system.dma_issue_width      = options.dma_issue_width
+    ruby_system.merge_write_checks   = options.merge_write_checks
+    ruby_system.dma_stream_stores    = options.dma_stream_stores
+    ruby_system.acc_compute_threads  = options.acc_compute_threads
+    ruby_system.acc_compute_quantum  = options.acc_compute_quantum
 
     acc_type_list = options.acc_types.replace(',', ' ').split()
     type_names = [Lcacc.get(acc) for acc in acc_type_list]
@@ -106,11 +138,21 @@ def create_system(options, full_system, system, dma_ports, ruby_system):
     print "num_l1_cntrls = %d" % num_l1_cntrls
     # assert(num_l1_cntrls >= (options.accelerators + options.num_tds))
 
+    # with --netport_priority the port messages move from virtual network 0
+    # to 3, which the network serves first
+    netport_vnet = 0
+    if options.netport_priority:
+        netport_vnet = 3
+        if options.garnet_network != "fixed":
+            fatal("--netport_priority needs --garnet-network=fixed")
+        ruby_system.network.priority_vnets = [3]
+
     for i in xrange(options.num_networkports):
         # First create the Ruby objects associated with
         # the CPU and Accelerator signal communication
         netport_cntrl = SimicsNetworkPortInterface_Controller(version = i,
                         transitions_per_cycle=options.ports,
+                        netport_vnet = netport_vnet,
                         ruby_system = ruby_system)
 
         exec("ruby_system.netport_cntrl%d = netport_cntrl" % i)
@@ -126,11 +168,13 @@ def create_system(options, full_system, system, dma_ports, ruby_system):
         l1i_cache = L1Cache(size = options.l1i_size,
                             assoc = options.l1i_assoc,
                             start_index_bit = block_size_bits,
-                            is_icache = True)
+                            is_icache = True,
+                            tag_index = options.cache_tag_index)
         l1d_cache = L1Cache(size = options.l1d_size,
                             assoc = options.l1d_assoc,
                             start_index_bit = block_size_bits,
-                            is_icache = False)
+                            is_icache = False,
+                            tag_index = options.cache_tag_index)
 
         prefetcher = RubyPrefetcher.Prefetcher()
 
@@ -177,7 +221,9 @@ def create_system(options, full_system, system, dma_ports, ruby_system):
         #
         l2_cache = L2Cache(size = options.l2_size,
                            assoc = options.l2_assoc,
-                           start_index_bit = l2_index_start)
+                           start_index_bit = l2_index_start,
+                           metadata_ways = options.l2_metadata_ways,
+                           tag_index = options.cache_tag_index)
 
         l2_cntrl = L2Cache_Controller(version = i,
                                       L2cache = l2_cache,
@@ -73,6 +73,10 @@ def define_options(parser):
                       choices=['fixed', 'flexible'], help="'fixed'|'flexible'")
     parser.add_option("--network-fault-model", action="store_true", default=False,
                       help="enable network fault model: see src/mem/ruby/network/fault_model/")
+    parser.add_option("--garnet-fast-mode", action="store_true", default=False,
+                      help="stop polling garnet fixed interfaces and allocators that wait on credits")
+    parser.add_option("--garnet-analytic-vnets", type="string", default="",
+                      help="comma separated virtual networks garnet fixed delivers after their zero-load latency")
 
     # ruby mapping options
     parser.add_option("--numa-high-bit", type="int", default=0,
@@ -114,23 +118,51 @@ def setup_memory_controllers(system, ruby, dir_cntrls, options):
     for dir_cntrl in dir_cntrls:
         dir_cntrl.directory.numa_high_bit = numa_bit
 
+        # an optional cache of protection table lines sits between the
+        # directory and its memory
+        mem_port = dir_cntrl.memory
+        metadata_cache_size = getattr(options, "metadata_cache_size", "0B")
+
+        if MemorySize(metadata_cache_size).value > 0:
+            policies = options.metadata_cache_mmu
+            dir_cntrl.metadata_cache = MetadataCache(
+                size = metadata_cache_size,
+                assoc = options.metadata_cache_assoc,
+                hit_latency = options.metadata_cache_latency,
+                queue_size = options.metadata_cache_queue,
+                mmu_policies = policies.split(',') if policies else [])
+            dir_cntrl.metadata_cache.slave = dir_cntrl.memory
+            mem_port = dir_cntrl.metadata_cache.master
+
         crossbar = None
         if len(system.mem_ranges) > 1:
             crossbar = NoncoherentXBar()
             crossbars.append(crossbar)
-            dir_cntrl.memory = crossbar.slave
+            crossbar.slave = mem_port
 
         for r in system.mem_ranges:
             mem_ctrl = MemConfig.create_mem_ctrl(
                 MemConfig.get(options.mem_type), r, index, options.num_dirs,
                 int(math.log(options.num_dirs, 2)), options.cacheline_size)
 
+            if isinstance(mem_ctrl, DRAMCtrl):
+                mem_ctrl.write_drain_policy = \
+                    getattr(options, "dram_write_drain", "watermark")
+                mem_ctrl.write_combining = \
+                    getattr(options, "dram_write_combining", False)
+                if getattr(options, "dram_write_high_thresh", None):
+                    mem_ctrl.write_high_thresh_perc = \
+                        options.dram_write_high_thresh
+                if getattr(options, "dram_write_low_thresh", None):
+                    mem_ctrl.write_low_thresh_perc = \
+                        options.dram_write_low_thresh
+
             mem_ctrls.append(mem_ctrl)
 
             if crossbar != None:
                 mem_ctrl.port = crossbar.master
             else:
-                mem_ctrl.port = dir_cntrl.memory
+                mem_ctrl.port = mem_port
 
         index += 1
 
@@ -218,6 +250,12 @@ def create_system(options, full_system, system, piobus = None, dma_ports = []):
         network.enable_fault_model = True
         network.fault_model = FaultModel()
 
+    if options.garnet_fast_mode or options.garnet_analytic_vnets:
+        assert(options.garnet_network == "fixed")
+        network.fast_mode = options.garnet_fast_mode
+        network.analytic_vnets = \
+            [int(v) for v in options.garnet_analytic_vnets.split(",") if v]
+
     setup_memory_controllers(system, ruby, dir_cntrls, options)
 
     # Connect the cpu sequencers and the piobus
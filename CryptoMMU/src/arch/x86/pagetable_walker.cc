@@ -221,40 +221,7 @@ Walker::WalkerState::startWalk()
     Fault fault = NoFault;
     assert(!started);
     started = true;
-    uint64_t ver_flag = req->IsVerification();
-    uint64_t Vaddr_setup;
-
-    if(ver_flag)
-    {
-
-
-        
-        uint64_t ProcTdevice_offset = req->GetdeviceId();
-           
-        //Addr ProcT_address = 0x800000*(ProcTdevice_offset-1);
-        Addr ProcT_address = 0x800000;
-        ProcT_address = (mask(52) & ProcT_address);
-        uint64_t ProcT_offset = ((req->GetPaddr_Rand()>>2)); /*Permissions for 4 physical pages*/
-        ProcT_offset = ((mask(52) & ProcT_offset));
-        Vaddr_setup = ProcT_address + ProcT_offset;
-        //std::cout <<"mask bits:RandomProc:addressoffset"<< ProcT_address << ":"<<ProcT_address << ":" << (req->GetPaddr_Rand()>>2) <<std::endl;
-        std::cout << std::hex << "ProcT_offset : Vaddr_setup  : device_id" << ProcT_offset << ":" << Vaddr_setup << ":" << (ProcTdevice_offset-1)<<std::endl;
-        
-       /*
-       uint64_t rand_addr = req->GetPaddr_Rand();
-       uint64_t ProcTdevice_offset = req->GetdeviceId();
-       Vaddr_setup = ((rand_addr & mask(40)) << 12 );
-       Vaddr_setup =  Vaddr_setup +(512*ProcTdevice_offset);
-       std::cout <<"Random Page: Random Address" << rand_addr <<":" << Vaddr_setup << std::endl; 
-       */
-       
-    }
-    else
-    {
-        Vaddr_setup = req->getVaddr();
-    }
-    //std::cout << "Verification Flag" << ver_flag << std::endl;
-    setupWalk(Vaddr_setup, ver_flag);
+    setupWalk(req->getVaddr());
     if (timing) {
         nextState = state;
         state = Waiting;
@@ -283,8 +250,7 @@ Walker::WalkerState::startFunctional(Addr &addr, unsigned &logBytes)
     Fault fault = NoFault;
     assert(!started);
     started = true;
-    // No verfication required hence 0
-    setupWalk(addr,0);
+    setupWalk(addr);
 
     DPRINTF(PageTableWalker, "Doing functional page table walk.\n");
 
@@ -578,7 +544,7 @@ Walker::WalkerState::endWalk()
 }
 
 void
-Walker::WalkerState::setupWalk(Addr vaddr, uint64_t ver_flag)
+Walker::WalkerState::setupWalk(Addr vaddr)
 {
     VAddr addr = vaddr;
     CR3 cr3 = tc->readMiscRegNoEffect(MISCREG_CR3);
@@ -622,30 +588,10 @@ Walker::WalkerState::setupWalk(Addr vaddr, uint64_t ver_flag)
     if (timing && req->isBypassCache()) {
         flags.set(Request::BYPASS_CACHE);
     }
-    if(ver_flag)
-    {
-        uint64_t protection_address = addr;
-        //std::cout << "Rnadom physical address read " << protection_address << std::endl;
-        //uint64_t offset = rand() % TheISA::PageBytes;
-        //protection_address = protection_address + offset;
-        RequestPtr request = new Request(protection_address, dataSize, flags,
-                                     walker->masterId);
-        request->SetVerficationRequest(ver_flag);
-        read = new Packet(request, MemCmd::ReadReq);
-        read->allocate();
-    }
-    else
-    {
-         RequestPtr request = new Request(topAddr, dataSize, flags,
+    RequestPtr request = new Request(topAddr, dataSize, flags,
                                      walker->masterId);
-         request->SetVerficationRequest(ver_flag);
-         read = new Packet(request, MemCmd::ReadReq);
-         read->allocate();
-    }
-   
-    //std::cout << "Verification Request sent in StartWalk " << ver_flag << std::endl;
-    
-    
+    read = new Packet(request, MemCmd::ReadReq);
+    read->allocate();
 }
 
 bool
@@ -661,27 +607,7 @@ Walker::WalkerState::recvPacket(PacketPtr pkt)
 
         // @todo someone should pay for this
         pkt->firstWordDelay = pkt->lastWordDelay = 0;
-        if(pkt->req->IsVerification())
-        {
-            //std::cout << "data recieved from verification " << pkt->hasData() << std::endl;
-            //std::cout << "State in verifciation" << state << std::endl;
-            state = Ready;
-            nextState = Waiting;
-            //std::cout <<"Protection table access" << pkt->req->IsVerification()<<std::endl;
-            //fault = NoFault;
-            //protection_access++;
-            //std::cout << "Protection table access" << protection_access << std::endl;
-            read = NULL;
-            bool delayedResponse;
-            Fault fault = walker->tlb->translate(req, tc, NULL, mode, delayedResponse, true);
-            //std::cout << "delayedResponse" << delayedResponse << std::endl;
-            translation->finish(fault, req, tc, mode);
-            return true;
-        }
-        else
-        {
-           state = nextState;
-        //std::cout << "nextState" << nextState << std::endl;
+        state = nextState;
         nextState = Ready;
         PacketPtr write = NULL;
         read = pkt;
@@ -692,8 +618,6 @@ Walker::WalkerState::recvPacket(PacketPtr pkt)
             writes.push_back(write);
         }
         sendPackets();
-        }
-        
     } else {
         sendPackets();
     }
@@ -141,7 +141,7 @@ namespace X86ISA
             std::string name() const {return walker->name();}
 
           private:
-            void setupWalk(Addr vaddr, uint64_t ver_flag);
+            void setupWalk(Addr vaddr);
             Fault stepWalk(PacketPtr &write);
             void sendPackets();
             void endWalk();
@@ -282,10 +282,6 @@ TLB::translate(RequestPtr req, ThreadContext *tc, Translation *translation,
     bool storeCheck = flags & (StoreCheck << FlagShift);
 
     delayedResponse = false;
-    if(req->IsVerification())
-    {
-        return NoFault;
-    }
     // If this is true, we're dealing with a request to a non-memory address
     // space.
     if (seg == SEGMENT_REG_MS) {
@@ -59,6 +59,13 @@ class AddrMap(Enum): vals = ['RoRaBaChCo', 'RoRaBaCoCh', 'RoCoRaBaCh']
 class PageManage(Enum): vals = ['open', 'open_adaptive', 'close',
                                 'close_adaptive']
 
+# Enum for the write drain policy. Watermark switches to writes when
+# the read queue is empty and the writes pass the low threshold, or
+# when they pass the high threshold. Opportunistic also switches as
+# soon as the read queue is empty, and keeps writing until reads
+# arrive, so long write streams see fewer bus turnarounds.
+class WriteDrain(Enum): vals = ['watermark', 'opportunistic']
+
 # DRAMCtrl is a single-channel single-ported DRAM controller model
 # that aims to model the most important system-level performance
 # effects of a DRAM without getting into too much detail of the DRAM
@@ -90,6 +97,15 @@ class DRAMCtrl(AbstractMemory):
     min_writes_per_switch = Param.Unsigned(16, "Minimum write bursts before "
                                            "switching to reads")
 
+    # when to drain the write queue, see WriteDrain
+    write_drain_policy = Param.WriteDrain('watermark', "Write drain policy")
+
+    # partial writes to the same burst are merged when they touch or
+    # overlap, with write combining also when they leave a gap, as the
+    # burst writes the union under a data mask
+    write_combining = Param.Bool(False, "Combine all partial writes to "
+                                 "the same burst")
+
     # scheduler, address map and page policy
     mem_sched_policy = Param.MemSched('frfcfs', "Memory scheduling policy")
     addr_mapping = Param.AddrMap('RoRaBaChCo', "Address mapping policy")
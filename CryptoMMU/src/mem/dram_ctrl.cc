@@ -79,6 +79,8 @@ DRAMCtrl::DRAMCtrl(const DRAMCtrlParams* p) :
     writeHighThreshold(writeBufferSize * p->write_high_thresh_perc / 100.0),
     writeLowThreshold(writeBufferSize * p->write_low_thresh_perc / 100.0),
     minWritesPerSwitch(p->min_writes_per_switch),
+    writeDrainPolicy(p->write_drain_policy),
+    writeCombining(p->write_combining),
     writesThisTime(0), readsThisTime(0),
     tCK(p->tCK), tWTR(p->tWTR), tRTW(p->tRTW), tCS(p->tCS), tBURST(p->tBURST),
     tCCD_L(p->tCCD_L), tRCD(p->tRCD), tCL(p->tCL), tRP(p->tRP), tRAS(p->tRAS),
@@ -407,7 +409,7 @@ DRAMCtrl::decodeAddr(PacketPtr pkt, Addr dramPktAddr, unsigned size,
     // later
     uint16_t bank_id = banksPerRank * rank + bank;
     return new DRAMPacket(pkt, isRead, rank, bank, row, bank_id, dramPktAddr,
-                          size, banks[rank][bank]);
+                          size, banks[rank][bank], pkt->req->requestorClass());
 }
 
 void
@@ -440,7 +442,7 @@ DRAMCtrl::addToReadQueue(PacketPtr pkt, unsigned int pktCount)
         for (auto i = writeQueue.begin(); i != writeQueue.end(); ++i) {
             // check if the read is subsumed in the write entry we are
             // looking at
-            if ((*i)->addr <= addr &&
+            if (!(*i)->masked && (*i)->addr <= addr &&
                 (addr + size) <= ((*i)->addr + (*i)->size)) {
                 foundInWrQ = true;
                 servicedByWrQ++;
@@ -571,6 +573,20 @@ DRAMCtrl::addToWriteQueue(PacketPtr pkt, unsigned int pktCount)
                     (*w)->size = addr + size - (*w)->addr;
                 }
             }
+
+            // with write combining the burst writes the union of the
+            // two under a data mask, so they merge even with a gap
+            if (!merged && writeCombining &&
+                ((*w)->addr & ~Addr(burstSize - 1)) ==
+                (addr & ~Addr(burstSize - 1))) {
+                DPRINTF(DRAM, "Combining write with existing burst\n");
+                merged = true;
+                combinedWrBursts++;
+                Addr end = std::max(addr + size, (*w)->addr + (*w)->size);
+                (*w)->addr = std::min(addr, (*w)->addr);
+                (*w)->size = end - (*w)->addr;
+                (*w)->masked = true;
+            }
             ++w;
         }
 
@@ -685,6 +701,7 @@ DRAMCtrl::recvTimingReq(PacketPtr pkt)
             // remember that we have to retry this port
             retryWrReq = true;
             numWrRetry++;
+            wrQFullStalls[pkt->req->requestorClass()]++;
             return false;
         } else {
             addToWriteQueue(pkt, dram_pkt_count);
@@ -1220,12 +1237,22 @@ DRAMCtrl::doDRAMAccess(DRAMPacket* dram_pkt)
         totMemAccLat += dram_pkt->readyTime - dram_pkt->entryTime;
         totBusLat += tBURST;
         totQLat += cmd_at - dram_pkt->entryTime;
+
+        rdBurstsByClass[dram_pkt->reqClass]++;
+        bytesReadByClass[dram_pkt->reqClass] += burstSize;
+        totMemAccLatByClass[dram_pkt->reqClass] +=
+            dram_pkt->readyTime - dram_pkt->entryTime;
+        totQLatByClass[dram_pkt->reqClass] += cmd_at - dram_pkt->entryTime;
     } else {
         ++writesThisTime;
         if (row_hit)
             writeRowHits++;
         bytesWritten += burstSize;
         perBankWrBursts[dram_pkt->bankId]++;
+
+        wrBurstsByClass[dram_pkt->reqClass]++;
+        bytesWrittenByClass[dram_pkt->reqClass] += burstSize;
+        totWrQLatByClass[dram_pkt->reqClass] += cmd_at - dram_pkt->entryTime;
     }
 }
 
@@ -1283,9 +1310,11 @@ DRAMCtrl::processNextReqEvent()
         if (readQueue.empty()) {
             // In the case there is no read request to go next,
             // trigger writes if we have passed the low threshold (or
-            // if we are draining)
+            // if we are draining), or with opportunistic draining as
+            // the banks would otherwise sit idle
             if (!writeQueue.empty() &&
-                (drainManager || writeQueue.size() > writeLowThreshold)) {
+                (drainManager || writeQueue.size() > writeLowThreshold ||
+                 writeDrainPolicy == Enums::opportunistic)) {
 
                 switch_to_writes = true;
             } else {
@@ -1316,6 +1345,9 @@ DRAMCtrl::processNextReqEvent()
                 busBusyUntil += tWTR + tCL;
             }
 
+            if (switched_cmd_type)
+                busTurnarounds[dram_pkt->reqClass]++;
+
             doDRAMAccess(dram_pkt);
 
             // At this point we're done dealing with the request
@@ -1364,6 +1396,9 @@ DRAMCtrl::processNextReqEvent()
             busBusyUntil += tRTW;
         }
 
+        if (switched_cmd_type)
+            busTurnarounds[dram_pkt->reqClass]++;
+
         doDRAMAccess(dram_pkt);
 
         writeQueue.pop_front();
@@ -1372,10 +1407,14 @@ DRAMCtrl::processNextReqEvent()
         // If we emptied the write queue, or got sufficiently below the
         // threshold (using the minWritesPerSwitch as the hysteresis) and
         // are not draining, or we have reads waiting and have done enough
-        // writes, then switch to reads.
+        // writes, then switch to reads. Opportunistic draining only
+        // stops below the threshold once reads are waiting.
+        bool keep_draining = drainManager ||
+            (writeDrainPolicy == Enums::opportunistic && readQueue.empty());
+
         if (writeQueue.empty() ||
             (writeQueue.size() + minWritesPerSwitch < writeLowThreshold &&
-             !drainManager) ||
+             !keep_draining) ||
             (!readQueue.empty() && writesThisTime >= minWritesPerSwitch)) {
             // turn the bus back around for reads again
             busState = WRITE_TO_READ;
@@ -1898,6 +1937,120 @@ DRAMCtrl::regStats()
          .desc("Writes before turning the bus around for reads")
          .flags(nozero);
 
+    busTurnarounds
+        .init(NumReqClasses)
+        .name(name() + ".busTurnarounds")
+        .desc("Bus turnarounds, by class of the first burst after them")
+        .flags(total);
+
+    wrQFullStalls
+        .init(NumReqClasses)
+        .name(name() + ".wrQFullStalls")
+        .desc("Write requests refused as the write queue was full")
+        .flags(total);
+
+    rdBurstsByClass
+        .init(NumReqClasses)
+        .name(name() + ".rdBurstsByClass")
+        .desc("Read bursts sent to DRAM per requestor class")
+        .flags(total);
+
+    wrBurstsByClass
+        .init(NumReqClasses)
+        .name(name() + ".wrBurstsByClass")
+        .desc("Write bursts sent to DRAM per requestor class")
+        .flags(total);
+
+    bytesReadByClass
+        .init(NumReqClasses)
+        .name(name() + ".bytesReadByClass")
+        .desc("Bytes read from DRAM per requestor class")
+        .flags(total);
+
+    bytesWrittenByClass
+        .init(NumReqClasses)
+        .name(name() + ".bytesWrittenByClass")
+        .desc("Bytes written to DRAM per requestor class")
+        .flags(total);
+
+    totQLatByClass
+        .init(NumReqClasses)
+        .name(name() + ".totQLatByClass")
+        .desc("Total ticks spent queuing per requestor class")
+        .flags(total);
+
+    totWrQLatByClass
+        .init(NumReqClasses)
+        .name(name() + ".totWrQLatByClass")
+        .desc("Total ticks writes spent queuing per requestor class")
+        .flags(total);
+
+    totMemAccLatByClass
+        .init(NumReqClasses)
+        .name(name() + ".totMemAccLatByClass")
+        .desc("Total ticks spent from burst creation until serviced "
+              "by the DRAM per requestor class")
+        .flags(total);
+
+    avgQLatByClass
+        .name(name() + ".avgQLatByClass")
+        .desc("Average queueing delay per DRAM read burst per requestor "
+              "class")
+        .precision(2);
+
+    avgQLatByClass = totQLatByClass / rdBurstsByClass;
+
+    avgWrQLatByClass
+        .name(name() + ".avgWrQLatByClass")
+        .desc("Average queueing delay per DRAM write burst per requestor "
+              "class")
+        .precision(2);
+
+    avgWrQLatByClass = totWrQLatByClass / wrBurstsByClass;
+
+    avgMemAccLatByClass
+        .name(name() + ".avgMemAccLatByClass")
+        .desc("Average memory access latency per DRAM burst per requestor "
+              "class")
+        .precision(2);
+
+    avgMemAccLatByClass = totMemAccLatByClass / rdBurstsByClass;
+
+    avgRdBWByClass
+        .name(name() + ".avgRdBWByClass")
+        .desc("Average DRAM read bandwidth in MiByte/s per requestor class")
+        .precision(2);
+
+    avgRdBWByClass = (bytesReadByClass / 1000000) / simSeconds;
+
+    avgWrBWByClass
+        .name(name() + ".avgWrBWByClass")
+        .desc("Average DRAM write bandwidth in MiByte/s per requestor class")
+        .precision(2);
+
+    avgWrBWByClass = (bytesWrittenByClass / 1000000) / simSeconds;
+
+    for (int i = 0; i < NumReqClasses; i++) {
+        busTurnarounds.subname(i, requestorClassName(i));
+        wrQFullStalls.subname(i, requestorClassName(i));
+        rdBurstsByClass.subname(i, requestorClassName(i));
+        wrBurstsByClass.subname(i, requestorClassName(i));
+        bytesReadByClass.subname(i, requestorClassName(i));
+        bytesWrittenByClass.subname(i, requestorClassName(i));
+        totQLatByClass.subname(i, requestorClassName(i));
+        totWrQLatByClass.subname(i, requestorClassName(i));
+        totMemAccLatByClass.subname(i, requestorClassName(i));
+        avgQLatByClass.subname(i, requestorClassName(i));
+        avgWrQLatByClass.subname(i, requestorClassName(i));
+        avgMemAccLatByClass.subname(i, requestorClassName(i));
+        avgRdBWByClass.subname(i, requestorClassName(i));
+        avgWrBWByClass.subname(i, requestorClassName(i));
+    }
+
+    combinedWrBursts
+        .name(name() + ".combinedWrBursts")
+        .desc("Write bursts combined with a gap, part of mergedWrBursts");
+
     bytesReadDRAM
         .name(name() + ".bytesReadDRAM")
         .desc("Total number of bytes read from DRAM");
@@ -56,8 +56,10 @@
 #include "enums/AddrMap.hh"
 #include "enums/MemSched.hh"
 #include "enums/PageManage.hh"
+#include "enums/WriteDrain.hh"
 #include "mem/abstract_mem.hh"
 #include "mem/qport.hh"
+#include "mem/requestor_class.hh"
 #include "params/DRAMCtrl.hh"
 #include "sim/eventq.hh"
 #include "mem/drampower.hh"
@@ -248,13 +250,23 @@ class DRAMCtrl : public AbstractMemory
         BurstHelper* burstHelper;
         Bank& bankRef;
 
+        /** Requestor class of the packet, kept as writes respond early */
+        const RequestorClass reqClass;
+
+        /**
+         * Set when write combining merged writes that leave a gap, the
+         * entry then no longer holds every byte between addr and size
+         */
+        bool masked;
+
         DRAMPacket(PacketPtr _pkt, bool is_read, uint8_t _rank, uint8_t _bank,
                    uint32_t _row, uint16_t bank_id, Addr _addr,
-                   unsigned int _size, Bank& bank_ref)
+                   unsigned int _size, Bank& bank_ref,
+                   RequestorClass req_class)
             : entryTime(curTick()), readyTime(curTick()),
               pkt(_pkt), isRead(is_read), rank(_rank), bank(_bank), row(_row),
               bankId(bank_id), addr(_addr), size(_size), burstHelper(NULL),
-              bankRef(bank_ref)
+              bankRef(bank_ref), reqClass(req_class), masked(false)
         { }
 
     };
@@ -483,6 +495,8 @@ class DRAMCtrl : public AbstractMemory
     const uint32_t writeHighThreshold;
     const uint32_t writeLowThreshold;
     const uint32_t minWritesPerSwitch;
+    Enums::WriteDrain writeDrainPolicy;
+    const bool writeCombining;
     uint32_t writesThisTime;
     uint32_t readsThisTime;
 
@@ -644,6 +658,28 @@ class DRAMCtrl : public AbstractMemory
     Stats::Histogram rdPerTurnAround;
     Stats::Histogram wrPerTurnAround;
 
+    // Per requestor class: turnarounds are charged to the burst that
+    // waits for the bus to turn, stalls to the refused packet. The class
+    // is Request::requestorClass(), so Ruby traffic is only split if the
+    // directory tags the requests it builds (queueMemoryReadAs/WriteAs)
+    Stats::Vector busTurnarounds;
+    Stats::Vector wrQFullStalls;
+    Stats::Scalar combinedWrBursts;
+
+    // Per requestor class bursts, bytes and latencies, as the totals
+    Stats::Vector rdBurstsByClass;
+    Stats::Vector wrBurstsByClass;
+    Stats::Vector bytesReadByClass;
+    Stats::Vector bytesWrittenByClass;
+    Stats::Vector totQLatByClass;
+    Stats::Vector totWrQLatByClass;
+    Stats::Vector totMemAccLatByClass;
+    Stats::Formula avgQLatByClass;
+    Stats::Formula avgWrQLatByClass;
+    Stats::Formula avgMemAccLatByClass;
+    Stats::Formula avgRdBWByClass;
+    Stats::Formula avgWrBWByClass;
+
     // Latencies summed over all requests
     Stats::Scalar totQLat;
     Stats::Scalar totMemAccLat;
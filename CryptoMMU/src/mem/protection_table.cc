@@ -0,0 +1,93 @@
+#include "mem/protection_table.hh"
+
+#include "base/misc.hh"
+
+// Defaults until RubySystem configures the layout: the baseline table at
+// 0x800000 shared by all devices.
+Addr ProtectionTableLayout::m_base = 0x800000;
+Addr ProtectionTableLayout::m_size = 0x1800000;
+Addr ProtectionTableLayout::m_device_stride = 0;
+bool ProtectionTableLayout::m_packed = false;
+unsigned ProtectionTableLayout::m_mac_bits = 5;
+unsigned ProtectionTableLayout::m_pages_per_line = 64;
+unsigned ProtectionTableLayout::m_pack_devices = 1;
+unsigned ProtectionTableLayout::m_line_bytes = 64;
+unsigned ProtectionTableLayout::m_page_shift = 12;
+
+void
+ProtectionTableLayout::configure(Addr base, Addr size, Addr device_stride,
+                                 bool packed, unsigned mac_bits,
+                                 unsigned pages_per_line,
+                                 unsigned pack_devices, unsigned line_bytes,
+                                 unsigned page_shift)
+{
+    m_base = base;
+    m_size = size;
+    m_device_stride = device_stride;
+    m_packed = packed;
+    m_line_bytes = line_bytes;
+    m_page_shift = page_shift;
+
+    if (!m_packed) {
+        // a line holds the entries of part of one page, of one device
+        m_pages_per_line = 1;
+        m_pack_devices = 1;
+        return;
+    }
+
+    if (pack_devices == 0)
+        fatal("Protection table needs at least one device per line\n");
+
+    m_mac_bits = mac_bits;
+    m_pack_devices = pack_devices;
+
+    unsigned line_bits = m_line_bytes * 8;
+    unsigned max_pages = line_bits / (entryBits() * m_pack_devices);
+
+    if (max_pages == 0)
+        fatal("A %d bit protection entry for %d devices does not fit "
+              "in a %d byte line\n", entryBits(), m_pack_devices,
+              m_line_bytes);
+
+    if (pages_per_line == 0) {
+        m_pages_per_line = max_pages;
+    } else if (pages_per_line > max_pages) {
+        fatal("At most %d pages fit in a protection table line, %d "
+              "requested\n", max_pages, pages_per_line);
+    } else {
+        m_pages_per_line = pages_per_line;
+    }
+}
+
+unsigned
+ProtectionTableLayout::bitInLine(uint64_t device_id, Addr paddr)
+{
+    Addr ppn = paddr >> m_page_shift;
+    unsigned slot = ppn % m_pages_per_line;
+    unsigned lane = device_id % m_pack_devices;
+    return (slot * m_pack_devices + lane) * entryBits();
+}
+
+Addr
+ProtectionTableLayout::lineAddr(uint64_t device_id, Addr paddr)
+{
+    if (!m_packed) {
+        Addr entry = entryAddr(device_id, paddr);
+        return entry - (entry % m_line_bytes);
+    }
+
+    Addr ppn = paddr >> m_page_shift;
+    Addr group = device_id / m_pack_devices;
+    return m_base + group * m_device_stride +
+        (ppn / m_pages_per_line) * m_line_bytes;
+}
+
+Addr
+ProtectionTableLayout::entryAddr(uint64_t device_id, Addr paddr)
+{
+    if (!m_packed) {
+        return m_base + device_id * m_device_stride + (paddr >> 2);
+    }
+
+    return lineAddr(device_id, paddr) + bitInLine(device_id, paddr) / 8;
+}
@@ -0,0 +1,73 @@
+/*
+ * Layout of the in-memory protection table.
+ *
+ * By default the table keeps the layout the walker has always used: the
+ * entry of a physical address is the byte at base + (paddr >> 2), so a
+ * line read covers part of a single page.
+ *
+ * With the packed layout every physical page has a permission entry of
+ * PROT_TABLE_PERM_BITS (R/W/X) plus a MAC tag. Entries are packed into
+ * cache lines, so a single line read covers pagesPerLine() pages (of
+ * packedDevices() devices when several devices share a line).
+ *
+ * In both layouts each device, or group of packed devices, has its own
+ * table starting at base + group * deviceStride.
+ *
+ * The protection table fetch unit, the BCC and ProtectionMemobj all go
+ * through lineAddr()/entryAddr(), so changing the layout changes them
+ * together.
+ */
+
+#ifndef __MEM_PROTECTION_TABLE_HH__
+#define __MEM_PROTECTION_TABLE_HH__
+
+#include <stdint.h>
+
+#include "base/types.hh"
+
+#define PROT_TABLE_PERM_BITS 3
+
+class ProtectionTableLayout
+{
+  public:
+    /**
+     * Set the layout. Unless packed, the baseline layout is used and
+     * mac_bits, pages_per_line and pack_devices are ignored. Otherwise
+     * pages_per_line 0 packs as many entries as fit in a line and
+     * pack_devices is the number of devices sharing each line.
+     */
+    static void configure(Addr base, Addr size, Addr device_stride,
+                          bool packed, unsigned mac_bits,
+                          unsigned pages_per_line, unsigned pack_devices,
+                          unsigned line_bytes, unsigned page_shift);
+
+    static unsigned entryBits() { return PROT_TABLE_PERM_BITS + m_mac_bits; }
+    static unsigned pagesPerLine() { return m_pages_per_line; }
+    static unsigned packedDevices() { return m_pack_devices; }
+    static unsigned lineBytes() { return m_line_bytes; }
+    static unsigned pageBytes() { return 1 << m_page_shift; }
+
+    /// Address of the line holding the entry of paddr's page for device_id
+    static Addr lineAddr(uint64_t device_id, Addr paddr);
+    /// Address of the byte the entry of paddr's page starts in
+    static Addr entryAddr(uint64_t device_id, Addr paddr);
+    /// Whether addr lies in the region holding the tables of all devices
+    static bool contains(Addr addr)
+    { return addr >= m_base && addr - m_base < m_size; }
+
+  private:
+    static Addr m_base;
+    static Addr m_size;
+    static Addr m_device_stride;
+    static bool m_packed;
+    static unsigned m_mac_bits;
+    static unsigned m_pages_per_line;
+    static unsigned m_pack_devices;
+    static unsigned m_line_bytes;
+    static unsigned m_page_shift;
+
+    /// Bit offset of the entry from the start of its line
+    static unsigned bitInLine(uint64_t device_id, Addr paddr);
+};
+
+#endif // __MEM_PROTECTION_TABLE_HH__
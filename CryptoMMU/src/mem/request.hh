@@ -57,6 +57,8 @@
 #include "base/flags.hh"
 #include "base/misc.hh"
 #include "base/types.hh"
+#include "mem/protection_table.hh"
+#include "mem/requestor_class.hh"
 #include "sim/core.hh"
 
 /**
@@ -260,6 +262,8 @@ class Request
     Addr _pAddr_ver;
     Addr _pAddr_rand;
     Addr _vAddr_ver;
+    /** Traffic class set by the issuer, see requestorClass() */
+    RequestorClass _req_class;
 
 
   public:
@@ -271,7 +275,7 @@ class Request
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
           _extraData(0), _contextId(0), _threadId(0), _pc(0),_device_id(0), _ver_req(0),_pAddr_ver(0),_pAddr_rand(0),_vAddr_ver(0),
-          translateDelta(0), accessDelta(0), depth(0) 
+          _req_class(ReqClassCPU), translateDelta(0), accessDelta(0), depth(0) 
     {}
 
     /**
@@ -282,7 +286,8 @@ class Request
     Request(Addr paddr, int size, Flags flags, MasterID mid)
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
-          _extraData(0), _contextId(0), _threadId(0), _pc(0),_ver_req(0),
+          _extraData(0), _contextId(0), _threadId(0), _pc(0), _device_id(0),
+          _ver_req(0), _req_class(ReqClassCPU),
           translateDelta(0), accessDelta(0), depth(0)
     {
         setPhys(paddr, size, flags, mid);
@@ -291,7 +296,8 @@ class Request
     Request(Addr paddr, int size, Flags flags, MasterID mid, Tick time)
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
-          _extraData(0), _contextId(0), _threadId(0), _pc(0),
+          _extraData(0), _contextId(0), _threadId(0), _pc(0), _device_id(0),
+          _ver_req(0), _req_class(ReqClassCPU),
           translateDelta(0), accessDelta(0), depth(0)
     {
         setPhys(paddr, size, flags, mid, time);
@@ -300,7 +306,8 @@ class Request
     Request(Addr paddr, int size, Flags flags, MasterID mid, Tick time, Addr pc)
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
-          _extraData(0), _contextId(0), _threadId(0), _pc(0),
+          _extraData(0), _contextId(0), _threadId(0), _pc(0), _device_id(0),
+          _ver_req(0), _req_class(ReqClassCPU),
           translateDelta(0), accessDelta(0), depth(0)
     {
         setPhys(paddr, size, flags, mid, time);
@@ -312,7 +319,8 @@ class Request
             int cid, ThreadID tid)
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
-          _extraData(0), _contextId(0), _threadId(0), _pc(0), _ver_req(0),
+          _extraData(0), _contextId(0), _threadId(0), _pc(0), _device_id(0),
+          _ver_req(0), _req_class(ReqClassCPU),
           translateDelta(0), accessDelta(0), depth(0)
     {
         setVirt(asid, vaddr, size, flags, mid, pc);
@@ -329,7 +337,7 @@ class Request
         : _paddr(0), _size(0), _masterId(invldMasterId), _time(0),
           _taskId(ContextSwitchTaskId::Unknown), _asid(0), _vaddr(0),
           _extraData(0), _contextId(0), _threadId(0), _pc(0), _device_id(0), _ver_req(0),_pAddr_ver(0), //just maintaining the order of intialization
-          translateDelta(0), accessDelta(0), depth(0)
+          _req_class(ReqClassCPU), translateDelta(0), accessDelta(0), depth(0)
 
         /* 
         : _paddr(paddr), _size(0), _masterId(invldMasterId), _time(0),
@@ -696,6 +704,32 @@ class Request
     {
         return _ver_req;
     }
+
+    /** Tag the request with the class of traffic it belongs to. */
+    void
+    setRequestorClass(RequestorClass req_class)
+    {
+        _req_class = req_class;
+    }
+
+    /**
+     * Class of traffic the request belongs to. Verification requests and
+     * protection table lines are metadata whoever issues them, and a
+     * device id marks accelerator traffic; otherwise the issuer's tag
+     * decides.
+     */
+    RequestorClass
+    requestorClass() const
+    {
+        if (_ver_req || (privateFlags.isSet(VALID_PADDR) &&
+                         ProtectionTableLayout::contains(_paddr)))
+            return ReqClassMetadata;
+
+        if (_device_id != 0)
+            return ReqClassAccelerator;
+
+        return _req_class;
+    }
     void
     SetPaddr_Ver(Addr pAddr_ver)
     {
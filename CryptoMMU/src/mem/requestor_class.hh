@@ -0,0 +1,27 @@
+/*
+ * Classes of memory traffic that the per-requestor stats are split by.
+ *
+ * Cores issue CPU traffic. Accelerators issue data traffic on behalf of
+ * a device. Metadata covers permission verification and protection table
+ * lines, which exist only because of the accelerator MMU.
+ */
+
+#ifndef __MEM_REQUESTOR_CLASS_HH__
+#define __MEM_REQUESTOR_CLASS_HH__
+
+enum RequestorClass
+{
+    ReqClassCPU,
+    ReqClassAccelerator,
+    ReqClassMetadata,
+    NumReqClasses
+};
+
+inline const char *
+requestorClassName(int req_class)
+{
+    static const char *names[NumReqClasses] = { "cpu", "acc", "metadata" };
+    return names[req_class];
+}
+
+#endif // __MEM_REQUESTOR_CLASS_HH__
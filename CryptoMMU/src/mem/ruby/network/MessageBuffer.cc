@@ -220,6 +220,17 @@ MessageBuffer::enqueue(MsgPtr message, Cycles delta)
     m_consumer->storeEventInfo(m_vnet_id);
 }
 
+Cycles
+MessageBuffer::headDelay() const
+{
+    assert(isReady());
+
+    const Message *msg = m_prio_heap.front().m_msgptr.get();
+    Tick waiting = m_receiver->clockEdge() - msg->getLastEnqueueTime();
+
+    return m_receiver->ticksToCycles(msg->getDelayedTicks() + waiting);
+}
+
 Cycles
 MessageBuffer::dequeue()
 {
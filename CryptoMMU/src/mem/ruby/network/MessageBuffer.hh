@@ -118,6 +118,10 @@ class MessageBuffer
     void enqueue(MsgPtr message) { enqueue(message, Cycles(1)); }
     void enqueue(MsgPtr message, Cycles delta);
 
+    //! Delay the message at the head of the queue has accumulated so
+    //! far, what dequeue() would return if it were called now.
+    Cycles headDelay() const;
+
     //! Updates the delay cycles of the message at the head of the queue,
     //! removes it from the queue and returns its total delay.
     Cycles dequeue();
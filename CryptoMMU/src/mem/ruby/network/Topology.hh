@@ -71,6 +71,19 @@ class Topology
     void createLinks(Network *net);
     void print(std::ostream& out) const { out << "[Topology]"; }
 
+    // Link latency and number of routers on the shortest path from node
+    // src to node dest, valid once createLinks has run
+    int
+    pathLatency(NodeID src, NodeID dest) const
+    {
+        return m_component_latencies[src][dest + m_nodes];
+    }
+    int
+    pathRouters(NodeID src, NodeID dest) const
+    {
+        return m_component_inter_switches[src][dest + m_nodes];
+    }
+
   protected:
     void addLink(SwitchID src, SwitchID dest, BasicLink* link,
                  LinkDirection dir);
@@ -59,6 +59,26 @@ GarnetNetwork_d::GarnetNetwork_d(const Params *p)
         m_vnet_type[i] = NULL_VNET_; // default
     }
 
+    m_priority_vnet.resize(m_virtual_networks, false);
+    m_has_priority_vnets = !p->priority_vnets.empty();
+    for (int i = 0; i < p->priority_vnets.size(); i++) {
+        int vnet = p->priority_vnets[i];
+        if (vnet < 0 || vnet >= m_virtual_networks)
+            fatal("%s: priority vnet %d out of range\n", name(), vnet);
+        m_priority_vnet[vnet] = true;
+    }
+
+    m_fast_mode = p->fast_mode;
+    m_analytic_router_latency = p->analytic_router_latency;
+    m_analytic_vnet.resize(m_virtual_networks, false);
+    m_has_analytic_vnets = !p->analytic_vnets.empty();
+    for (int i = 0; i < p->analytic_vnets.size(); i++) {
+        int vnet = p->analytic_vnets[i];
+        if (vnet < 0 || vnet >= m_virtual_networks)
+            fatal("%s: analytic vnet %d out of range\n", name(), vnet);
+        m_analytic_vnet[vnet] = true;
+    }
+
     // record the routers
     for (vector<BasicRouter*>::const_iterator i =  p->routers.begin();
          i != p->routers.end(); ++i) {
@@ -92,6 +112,19 @@ GarnetNetwork_d::init()
     assert(m_topology_ptr != NULL);
     m_topology_ptr->createLinks(this);
 
+    if (m_has_analytic_vnets) {
+        m_analytic_path_latency.resize(m_nodes);
+        for (NodeID src = 0; src < m_nodes; src++) {
+            m_analytic_path_latency[src].resize(m_nodes);
+            for (NodeID dest = 0; dest < m_nodes; dest++) {
+                int links = m_topology_ptr->pathLatency(src, dest);
+                int routers = m_topology_ptr->pathRouters(src, dest);
+                m_analytic_path_latency[src][dest] =
+                    Cycles(links + routers * m_analytic_router_latency);
+            }
+        }
+    }
+
     // FaultModel: declare each router to the fault model
     if(isFaultModelEnabled()){
         for (vector<Router_d*>::const_iterator i= m_routers.begin();
@@ -234,6 +267,64 @@ GarnetNetwork_d::regStats()
         .flags(Stats::pdf | Stats::total | Stats::nozero | Stats::oneline)
         ;
 
+    m_class_flits
+        .init(2)
+        .name(name() + ".class_flits_received")
+        .desc("flits received per vnet class")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+
+    m_class_network_latency
+        .init(2)
+        .name(name() + ".class_network_latency")
+        .desc("network latency of the flits per vnet class")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+
+    m_class_queueing_latency
+        .init(2)
+        .name(name() + ".class_queueing_latency")
+        .desc("queueing latency of the flits per vnet class")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+
+    m_class_avg_latency
+        .name(name() + ".class_average_latency")
+        .desc("average network plus queueing latency per vnet class")
+        .flags(Stats::nozero | Stats::oneline)
+        ;
+    m_class_avg_latency = (m_class_network_latency +
+                           m_class_queueing_latency) / m_class_flits;
+
+    const char *classes[] = { "normal", "priority" };
+    for (int i = 0; i < 2; i++) {
+        m_class_flits.subname(i, classes[i]);
+        m_class_network_latency.subname(i, classes[i]);
+        m_class_queueing_latency.subname(i, classes[i]);
+        m_class_avg_latency.subname(i, classes[i]);
+    }
+
+    m_ni_wakeups
+        .name(name() + ".ni_wakeups")
+        .desc("network interface wakeups")
+        ;
+
+    m_vc_alloc_wakeups
+        .name(name() + ".vc_alloc_wakeups")
+        .desc("router VC allocator wakeups")
+        ;
+
+    m_sw_alloc_wakeups
+        .name(name() + ".sw_alloc_wakeups")
+        .desc("router switch allocator wakeups")
+        ;
+
+    m_analytic_messages
+        .name(name() + ".analytic_messages")
+        .desc("messages delivered without simulating their flits")
+        .flags(Stats::nozero)
+        ;
+
 #ifdef SIM_DSENT
     m_link_utilization
         .init(m_links.size())
@@ -245,6 +336,32 @@ GarnetNetwork_d::regStats()
 #endif
 }
 
+void
+GarnetNetwork_d::profileClassLatency(int vnet, Cycles network_delay,
+                                     Cycles queueing_delay)
+{
+    int vnet_class = m_priority_vnet[vnet] ? 1 : 0;
+    m_class_flits[vnet_class]++;
+    m_class_network_latency[vnet_class] += network_delay;
+    m_class_queueing_latency[vnet_class] += queueing_delay;
+}
+
+Cycles
+GarnetNetwork_d::analyticLatency(NodeID src, NodeID dest, int num_flits) const
+{
+    // the tail flit trails the head by num_flits - 1 cycles and the
+    // destination interface takes one more cycle to eject it
+    return m_analytic_path_latency[src][dest] + Cycles(num_flits);
+}
+
+void
+GarnetNetwork_d::deliverAnalytic(NodeID dest, int vnet, MsgPtr msg_ptr,
+                                 Cycles latency)
+{
+    assert(dest < m_nis.size());
+    m_nis[dest]->receiveAnalytic(msg_ptr, vnet, latency);
+}
+
 #ifdef SIM_VISUAL_TRACE
 void
 GarnetNetwork_d::dumpStatsTick() 
@@ -36,6 +36,7 @@
 
 #include "mem/ruby/network/garnet/BaseGarnetNetwork.hh"
 #include "mem/ruby/network/garnet/NetworkHeader.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
 #include "params/GarnetNetwork_d.hh"
 
 #define SIM_DSENT
@@ -68,6 +69,35 @@ class GarnetNetwork_d : public BaseGarnetNetwork
   void dumpStatsTick();
 #endif
 
+    // With priority vnets the allocators make two passes, the first
+    // over priority vnets only and the second over the rest.
+    int arbitrationPasses() const { return m_has_priority_vnets ? 2 : 1; }
+    bool
+    inArbitrationPass(int vnet, int pass) const
+    {
+        return !m_has_priority_vnets || m_priority_vnet[vnet] == (pass == 0);
+    }
+
+    // per flit latency of its vnet's class, see m_class_flits
+    void profileClassLatency(int vnet, Cycles network_delay,
+                             Cycles queueing_delay);
+
+    // In fast mode network interfaces and switch allocators waiting on a
+    // free VC or a credit stop polling every cycle, the credit wakes them.
+    bool isFastMode() const { return m_fast_mode; }
+
+    // Messages of analytic vnets skip the routers and reach their
+    // destination after the zero-load latency of their path.
+    bool isAnalyticVNet(int vnet) const { return m_analytic_vnet[vnet]; }
+    Cycles analyticLatency(NodeID src, NodeID dest, int num_flits) const;
+    void deliverAnalytic(NodeID dest, int vnet, MsgPtr msg_ptr,
+                         Cycles latency);
+
+    void profileNiWakeup() { m_ni_wakeups++; }
+    void profileVcAllocWakeup() { m_vc_alloc_wakeups++; }
+    void profileSwAllocWakeup() { m_sw_alloc_wakeups++; }
+    void profileAnalyticMessage() { m_analytic_messages++; }
+
     VNET_type
     get_vnet_type(int vc)
     {
@@ -98,6 +128,14 @@ class GarnetNetwork_d : public BaseGarnetNetwork
     GarnetNetwork_d& operator=(const GarnetNetwork_d& obj);
 
     std::vector<VNET_type > m_vnet_type;
+    std::vector<bool> m_priority_vnet;
+    bool m_has_priority_vnets;
+    bool m_fast_mode;
+    std::vector<bool> m_analytic_vnet;
+    bool m_has_analytic_vnets;
+    Cycles m_analytic_router_latency;
+    // link and router cycles from node to node, see analyticLatency
+    std::vector<std::vector<Cycles> > m_analytic_path_latency;
     std::vector<Router_d *> m_routers;   // All Routers in Network
     std::vector<NetworkLink_d *> m_links; // All links in the network
     std::vector<CreditLink_d *> m_creditlinks; // All links in net
@@ -114,6 +152,18 @@ class GarnetNetwork_d : public BaseGarnetNetwork
     // Statistical variables for performance
     Stats::Scalar m_avg_link_utilization;
     Stats::Vector m_average_vc_load;
+
+    // indexed by class: 0 for normal vnets, 1 for priority vnets
+    Stats::Vector m_class_flits;
+    Stats::Vector m_class_network_latency;
+    Stats::Vector m_class_queueing_latency;
+    Stats::Formula m_class_avg_latency;
+
+    // host work done by the network, to compare with fast mode on and off
+    Stats::Scalar m_ni_wakeups;
+    Stats::Scalar m_vc_alloc_wakeups;
+    Stats::Scalar m_sw_alloc_wakeups;
+    Stats::Scalar m_analytic_messages;
 #ifdef SIM_DSENT
     Stats::Scalar m_avg_router_utilization;
     Stats::Vector m_link_utilization;
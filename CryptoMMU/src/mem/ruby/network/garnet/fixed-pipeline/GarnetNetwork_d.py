@@ -59,3 +59,12 @@ class GarnetNetwork_d(BaseGarnetNetwork):
     cxx_header = "mem/ruby/network/garnet/fixed-pipeline/GarnetNetwork_d.hh"
     buffers_per_data_vc = Param.UInt32(4, "buffers per data virtual channel");
     buffers_per_ctrl_vc = Param.UInt32(1, "buffers per ctrl virtual channel");
+    priority_vnets = VectorParam.Int([],
+        "virtual networks whose flits win switch and link arbitration");
+    fast_mode = Param.Bool(False,
+        "only wake interfaces and switch allocators that can make progress");
+    analytic_vnets = VectorParam.Int([],
+        "virtual networks delivered after their zero-load latency, "
+        "without simulating their flits");
+    analytic_router_latency = Param.Cycles(3,
+        "cycles an analytic message spends in each router on its path");
@@ -55,6 +55,7 @@ InputUnit_d::InputUnit_d(int id, Router_d *router) : Consumer(router)
     for (int i=0; i < m_num_vcs; i++) {
         m_vcs[i] = new VirtualChannel_d(i);
     }
+    m_active_vcs = 0;
 }
 
 InputUnit_d::~InputUnit_d()
@@ -63,9 +63,14 @@ class InputUnit_d : public Consumer
     inline void
     set_vc_state(VC_state_type state, int vc, Cycles curTime)
     {
+        if (state == IDLE_ && m_vcs[vc]->get_state() != IDLE_)
+            m_active_vcs--;
         m_vcs[vc]->set_state(state, curTime);
     }
 
+    // Whether any vc holds a packet, idle vcs never need a stage
+    inline bool is_active() const { return m_active_vcs > 0; }
+
     inline void
     set_enqueue_time(int invc, Cycles time)
     {
@@ -108,6 +113,8 @@ class InputUnit_d : public Consumer
     updateRoute(int vc, int outport, Cycles curTime)
     {
         m_vcs[vc]->set_outport(outport);
+        if (m_vcs[vc]->get_state() == IDLE_)
+            m_active_vcs++;
         m_vcs[vc]->set_state(VC_AB_, curTime);
     }
 
@@ -179,6 +186,7 @@ class InputUnit_d : public Consumer
 
     // Virtual channels
     std::vector<VirtualChannel_d *> m_vcs;
+    int m_active_vcs; // vcs not in IDLE_
 
     // Statistical variables
     std::vector<double> m_num_buffer_writes;
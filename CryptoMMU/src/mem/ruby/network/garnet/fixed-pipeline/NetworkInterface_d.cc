@@ -65,6 +65,9 @@ NetworkInterface_d::NetworkInterface_d(const Params *p)
     for (int i = 0; i < m_virtual_networks; i++) {
         m_vc_allocator[i] = 0;
     }
+
+    m_vnet_blocked.resize(m_virtual_networks, false);
+    m_analytic_arrival.resize(m_virtual_networks, Cycles(0));
 }
 
 void
@@ -189,6 +192,69 @@ NetworkInterface_d::flitisizeMessage(MsgPtr msg_ptr, int vnet)
     return true ;
 }
 
+/*
+ * Messages of analytic vnets are not flitisized. Each destination gets a
+ * copy after the zero-load latency of its path, and the flits are counted
+ * in the network stats as if they had crossed it.
+ */
+
+void
+NetworkInterface_d::sendAnalytic(MsgPtr msg_ptr, int vnet)
+{
+    NetworkMessage *net_msg_ptr = safe_cast<NetworkMessage *>(msg_ptr.get());
+    vector<NodeID> dest_nodes =
+        net_msg_ptr->getInternalDestination().getAllDest();
+
+    int num_flits = (int) ceil((double) m_net_ptr->MessageSizeType_to_int(
+        net_msg_ptr->getMessageSize())/m_net_ptr->getNiFlitSize());
+    Cycles queueing_delay = curCycle() - ticksToCycles(msg_ptr->getTime());
+
+    for (int ctr = 0; ctr < dest_nodes.size(); ctr++) {
+        MsgPtr new_msg_ptr = msg_ptr->clone();
+        NodeID destID = dest_nodes[ctr];
+
+        NetworkMessage *new_net_msg_ptr =
+            safe_cast<NetworkMessage *>(new_msg_ptr.get());
+        if (dest_nodes.size() > 1) {
+            NetDest personal_dest;
+            for (int m = 0; m < (int) MachineType_NUM; m++) {
+                if ((destID >= MachineType_base_number((MachineType) m)) &&
+                    destID < MachineType_base_number((MachineType) (m+1))) {
+                    personal_dest.add((MachineID) {(MachineType) m, (destID -
+                        MachineType_base_number((MachineType) m))});
+                    break;
+                }
+            }
+            new_net_msg_ptr->getInternalDestination() = personal_dest;
+        }
+
+        Cycles latency = m_net_ptr->analyticLatency(m_id, destID, num_flits);
+        m_net_ptr->deliverAnalytic(destID, vnet, new_msg_ptr, latency);
+        m_net_ptr->profileAnalyticMessage();
+
+        for (int i = 0; i < num_flits; i++) {
+            m_net_ptr->increment_injected_flits(vnet);
+            m_net_ptr->increment_received_flits(vnet);
+            m_net_ptr->increment_network_latency(latency, vnet);
+            m_net_ptr->increment_queueing_latency(queueing_delay, vnet);
+            m_net_ptr->profileClassLatency(vnet, latency, queueing_delay);
+        }
+    }
+}
+
+void
+NetworkInterface_d::receiveAnalytic(MsgPtr msg_ptr, int vnet, Cycles latency)
+{
+    // never overtake an earlier analytic message, the protocol buffer of
+    // an ordered vnet is strict FIFO
+    Cycles arrival = curCycle() + latency;
+    if (arrival < m_analytic_arrival[vnet])
+        arrival = m_analytic_arrival[vnet];
+    m_analytic_arrival[vnet] = arrival;
+
+    outNode_ptr[vnet]->enqueue(msg_ptr, arrival - curCycle());
+}
+
 // Looking for a free output vc
 int
 NetworkInterface_d::calculateVC(int vnet)
@@ -221,6 +287,7 @@ void
 NetworkInterface_d::wakeup()
 {
     DPRINTF(RubyNetwork, "m_id: %d woke up at time: %lld", m_id, curCycle());
+    m_net_ptr->profileNiWakeup();
 
     MsgPtr msg_ptr;
 
@@ -228,15 +295,21 @@ NetworkInterface_d::wakeup()
     // can pick up a message/cycle for each virtual net
     for (int vnet = 0; vnet < inNode_ptr.size(); ++vnet) {
         MessageBuffer *b = inNode_ptr[vnet];
-        if (b == nullptr) {
+        if (b == nullptr || m_vnet_blocked[vnet]) {
             continue;
         }
 
         while (b->isReady()) { // Is there a message waiting
             msg_ptr = b->peekMsgPtr();
-            if (flitisizeMessage(msg_ptr, vnet)) {
+            if (m_net_ptr->isAnalyticVNet(vnet)) {
+                sendAnalytic(msg_ptr, vnet);
+                b->dequeue();
+            } else if (flitisizeMessage(msg_ptr, vnet)) {
                 b->dequeue();
             } else {
+                // in fast mode wait for the credit that frees a vc
+                // instead of retrying every cycle
+                m_vnet_blocked[vnet] = m_net_ptr->isFastMode();
                 break;
             }
         }
@@ -271,6 +344,7 @@ NetworkInterface_d::wakeup()
 
         m_net_ptr->increment_network_latency(network_delay, vnet);
         m_net_ptr->increment_queueing_latency(queueing_delay, vnet);
+        m_net_ptr->profileClassLatency(vnet, network_delay, queueing_delay);
         delete t_flit;
     }
 
@@ -281,8 +355,13 @@ NetworkInterface_d::wakeup()
         m_out_vc_state[t_flit->get_vc()]->increment_credit();
         if (t_flit->is_free_signal()) {
             m_out_vc_state[t_flit->get_vc()]->setState(IDLE_, curCycle());
+            m_vnet_blocked[get_vnet(t_flit->get_vc())] = false;
         }
         delete t_flit;
+
+        // nothing polls for this credit in fast mode
+        if (m_net_ptr->isFastMode())
+            checkReschedule();
     }
 }
 
@@ -295,52 +374,61 @@ NetworkInterface_d::wakeup()
 void
 NetworkInterface_d::scheduleOutputLink()
 {
-    int vc = m_vc_round_robin;
+    int start_vc = m_vc_round_robin;
     m_vc_round_robin++;
     if (m_vc_round_robin == m_num_vcs)
         m_vc_round_robin = 0;
 
-    for (int i = 0; i < m_num_vcs; i++) {
-        vc++;
-        if (vc == m_num_vcs)
-            vc = 0;
-
-        // model buffer backpressure
-        if (m_ni_buffers[vc]->isReady(curCycle()) &&
-            m_out_vc_state[vc]->has_credits()) {
-
-            bool is_candidate_vc = true;
-            int t_vnet = get_vnet(vc);
-            int vc_base = t_vnet * m_vc_per_vnet;
-
-            if (m_net_ptr->isVNetOrdered(t_vnet)) {
-                for (int vc_offset = 0; vc_offset < m_vc_per_vnet;
-                     vc_offset++) {
-                    int t_vc = vc_base + vc_offset;
-                    if (m_ni_buffers[t_vc]->isReady(curCycle())) {
-                        if (m_ni_enqueue_time[t_vc] < m_ni_enqueue_time[vc]) {
-                            is_candidate_vc = false;
-                            break;
+    // flits of priority vnets get the link before any other
+    for (int pass = 0; pass < m_net_ptr->arbitrationPasses(); pass++) {
+        int vc = start_vc;
+
+        for (int i = 0; i < m_num_vcs; i++) {
+            vc++;
+            if (vc == m_num_vcs)
+                vc = 0;
+
+            if (!m_net_ptr->inArbitrationPass(get_vnet(vc), pass))
+                continue;
+
+            // model buffer backpressure
+            if (m_ni_buffers[vc]->isReady(curCycle()) &&
+                m_out_vc_state[vc]->has_credits()) {
+
+                bool is_candidate_vc = true;
+                int t_vnet = get_vnet(vc);
+                int vc_base = t_vnet * m_vc_per_vnet;
+
+                if (m_net_ptr->isVNetOrdered(t_vnet)) {
+                    for (int vc_offset = 0; vc_offset < m_vc_per_vnet;
+                         vc_offset++) {
+                        int t_vc = vc_base + vc_offset;
+                        if (m_ni_buffers[t_vc]->isReady(curCycle())) {
+                            if (m_ni_enqueue_time[t_vc] <
+                                m_ni_enqueue_time[vc]) {
+                                is_candidate_vc = false;
+                                break;
+                            }
                         }
                     }
                 }
+                if (!is_candidate_vc)
+                    continue;
+
+                m_out_vc_state[vc]->decrement_credit();
+                // Just removing the flit
+                flit_d *t_flit = m_ni_buffers[vc]->getTopFlit();
+                t_flit->set_time(curCycle() + Cycles(1));
+                outSrcQueue->insert(t_flit);
+                // schedule the out link
+                outNetLink->scheduleEventAbsolute(clockEdge(Cycles(1)));
+
+                if (t_flit->get_type() == TAIL_ ||
+                   t_flit->get_type() == HEAD_TAIL_) {
+                    m_ni_enqueue_time[vc] = Cycles(INFINITE_);
+                }
+                return;
             }
-            if (!is_candidate_vc)
-                continue;
-
-            m_out_vc_state[vc]->decrement_credit();
-            // Just removing the flit
-            flit_d *t_flit = m_ni_buffers[vc]->getTopFlit();
-            t_flit->set_time(curCycle() + Cycles(1));
-            outSrcQueue->insert(t_flit);
-            // schedule the out link
-            outNetLink->scheduleEventAbsolute(clockEdge(Cycles(1)));
-
-            if (t_flit->get_type() == TAIL_ ||
-               t_flit->get_type() == HEAD_TAIL_) {
-                m_ni_enqueue_time[vc] = Cycles(INFINITE_);
-            }
-            return;
         }
     }
 }
@@ -359,19 +447,23 @@ NetworkInterface_d::get_vnet(int vc)
 void
 NetworkInterface_d::checkReschedule()
 {
-    for (const auto& it : inNode_ptr) {
-        if (it == nullptr) {
+    for (int vnet = 0; vnet < inNode_ptr.size(); ++vnet) {
+        MessageBuffer *b = inNode_ptr[vnet];
+        if (b == nullptr || m_vnet_blocked[vnet]) {
             continue;
         }
 
-        while (it->isReady()) { // Is there a message waiting
+        if (b->isReady()) { // Is there a message waiting
             scheduleEvent(Cycles(1));
             return;
         }
     }
 
+    // in fast mode a flit without credits waits for the credit link
+    bool fast_mode = m_net_ptr->isFastMode();
     for (int vc = 0; vc < m_num_vcs; vc++) {
-        if (m_ni_buffers[vc]->isReady(curCycle() + Cycles(1))) {
+        if (m_ni_buffers[vc]->isReady(curCycle() + Cycles(1)) &&
+            (!fast_mode || m_out_vc_state[vc]->has_credits())) {
             scheduleEvent(Cycles(1));
             return;
         }
@@ -67,6 +67,9 @@ class NetworkInterface_d : public ClockedObject, public Consumer
     int get_vnet(int vc);
     void init_net_ptr(GarnetNetwork_d *net_ptr) { m_net_ptr = net_ptr; }
 
+    // Hand a message of an analytic vnet to the protocol after latency
+    void receiveAnalytic(MsgPtr msg_ptr, int vnet, Cycles latency);
+
     uint32_t functionalWrite(Packet *);
 
   private:
@@ -89,12 +92,18 @@ class NetworkInterface_d : public ClockedObject, public Consumer
     std::vector<flitBuffer_d *>   m_ni_buffers;
     std::vector<Cycles> m_ni_enqueue_time;
 
+    // Fast mode: vnets whose next message waits for a free output vc
+    std::vector<bool> m_vnet_blocked;
+    // Latest arrival handed to each protocol buffer by receiveAnalytic
+    std::vector<Cycles> m_analytic_arrival;
+
     // The Message buffers that takes messages from the protocol
     std::vector<MessageBuffer *> inNode_ptr;
     // The Message buffers that provides messages to the protocol
     std::vector<MessageBuffer *> outNode_ptr;
 
     bool flitisizeMessage(MsgPtr msg_ptr, int vnet);
+    void sendAnalytic(MsgPtr msg_ptr, int vnet);
     int calculateVC(int vnet);
     void scheduleOutputLink();
     void checkReschedule();
@@ -74,10 +74,19 @@ OutputUnit_d::wakeup()
                                   m_outvc_state[out_vc]->get_invc(),
                                   m_outvc_state[out_vc]->get_credit_count());
 
-        if (t_flit->is_free_signal())
+        bool free_signal = t_flit->is_free_signal();
+        if (free_signal)
             set_vc_state(IDLE_, out_vc, m_router->curCycle());
 
         delete t_flit;
+
+        // in fast mode the allocators wait for the credit or the free vc
+        // instead of polling for them
+        if (m_router->get_net_ptr()->isFastMode()) {
+            m_router->swarb_req();
+            if (free_signal)
+                m_router->vcarb_req();
+        }
     }
 }
 
@@ -77,6 +77,8 @@ SWallocator_d::init()
 void
 SWallocator_d::wakeup()
 {
+    m_router->get_net_ptr()->profileSwAllocWakeup();
+
     arbitrate_inports(); // First stage of allocation
     arbitrate_outports(); // Second stage of allocation
 
@@ -88,9 +90,12 @@ SWallocator_d::wakeup()
 void
 SWallocator_d::arbitrate_inports()
 {
+    GarnetNetwork_d *net = m_router->get_net_ptr();
+
     // First do round robin arbitration on a set of input vc requests
     for (int inport = 0; inport < m_num_inports; inport++) {
-        int invc = m_round_robin_inport[inport];
+        int start_invc = m_round_robin_inport[inport];
+        int invc = start_invc;
 
         // Select next round robin vc candidate within valid vnet
         int next_round_robin_invc = invc;
@@ -104,25 +109,36 @@ SWallocator_d::arbitrate_inports()
 
         m_round_robin_inport[inport] = next_round_robin_invc;
 
-        for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
-            invc++;
-            if (invc >= m_num_vcs)
-                invc = 0;
-
-            if (!((m_router->get_net_ptr())->validVirtualNetwork(
-                get_vnet(invc))))
-                continue;
-
-            if (m_input_unit[inport]->need_stage(invc, ACTIVE_, SA_,
-                                                 m_router->curCycle()) &&
-                m_input_unit[inport]->has_credits(invc)) {
-
-                if (is_candidate_inport(inport, invc)) {
-                    int outport = m_input_unit[inport]->get_route(invc);
-                    m_local_arbiter_activity++;
-                    m_port_req[outport][inport] = true;
-                    m_vc_winners[outport][inport]= invc;
-                    break; // got one vc winner for this port
+        if (net->isFastMode() && !m_input_unit[inport]->is_active())
+            continue;
+
+        // vcs of priority vnets are considered first
+        bool granted = false;
+        for (int pass = 0; pass < net->arbitrationPasses() && !granted;
+             pass++) {
+            invc = start_invc;
+
+            for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
+                invc++;
+                if (invc >= m_num_vcs)
+                    invc = 0;
+
+                if (!net->validVirtualNetwork(get_vnet(invc)) ||
+                    !net->inArbitrationPass(get_vnet(invc), pass))
+                    continue;
+
+                if (m_input_unit[inport]->need_stage(invc, ACTIVE_, SA_,
+                                                     m_router->curCycle()) &&
+                    m_input_unit[inport]->has_credits(invc)) {
+
+                    if (is_candidate_inport(inport, invc)) {
+                        int outport = m_input_unit[inport]->get_route(invc);
+                        m_local_arbiter_activity++;
+                        m_port_req[outport][inport] = true;
+                        m_vc_winners[outport][inport]= invc;
+                        granted = true;
+                        break; // got one vc winner for this port
+                    }
                 }
             }
         }
@@ -156,60 +172,74 @@ SWallocator_d::is_candidate_inport(int inport, int invc)
 void
 SWallocator_d::arbitrate_outports()
 {
+    GarnetNetwork_d *net = m_router->get_net_ptr();
+
     // Now there are a set of input vc requests for output vcs.
     // Again do round robin arbitration on these requests
     for (int outport = 0; outport < m_num_outports; outport++) {
-        int inport = m_round_robin_outport[outport];
+        int start_inport = m_round_robin_outport[outport];
+        int inport = start_inport;
         m_round_robin_outport[outport]++;
 
         if (m_round_robin_outport[outport] >= m_num_outports)
             m_round_robin_outport[outport] = 0;
 
-        for (int inport_iter = 0; inport_iter < m_num_inports; inport_iter++) {
-            inport++;
-            if (inport >= m_num_inports)
-                inport = 0;
-
-            // inport has a request this cycle for outport:
-            if (m_port_req[outport][inport]) {
-                m_port_req[outport][inport] = false;
-                int invc = m_vc_winners[outport][inport];
-                int outvc = m_input_unit[inport]->get_outvc(invc);
-
-                // remove flit from Input Unit
-                flit_d *t_flit = m_input_unit[inport]->getTopFlit(invc);
-                t_flit->advance_stage(ST_, m_router->curCycle());
-                t_flit->set_vc(outvc);
-                t_flit->set_outport(outport);
-                t_flit->set_time(m_router->curCycle() + Cycles(1));
-
-                m_output_unit[outport]->decrement_credit(outvc);
-                m_router->update_sw_winner(inport, t_flit);
-                m_global_arbiter_activity++;
-
-                if ((t_flit->get_type() == TAIL_) ||
-                    t_flit->get_type() == HEAD_TAIL_) {
-
-                    // Send a credit back
-                    // along with the information that this VC is now idle
-                    m_input_unit[inport]->increment_credit(invc, true,
-                        m_router->curCycle());
-
-                    // This Input VC should now be empty
-                    assert(m_input_unit[inport]->isReady(invc,
-                        m_router->curCycle()) == false);
-
-                    m_input_unit[inport]->set_vc_state(IDLE_, invc,
-                        m_router->curCycle());
-                    m_input_unit[inport]->set_enqueue_time(invc,
-                        Cycles(INFINITE_));
-                } else {
-                    // Send a credit back
-                    // but do not indicate that the VC is idle
-                    m_input_unit[inport]->increment_credit(invc, false,
-                        m_router->curCycle());
+        // requests from priority vnets win over the rest
+        bool granted = false;
+        for (int pass = 0; pass < net->arbitrationPasses() && !granted;
+             pass++) {
+            inport = start_inport;
+
+            for (int inport_iter = 0; inport_iter < m_num_inports;
+                 inport_iter++) {
+                inport++;
+                if (inport >= m_num_inports)
+                    inport = 0;
+
+                // inport has a request this cycle for outport:
+                if (m_port_req[outport][inport] &&
+                    net->inArbitrationPass(
+                        get_vnet(m_vc_winners[outport][inport]), pass)) {
+                    m_port_req[outport][inport] = false;
+                    int invc = m_vc_winners[outport][inport];
+                    int outvc = m_input_unit[inport]->get_outvc(invc);
+
+                    // remove flit from Input Unit
+                    flit_d *t_flit = m_input_unit[inport]->getTopFlit(invc);
+                    t_flit->advance_stage(ST_, m_router->curCycle());
+                    t_flit->set_vc(outvc);
+                    t_flit->set_outport(outport);
+                    t_flit->set_time(m_router->curCycle() + Cycles(1));
+
+                    m_output_unit[outport]->decrement_credit(outvc);
+                    m_router->update_sw_winner(inport, t_flit);
+                    m_global_arbiter_activity++;
+
+                    if ((t_flit->get_type() == TAIL_) ||
+                        t_flit->get_type() == HEAD_TAIL_) {
+
+                        // Send a credit back
+                        // along with the information that this VC is now idle
+                        m_input_unit[inport]->increment_credit(invc, true,
+                            m_router->curCycle());
+
+                        // This Input VC should now be empty
+                        assert(m_input_unit[inport]->isReady(invc,
+                            m_router->curCycle()) == false);
+
+                        m_input_unit[inport]->set_vc_state(IDLE_, invc,
+                            m_router->curCycle());
+                        m_input_unit[inport]->set_enqueue_time(invc,
+                            Cycles(INFINITE_));
+                    } else {
+                        // Send a credit back
+                        // but do not indicate that the VC is idle
+                        m_input_unit[inport]->increment_credit(invc, false,
+                            m_router->curCycle());
+                    }
+                    granted = true;
+                    break; // got a in request for this outport
                 }
-                break; // got a in request for this outport
             }
         }
     }
@@ -220,9 +250,17 @@ SWallocator_d::check_for_wakeup()
 {
     Cycles nextCycle = m_router->curCycle() + Cycles(1);
 
+    // in fast mode a vc without credits is woken by the credit, see
+    // OutputUnit_d::wakeup
+    bool fast_mode = m_router->get_net_ptr()->isFastMode();
+
     for (int i = 0; i < m_num_inports; i++) {
+        if (fast_mode && !m_input_unit[i]->is_active())
+            continue;
+
         for (int j = 0; j < m_num_vcs; j++) {
-            if (m_input_unit[i]->need_stage(j, ACTIVE_, SA_, nextCycle)) {
+            if (m_input_unit[i]->need_stage(j, ACTIVE_, SA_, nextCycle) &&
+                (!fast_mode || m_input_unit[i]->has_credits(j))) {
                 scheduleEvent(Cycles(1));
                 return;
             }
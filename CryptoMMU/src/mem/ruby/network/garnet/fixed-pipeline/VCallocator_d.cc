@@ -112,6 +112,8 @@ VCallocator_d::clear_request_vector()
 void
 VCallocator_d::wakeup()
 {
+    m_router->get_net_ptr()->profileVcAllocWakeup();
+
     arbitrate_invcs(); // First stage of allocation
     arbitrate_outvcs(); // Second stage of allocation
 
@@ -174,10 +176,30 @@ VCallocator_d::select_outvc(int inport_iter, int invc_iter)
     }
 }
 
+bool
+VCallocator_d::has_idle_outvc(int inport_iter, int invc_iter, Cycles time)
+{
+    int outport = m_input_unit[inport_iter]->get_route(invc_iter);
+    int outvc_base = get_vnet(invc_iter)*m_vc_per_vnet;
+
+    for (int outvc_offset = 0; outvc_offset < m_vc_per_vnet;
+         outvc_offset++) {
+        if (m_output_unit[outport]->is_vc_idle(outvc_base + outvc_offset,
+                                               time))
+            return true;
+    }
+    return false;
+}
+
 void
 VCallocator_d::arbitrate_invcs()
 {
+    bool fast_mode = m_router->get_net_ptr()->isFastMode();
+
     for (int inport_iter = 0; inport_iter < m_num_inports; inport_iter++) {
+        if (fast_mode && !m_input_unit[inport_iter]->is_active())
+            continue;
+
         for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
             if (!((m_router->get_net_ptr())->validVirtualNetwork(
                 get_vnet(invc_iter))))
@@ -258,9 +280,17 @@ VCallocator_d::check_for_wakeup()
 {
     Cycles nextCycle = m_router->curCycle() + Cycles(1);
 
+    // in fast mode a vc waiting for an output vc is woken when one is
+    // freed, see OutputUnit_d::wakeup
+    bool fast_mode = m_router->get_net_ptr()->isFastMode();
+
     for (int i = 0; i < m_num_inports; i++) {
+        if (fast_mode && !m_input_unit[i]->is_active())
+            continue;
+
         for (int j = 0; j < m_num_vcs; j++) {
-            if (m_input_unit[i]->need_stage(j, VC_AB_, VA_, nextCycle)) {
+            if (m_input_unit[i]->need_stage(j, VC_AB_, VA_, nextCycle) &&
+                (!fast_mode || has_idle_outvc(i, j, nextCycle))) {
                 scheduleEvent(Cycles(1));
                 return;
             }
@@ -56,6 +56,7 @@ class VCallocator_d : public Consumer
     void arbitrate_outvcs();
     bool is_invc_candidate(int inport_iter, int invc_iter);
     void select_outvc(int inport_iter, int invc_iter);
+    bool has_idle_outvc(int inport_iter, int invc_iter, Cycles time);
 
     double get_local_arbit_count(unsigned int vnet) const
     { return m_local_arbiter_activity[vnet]; }
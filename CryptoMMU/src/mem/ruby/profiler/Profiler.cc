@@ -290,6 +290,8 @@ Profiler::regStats(const std::string &pName)
     m_host_pagetable_walk_time.resize(num_thread_contexts);
     m_bcc_hits.resize(num_thread_contexts);
     m_bcc_access.resize(num_thread_contexts);
+    m_prot_fetches.resize(num_thread_contexts);
+    m_prot_fetch_merged.resize(num_thread_contexts);
 
     for (int i = 0; i < num_thread_contexts; i++) {
         m_host_pagetable_walks[i]
@@ -304,6 +306,38 @@ Profiler::regStats(const std::string &pName)
         m_bcc_access[i]
             .name(pName + csprintf(".networkinterrupts_%i.bcc_access", i))
             .desc("Number of BCC access in BCC cache in secure processor chip");
+        m_prot_fetches[i]
+            .name(pName + csprintf(".networkinterrupts_%i.prot_fetches", i))
+            .desc("Number of protection table lines read on BCC misses");
+        m_prot_fetch_merged[i]
+            .name(pName + csprintf(".networkinterrupts_%i.prot_fetch_merged", i))
+            .desc("Number of BCC misses merged onto a pending line read");
+
+        m_walk_queue_len.push_back(new Stats::Histogram());
+        m_walk_queue_len[i]->init(8)
+            .name(pName + csprintf(".networkinterrupts_%i.walk_queue_len", i))
+            .desc("Translations waiting for the host walker, sampled per cycle")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+        m_walk_queue_latency.push_back(new Stats::Histogram());
+        m_walk_queue_latency[i]->init(10)
+            .name(pName + csprintf(".networkinterrupts_%i.walk_queue_latency", i))
+            .desc("Cycles translations wait for the host walker")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+        m_walk_service_latency.push_back(new Stats::Histogram());
+        m_walk_service_latency[i]->init(10)
+            .name(pName + csprintf(".networkinterrupts_%i.walk_service_latency", i))
+            .desc("Cycles spent in host pagetable walks")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+        m_bcc_hit_latency.push_back(new Stats::Histogram());
+        m_bcc_hit_latency[i]->init(10)
+            .name(pName + csprintf(".networkinterrupts_%i.bcc_hit_latency", i))
+            .desc("Cycles to verify a translation that hits in the BCC")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+        m_bcc_miss_latency.push_back(new Stats::Histogram());
+        m_bcc_miss_latency[i]->init(10)
+            .name(pName + csprintf(".networkinterrupts_%i.bcc_miss_latency", i))
+            .desc("Cycles to verify a translation that misses in the BCC")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
              
     }
 
@@ -314,6 +348,9 @@ Profiler::regStats(const std::string &pName)
     m_td_tlb_misses
         .name(pName + ".taskdistributor.tlb_misses")
         .desc("");
+    m_td_tlb_mshrhits
+        .name(pName + ".taskdistributor.tlb_mshrhits")
+        .desc("Number of TD TLB misses merged into an outstanding walk");
     m_td_tlb_accesses
         .name(pName + ".taskdistributor.tlb_accesses")
         .desc("");
@@ -321,6 +358,59 @@ Profiler::regStats(const std::string &pName)
         .name(pName + ".taskdistributor.tlb_BCCMshrhits")
         .desc("");
 
+    // td translation prefetch stats
+    m_td_prefetch_issued
+        .name(pName + ".taskdistributor.prefetch_issued")
+        .desc("Number of translation prefetches sent to the host");
+    m_td_prefetch_useful
+        .name(pName + ".taskdistributor.prefetch_useful")
+        .desc("Number of CFU misses served from a completed prefetch");
+    m_td_prefetch_late
+        .name(pName + ".taskdistributor.prefetch_late")
+        .desc("Number of CFU misses merged into an in-flight prefetch");
+    m_td_prefetch_useless
+        .name(pName + ".taskdistributor.prefetch_useless")
+        .desc("Number of prefetched translations never used");
+    m_td_prefetch_verifies
+        .name(pName + ".taskdistributor.prefetch_verifies")
+        .desc("Number of verifications issued for prefetched translations");
+    m_td_warmup_pages
+        .name(pName + ".taskdistributor.warmup_pages")
+        .desc("Number of translations installed by the functional warm-up");
+    m_td_warmup_core_moved
+        .name(pName + ".taskdistributor.warmup_core_moved")
+        .desc("Number of verifications sent to an NI other than the one the warm-up filled");
+
+    // td per-tenant scheduling stats, one entry per process in arrival order
+    m_td_tenant_programs
+        .init(TD_MAX_TENANTS)
+        .name(pName + ".taskdistributor.tenant_programs")
+        .desc("Number of programs started per tenant");
+    m_td_tenant_program_wait
+        .init(TD_MAX_TENANTS)
+        .name(pName + ".taskdistributor.tenant_program_wait")
+        .desc("Cycles from program submission to start per tenant");
+    m_td_tenant_jobs
+        .init(TD_MAX_TENANTS)
+        .name(pName + ".taskdistributor.tenant_jobs")
+        .desc("Number of jobs dispatched per tenant");
+    m_td_tenant_job_wait
+        .init(TD_MAX_TENANTS)
+        .name(pName + ".taskdistributor.tenant_job_wait")
+        .desc("Cycles jobs spent queued before dispatch per tenant");
+
+    // td round trip of translations forwarded to the core
+    m_td_walk_latency
+        .init(10)
+        .name(pName + ".taskdistributor.walk_latency")
+        .desc("Cycles from forwarding a CFU TLB miss to the core's reply")
+        .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+    m_td_verify_latency
+        .init(10)
+        .name(pName + ".taskdistributor.verify_latency")
+        .desc("Cycles from forwarding a verification to the core's reply")
+        .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+
     // lcacc tlb stats
     uint32_t numAcc = RubySystem::numberOfAccelerators() *
         RubySystem::numberOfAccInstances();
@@ -330,6 +420,13 @@ Profiler::regStats(const std::string &pName)
     m_lcacc_tlb_accesses.resize(numAcc);
     m_lcacc_tlb_flush.resize(numAcc);
     m_lcacc_tlbCycles.resize(numAcc);
+    m_lcacc_prefetch_issued.resize(numAcc);
+    m_lcacc_prefetch_useful.resize(numAcc);
+    m_lcacc_prefetch_late.resize(numAcc);
+    m_lcacc_prefetch_useless.resize(numAcc);
+    m_lcacc_prefetch_verified.resize(numAcc);
+    m_lcacc_data_prefetches.resize(numAcc);
+    m_lcacc_data_prefetches_merged.resize(numAcc);
     
     for (int i = 0; i < numAcc; i++) {
         m_lcacc_tlb_hits[i]
@@ -351,6 +448,43 @@ Profiler::regStats(const std::string &pName)
         m_lcacc_tlbCycles[i]
             .name(pName + csprintf(".lcacc_%i.tlbCycles", i))
             .desc("Number of cycles LCAcc has spent waiting for tlb");
+
+        // accuracy = useful / issued, coverage = useful / (useful +
+        // tlb_misses), timeliness = useful / (useful + late)
+        m_lcacc_prefetch_issued[i]
+            .name(pName + csprintf(".lcacc_%i.prefetch_issued", i))
+            .desc("Number of translation prefetches issued");
+        m_lcacc_prefetch_useful[i]
+            .name(pName + csprintf(".lcacc_%i.prefetch_useful", i))
+            .desc("Number of prefetched pages hit by a demand access");
+        m_lcacc_prefetch_late[i]
+            .name(pName + csprintf(".lcacc_%i.prefetch_late", i))
+            .desc("Number of demand misses waiting on a prefetch walk");
+        m_lcacc_prefetch_useless[i]
+            .name(pName + csprintf(".lcacc_%i.prefetch_useless", i))
+            .desc("Number of prefetched pages evicted or flushed unused");
+        m_lcacc_prefetch_verified[i]
+            .name(pName + csprintf(".lcacc_%i.prefetch_verified", i))
+            .desc("Number of prefetched translations verified ahead");
+        m_lcacc_data_prefetches[i]
+            .name(pName + csprintf(".lcacc_%i.data_prefetches", i))
+            .desc("Number of data blocks prefetched by the DMA engine");
+        m_lcacc_data_prefetches_merged[i]
+            .name(pName + csprintf(".lcacc_%i.data_prefetches_merged", i))
+            .desc("Number of demand reads merged into a data prefetch");
+
+
+        // end to end translation latency as seen by the accelerator
+        m_lcacc_verify_latency.push_back(new Stats::Histogram());
+        m_lcacc_verify_latency[i]->init(10)
+            .name(pName + csprintf(".lcacc_%i.verify_latency", i))
+            .desc("Cycles from a TLB hit to its MAC verification")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+        m_lcacc_miss_latency.push_back(new Stats::Histogram());
+        m_lcacc_miss_latency[i]->init(10)
+            .name(pName + csprintf(".lcacc_%i.miss_latency", i))
+            .desc("Cycles from a TLB miss to its translation")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
     }
 
 #ifdef SIM_VISUAL_TRACE
@@ -511,20 +645,47 @@ Profiler::collateStats()
         m_host_pagetable_walk_time[i] = g_network_interrupts[i]->getHostPTWalkTime() ;
         m_bcc_access[i] = g_network_interrupts[i]->getBccaccess() ;
         m_bcc_hits[i] = g_network_interrupts[i]->getBcchits() ;
+        m_prot_fetches[i] = g_network_interrupts[i]->getProtFetches();
+        m_prot_fetch_merged[i] = g_network_interrupts[i]->getProtFetchMerged();
+        m_walk_queue_len[i]->add(g_network_interrupts[i]->getQueueLenHist());
+        m_walk_queue_latency[i]->add(g_network_interrupts[i]->getWalkQueueHist());
+        m_walk_service_latency[i]->add(g_network_interrupts[i]->getWalkServiceHist());
+        m_bcc_hit_latency[i]->add(g_network_interrupts[i]->getBccHitLatencyHist());
+        m_bcc_miss_latency[i]->add(g_network_interrupts[i]->getBccMissLatencyHist());
 
     }
 
     // td tlb stats
     uint64_t hits = TaskDistributor::SimicsInterface::manager.tdSet.at(0)->getTlbHits();
     uint64_t misses = TaskDistributor::SimicsInterface::manager.tdSet.at(0)->getTlbMisses();
-    uint64_t accesses = hits + misses;
+    uint64_t mshrhits = TaskDistributor::SimicsInterface::manager.tdSet.at(0)->getTlbMshrHits();
+    uint64_t accesses = hits + mshrhits + misses;
     uint64_t bccmshrhits = TaskDistributor::SimicsInterface::manager.tdSet.at(0)->getBCCMshrhits();
 
     m_td_tlb_hits = hits;
     m_td_tlb_misses = misses;
+    m_td_tlb_mshrhits = mshrhits;
     m_td_tlb_accesses = accesses;
     m_td_tlb_bCCMshrhits = bccmshrhits;
 
+    TD* td = TaskDistributor::SimicsInterface::manager.tdSet.at(0);
+    m_td_prefetch_issued = td->getPrefetchIssued();
+    m_td_prefetch_useful = td->getPrefetchUseful();
+    m_td_prefetch_late = td->getPrefetchLate();
+    m_td_prefetch_useless = td->getPrefetchUseless();
+    m_td_prefetch_verifies = td->getPrefetchVerifies();
+    m_td_warmup_pages = td->getWarmupPages();
+    m_td_warmup_core_moved = td->getWarmupCoreMoved();
+    m_td_walk_latency.add(td->getWalkLatencyHist());
+    m_td_verify_latency.add(td->getVerifyLatencyHist());
+
+    for (int i = 0; i < TD_MAX_TENANTS; i++) {
+        m_td_tenant_programs[i] = td->getTenantPrograms(i);
+        m_td_tenant_program_wait[i] = td->getTenantProgramWait(i);
+        m_td_tenant_jobs[i] = td->getTenantJobs(i);
+        m_td_tenant_job_wait[i] = td->getTenantJobWait(i);
+    }
+
     // lcacc tlb stats
     uint32_t numAcc = LCAcc::SimicsInterface::manager.deviceSet.size();
 
@@ -541,6 +702,17 @@ Profiler::collateStats()
         m_lcacc_bccmshrhits[i]  = bccmshrhits;
         m_lcacc_tlb_flush[i] = LCAcc::SimicsInterface::manager.deviceSet.at(i)->getDMA()->getTlbFlush();
         m_lcacc_tlbCycles[i] = LCAcc::SimicsInterface::manager.deviceSet.at(i)->getDMA()->getTlbCycles();
+
+        LCAcc::DMAController* dma = LCAcc::SimicsInterface::manager.deviceSet.at(i)->getDMA();
+        m_lcacc_prefetch_issued[i] = dma->getPrefetchIssued();
+        m_lcacc_prefetch_useful[i] = dma->getPrefetchUseful();
+        m_lcacc_prefetch_late[i] = dma->getPrefetchLate();
+        m_lcacc_prefetch_useless[i] = dma->getPrefetchUseless();
+        m_lcacc_prefetch_verified[i] = dma->getPrefetchVerified();
+        m_lcacc_data_prefetches[i] = dma->getDataPrefetches();
+        m_lcacc_data_prefetches_merged[i] = dma->getDataPrefetchesMerged();
+        m_lcacc_verify_latency[i]->add(dma->getVerifyLatencyHist());
+        m_lcacc_miss_latency[i]->add(dma->getMissLatencyHist());
     }
 #endif
 }
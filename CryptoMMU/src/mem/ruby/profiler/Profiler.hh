@@ -169,17 +169,46 @@ class Profiler : public SimObject
     std::vector<Stats::Scalar> m_lcacc_tlb_flush;
     std::vector<Stats::Scalar> m_lcacc_tlbCycles;
     std::vector<Stats::Scalar> m_lcacc_bccmshrhits;
+    std::vector<Stats::Scalar> m_lcacc_prefetch_issued;
+    std::vector<Stats::Scalar> m_lcacc_prefetch_useful;
+    std::vector<Stats::Scalar> m_lcacc_prefetch_late;
+    std::vector<Stats::Scalar> m_lcacc_prefetch_useless;
+    std::vector<Stats::Scalar> m_lcacc_prefetch_verified;
+    std::vector<Stats::Scalar> m_lcacc_data_prefetches;
+    std::vector<Stats::Scalar> m_lcacc_data_prefetches_merged;
+    std::vector<Stats::Histogram *> m_lcacc_verify_latency;
+    std::vector<Stats::Histogram *> m_lcacc_miss_latency;
 
     Stats::Scalar m_td_tlb_hits;
     Stats::Scalar m_td_tlb_misses;
     Stats::Scalar m_td_tlb_mshrhits;
     Stats::Scalar m_td_tlb_accesses;
     Stats::Scalar m_td_tlb_bCCMshrhits;
+    Stats::Scalar m_td_prefetch_issued;
+    Stats::Scalar m_td_prefetch_useful;
+    Stats::Scalar m_td_prefetch_late;
+    Stats::Scalar m_td_prefetch_useless;
+    Stats::Scalar m_td_prefetch_verifies;
+    Stats::Scalar m_td_warmup_pages;
+    Stats::Scalar m_td_warmup_core_moved;
+    Stats::Vector m_td_tenant_programs;
+    Stats::Vector m_td_tenant_program_wait;
+    Stats::Vector m_td_tenant_jobs;
+    Stats::Vector m_td_tenant_job_wait;
+    Stats::Histogram m_td_walk_latency;
+    Stats::Histogram m_td_verify_latency;
 
     std::vector<Stats::Scalar> m_host_pagetable_walks;
     std::vector<Stats::Scalar> m_bcc_access;
     std::vector<Stats::Scalar> m_bcc_hits;
+    std::vector<Stats::Scalar> m_prot_fetches;
+    std::vector<Stats::Scalar> m_prot_fetch_merged;
     std::vector<Stats::Scalar> m_host_pagetable_walk_time;
+    std::vector<Stats::Histogram *> m_walk_queue_len;
+    std::vector<Stats::Histogram *> m_walk_queue_latency;
+    std::vector<Stats::Histogram *> m_walk_service_latency;
+    std::vector<Stats::Histogram *> m_bcc_hit_latency;
+    std::vector<Stats::Histogram *> m_bcc_miss_latency;
 
 #ifdef SIM_VISUAL_TRACE
   uint64_t m_L1Cache_read;
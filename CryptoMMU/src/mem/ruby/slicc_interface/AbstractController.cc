@@ -27,6 +27,7 @@
  */
 
 #include "mem/protocol/MemoryMsg.hh"
+#include "mem/requestor_class.hh"
 #include "mem/ruby/slicc_interface/AbstractController.hh"
 #include "mem/ruby/system/Sequencer.hh"
 #include "mem/ruby/system/System.hh"
@@ -85,6 +86,34 @@ AbstractController::regStats()
         .name(name() + ".fully_busy_cycles")
         .desc("cycles for which number of transistions == max transitions")
         .flags(Stats::nozero);
+
+    m_requestorBytes
+        .init(NumReqClasses)
+        .name(name() + ".requestor_bytes")
+        .desc("bytes of data moved for the requests served, per requestor "
+              "class")
+        .flags(Stats::total | Stats::nozero);
+
+    for (int i = 0; i < NumReqClasses; i++) {
+        m_requestorBytes.subname(i, requestorClassName(i));
+
+        m_requestorQueueing.push_back(new Stats::Histogram());
+        m_requestorQueueing[i]
+            ->init(10)
+            .name(csprintf("%s.requestor_queueing.%s", name(),
+                           requestorClassName(i)))
+            .desc("cycles requests queued in message buffers before being "
+                  "served")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+
+        m_requestorLatency.push_back(new Stats::Histogram());
+        m_requestorLatency[i]
+            ->init(10)
+            .name(csprintf("%s.requestor_latency.%s", name(),
+                           requestorClassName(i)))
+            .desc("cycles taken to serve requests that go further down")
+            .flags(Stats::nozero | Stats::pdf | Stats::oneline);
+    }
 }
 
 void
@@ -95,6 +124,23 @@ AbstractController::profileMsgDelay(uint32_t virtualNetwork, Cycles delay)
     m_delayVCHistogram[virtualNetwork]->sample(delay);
 }
 
+void
+AbstractController::profileRequestorAccess(int req_class, bool data,
+                                           Cycles queueing)
+{
+    assert(req_class >= 0 && req_class < NumReqClasses);
+    if (data)
+        m_requestorBytes[req_class] += RubySystem::getBlockSizeBytes();
+    m_requestorQueueing[req_class]->sample(queueing);
+}
+
+void
+AbstractController::profileRequestorLatency(int req_class, Cycles latency)
+{
+    assert(req_class >= 0 && req_class < NumReqClasses);
+    m_requestorLatency[req_class]->sample(latency);
+}
+
 void
 AbstractController::stallBuffer(MessageBuffer* buf, Address addr)
 {
@@ -205,16 +251,26 @@ AbstractController::getMasterPort(const std::string &if_name,
 void
 AbstractController::queueMemoryRead(const MachineID &id, Address addr,
                                     Cycles latency)
+{
+    queueMemoryReadAs(id, addr, latency, ReqClassCPU, 0);
+}
+
+void
+AbstractController::queueMemoryReadAs(const MachineID &id, Address addr,
+                                      Cycles latency, int req_class,
+                                      int device_id)
 {
     RequestPtr req = new Request(addr.getAddress(),
                                  RubySystem::getBlockSizeBytes(), 0,
                                  m_masterId);
+    req->setRequestorClass((RequestorClass)req_class);
+    req->SetdeviceID(device_id);
 
     PacketPtr pkt = Packet::createRead(req);
     uint8_t *newData = new uint8_t[RubySystem::getBlockSizeBytes()];
     pkt->dataDynamic(newData);
 
-    SenderState *s = new SenderState(id);
+    SenderState *s = new SenderState(id, req_class, curCycle());
     pkt->pushSenderState(s);
 
     memoryPort.schedTimingReq(pkt, clockEdge(latency));
@@ -223,19 +279,21 @@ AbstractController::queueMemoryRead(const MachineID &id, Address addr,
 void
 AbstractController::queueMemoryReadBypass(const MachineID &id, Address addr,
                                           Cycles latency,
-                                          const MachineID &bypassRequestor)
+                                          const MachineID &bypassRequestor,
+                                          int req_class)
 {
     RequestPtr req = new Request(addr.getAddress(),
                                  RubySystem::getBlockSizeBytes(), 0,
                                  m_masterId);
 
     req->setFlags(Request::BYPASS_CACHE);
+    req->setRequestorClass((RequestorClass)req_class);
 
     PacketPtr pkt = Packet::createRead(req);
     uint8_t *newData = new uint8_t[RubySystem::getBlockSizeBytes()];
     pkt->dataDynamic(newData);
 
-    SenderState *s = new SenderState(id);
+    SenderState *s = new SenderState(id, req_class, curCycle());
     pkt->pushSenderState(s);
     pkt->bypassRequestor = bypassRequestor;
 
@@ -245,10 +303,19 @@ AbstractController::queueMemoryReadBypass(const MachineID &id, Address addr,
 void
 AbstractController::queueMemoryWrite(const MachineID &id, Address addr,
                                      Cycles latency, const DataBlock &block)
+{
+    queueMemoryWriteAs(id, addr, latency, block, ReqClassCPU);
+}
+
+void
+AbstractController::queueMemoryWriteAs(const MachineID &id, Address addr,
+                                       Cycles latency, const DataBlock &block,
+                                       int req_class)
 {
     RequestPtr req = new Request(addr.getAddress(),
                                  RubySystem::getBlockSizeBytes(), 0,
                                  m_masterId);
+    req->setRequestorClass((RequestorClass)req_class);
 
     PacketPtr pkt = Packet::createWrite(req);
     uint8_t *newData = new uint8_t[RubySystem::getBlockSizeBytes()];
@@ -256,7 +323,7 @@ AbstractController::queueMemoryWrite(const MachineID &id, Address addr,
     memcpy(newData, block.getData(0, RubySystem::getBlockSizeBytes()),
            RubySystem::getBlockSizeBytes());
 
-    SenderState *s = new SenderState(id);
+    SenderState *s = new SenderState(id, req_class, curCycle());
     pkt->pushSenderState(s);
 
     // Create a block and copy data from the block.
@@ -267,17 +334,27 @@ void
 AbstractController::queueMemoryWritePartial(const MachineID &id, Address addr,
                                             Cycles latency,
                                             const DataBlock &block, int size)
+{
+    queueMemoryWritePartialAs(id, addr, latency, block, size, ReqClassCPU);
+}
+
+void
+AbstractController::queueMemoryWritePartialAs(const MachineID &id,
+                                              Address addr, Cycles latency,
+                                              const DataBlock &block, int size,
+                                              int req_class)
 {
     RequestPtr req = new Request(addr.getAddress(),
                                  RubySystem::getBlockSizeBytes(), 0,
                                  m_masterId);
+    req->setRequestorClass((RequestorClass)req_class);
 
     PacketPtr pkt = Packet::createWrite(req);
     uint8_t *newData = new uint8_t[size];
     pkt->dataDynamic(newData);
     memcpy(newData, block.getData(addr.getOffset(), size), size);
 
-    SenderState *s = new SenderState(id);
+    SenderState *s = new SenderState(id, req_class, curCycle());
     pkt->pushSenderState(s);
 
     // Create a block and copy data from the block.
@@ -319,6 +396,9 @@ AbstractController::recvTimingResp(PacketPtr pkt)
 
     SenderState *s = dynamic_cast<SenderState *>(pkt->senderState);
     (*msg).m_OriginalRequestorMachId = s->id;
+
+    if (pkt->isRead())
+        profileRequestorLatency(s->reqClass, curCycle() - s->issueTime);
     delete s;
 
     if (pkt->isRead()) {
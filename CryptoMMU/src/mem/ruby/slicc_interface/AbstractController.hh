@@ -107,11 +107,22 @@ class AbstractController : public MemObject, public Consumer
 
     void queueMemoryRead(const MachineID &id, Address addr, Cycles latency);
     void queueMemoryReadBypass(const MachineID &id, Address addr,
-                               Cycles latency, const MachineID &bypassRequestor);
+                               Cycles latency, const MachineID &bypassRequestor,
+                               int req_class);
     void queueMemoryWrite(const MachineID &id, Address addr, Cycles latency,
                           const DataBlock &block);
+    //! As queueMemoryRead/Write, tagging the memory request with the
+    //! requestor class (see mem/requestor_class.hh) of the traffic, and
+    //! a read with the device it is made for (0 for the host)
+    void queueMemoryReadAs(const MachineID &id, Address addr, Cycles latency,
+                           int req_class, int device_id);
+    void queueMemoryWriteAs(const MachineID &id, Address addr, Cycles latency,
+                            const DataBlock &block, int req_class);
     void queueMemoryWritePartial(const MachineID &id, Address addr, Cycles latency,
                                  const DataBlock &block, int size);
+    void queueMemoryWritePartialAs(const MachineID &id, Address addr,
+                                   Cycles latency, const DataBlock &block,
+                                   int size, int req_class);
     void recvTimingResp(PacketPtr pkt);
 
   public:
@@ -126,6 +137,11 @@ class AbstractController : public MemObject, public Consumer
     void profileRequest(const std::string &request);
     //! Profiles the delay associated with messages.
     void profileMsgDelay(uint32_t virtualNetwork, Cycles delay);
+    //! Profiles a request of the given requestor class served here: the
+    //! line of data it moves, if any, and the cycles it queued for
+    void profileRequestorAccess(int req_class, bool data, Cycles queueing);
+    //! Profiles the cycles taken to serve a request of the given class
+    void profileRequestorLatency(int req_class, Cycles latency);
 
     void stallBuffer(MessageBuffer* buf, Address addr);
     void wakeUpBuffers(Address addr);
@@ -164,6 +180,12 @@ class AbstractController : public MemObject, public Consumer
     Stats::Histogram m_delayHistogram;
     std::vector<Stats::Histogram *> m_delayVCHistogram;
 
+    //! Bytes moved, queueing and service latency of the requests this
+    //! controller serves, per requestor class
+    Stats::Vector m_requestorBytes;
+    std::vector<Stats::Histogram *> m_requestorQueueing;
+    std::vector<Stats::Histogram *> m_requestorLatency;
+
     //! Callback class used for collating statistics from all the
     //! controller of this type.
     class StatsCallback : public Callback
@@ -212,8 +234,12 @@ class AbstractController : public MemObject, public Consumer
     {
         // Id of the machine from which the request originated.
         MachineID id;
+        // Requestor class of the request and when it was sent.
+        int reqClass;
+        Cycles issueTime;
 
-        SenderState(MachineID _id) : id(_id)
+        SenderState(MachineID _id, int req_class, Cycles issue_time)
+            : id(_id), reqClass(req_class), issueTime(issue_time)
         {}
     };
 };
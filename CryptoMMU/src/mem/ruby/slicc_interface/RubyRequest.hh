@@ -35,6 +35,7 @@
 #include "mem/protocol/PrefetchBit.hh"
 #include "mem/protocol/RubyAccessMode.hh"
 #include "mem/protocol/RubyRequestType.hh"
+#include "mem/requestor_class.hh"
 #include "mem/ruby/common/Address.hh"
 
 class RubyRequest : public Message
@@ -51,6 +52,8 @@ class RubyRequest : public Message
     PacketPtr pkt;
     unsigned m_contextId;
     bool m_BypassCache;
+    int m_ReqClass;
+    int m_DeviceId;
 
     RubyRequest(Tick curTime, uint64_t _paddr, uint8_t* _data, int _len,
         uint64_t _pc, RubyRequestType _type, RubyAccessMode _access_mode,
@@ -70,9 +73,12 @@ class RubyRequest : public Message
       m_LineAddress = m_PhysicalAddress;
       m_LineAddress.makeLineAddress();
       m_BypassCache = false;
+      m_ReqClass = ReqClassCPU;
+      m_DeviceId = 0;
     }
 
-    RubyRequest(Tick curTime) : Message(curTime) {}
+    RubyRequest(Tick curTime)
+        : Message(curTime), m_ReqClass(ReqClassCPU), m_DeviceId(0) {}
     MsgPtr clone() const
     { return std::shared_ptr<Message>(new RubyRequest(*this)); }
 
@@ -40,6 +40,10 @@ class RubyCache(SimObject):
     replacement_policy = Param.String("PSEUDO_LRU", "");
     start_index_bit = Param.Int(6, "index start, default 6 for 64-byte line");
     is_icache = Param.Bool(False, "is instruction only cache");
+    metadata_ways = Param.Int(0,
+        "ways per set only protection table lines use, 0 to share all ways")
+    tag_index = Param.String("hash",
+        "tag lookup: hash (one hash map) or flat (a tag array per set)")
 
     dataArrayBanks = Param.Int(1, "Number of banks for the data array")
     tagArrayBanks = Param.Int(1, "Number of banks for the tag array")
@@ -32,6 +32,7 @@
 #include "debug/RubyResourceStalls.hh"
 #include "debug/RubyStats.hh"
 #include "mem/protocol/AccessPermission.hh"
+#include "mem/protection_table.hh"
 #include "mem/ruby/structures/CacheMemory.hh"
 #include "mem/ruby/system/System.hh"
 
@@ -63,6 +64,10 @@ CacheMemory::CacheMemory(const Params *p)
     m_start_index_bit = p->start_index_bit;
     m_is_instruction_only_cache = p->is_icache;
     m_resource_stalls = p->resourceStalls;
+    m_metadata_ways = p->metadata_ways;
+
+    if (!CacheTagIndex::parseKind(p->tag_index, m_tag_index_kind))
+        fatal("%s: unknown tag_index %s\n", name(), p->tag_index);
 }
 
 void
@@ -84,6 +89,12 @@ CacheMemory::init()
     else
         assert(false);
 
+    if (m_metadata_ways < 0 || m_metadata_ways >= m_cache_assoc)
+        fatal("%s: metadata_ways (%d) must leave data ways in a %d way "
+              "cache\n", name(), m_metadata_ways, m_cache_assoc);
+
+    m_tag_index.init(m_tag_index_kind, m_cache_num_sets, m_cache_assoc);
+
     m_cache.resize(m_cache_num_sets);
     for (int i = 0; i < m_cache_num_sets; i++) {
         m_cache[i].resize(m_cache_assoc);
@@ -113,6 +124,28 @@ CacheMemory::addressToCacheSet(const Address& address) const
                              m_start_index_bit + m_cache_num_set_bits - 1);
 }
 
+CacheMemory::LineClass
+CacheMemory::lineClass(const Address& address) const
+{
+    return ProtectionTableLayout::contains(address.getAddress()) ?
+        MetadataLine : DataLine;
+}
+
+void
+CacheMemory::wayRange(const Address& address, int& first, int& end) const
+{
+    if (m_metadata_ways == 0) {
+        first = 0;
+        end = m_cache_assoc;
+    } else if (lineClass(address) == MetadataLine) {
+        first = 0;
+        end = m_metadata_ways;
+    } else {
+        first = m_metadata_ways;
+        end = m_cache_assoc;
+    }
+}
+
 // Given a cache index: returns the index of the tag in a set.
 // returns -1 if the tag is not found.
 int
@@ -120,11 +153,11 @@ CacheMemory::findTagInSet(int64 cacheSet, const Address& tag) const
 {
     assert(tag == line_address(tag));
     // search the set for the tags
-    m5::hash_map<Address, int>::const_iterator it = m_tag_index.find(tag);
-    if (it != m_tag_index.end())
-        if (m_cache[cacheSet][it->second]->m_Permission !=
+    int way = m_tag_index.find(cacheSet, tag.getAddress());
+    if (way != -1)
+        if (m_cache[cacheSet][way]->m_Permission !=
             AccessPermission_NotPresent)
-            return it->second;
+            return way;
     return -1; // Not found
 }
 
@@ -136,10 +169,7 @@ CacheMemory::findTagInSetIgnorePermissions(int64 cacheSet,
 {
     assert(tag == line_address(tag));
     // search the set for the tags
-    m5::hash_map<Address, int>::const_iterator it = m_tag_index.find(tag);
-    if (it != m_tag_index.end())
-        return it->second;
-    return -1; // Not found
+    return m_tag_index.find(cacheSet, tag.getAddress());
 }
 
 bool
@@ -221,8 +251,10 @@ CacheMemory::cacheAvail(const Address& address) const
     assert(address == line_address(address));
 
     int64 cacheSet = addressToCacheSet(address);
+    int first, end;
+    wayRange(address, first, end);
 
-    for (int i = 0; i < m_cache_assoc; i++) {
+    for (int i = first; i < end; i++) {
         AbstractCacheEntry* entry = m_cache[cacheSet][i];
         if (entry != NULL) {
             if (entry->m_Address == address ||
@@ -248,15 +280,22 @@ CacheMemory::allocate(const Address& address, AbstractCacheEntry* entry)
     // Find the first open slot
     int64 cacheSet = addressToCacheSet(address);
     std::vector<AbstractCacheEntry*> &set = m_cache[cacheSet];
-    for (int i = 0; i < m_cache_assoc; i++) {
+    int first, end;
+    wayRange(address, first, end);
+    for (int i = first; i < end; i++) {
         if (!set[i] || set[i]->m_Permission == AccessPermission_NotPresent) {
+            if (set[i]) {
+                m_tag_index.erase(cacheSet, i, set[i]->m_Address.getAddress());
+                m_class_lines[lineClass(set[i]->m_Address)]--;
+            }
             set[i] = entry;  // Init entry
             set[i]->m_Address = address;
             set[i]->m_Permission = AccessPermission_Invalid;
             //DPRINTF(RubyCache, "Allocate clearing lock for addr: %x\n",
             //        address);
             set[i]->m_locked = -1;
-            m_tag_index[address] = i;
+            m_tag_index.insert(cacheSet, i, address.getAddress());
+            m_class_lines[lineClass(address)]++;
 
             m_replacementPolicy_ptr->touch(cacheSet, i, curTick());
 
@@ -277,7 +316,8 @@ CacheMemory::deallocate(const Address& address)
     if (loc != -1) {
         delete m_cache[cacheSet][loc];
         m_cache[cacheSet][loc] = NULL;
-        m_tag_index.erase(address);
+        m_tag_index.erase(cacheSet, loc, address.getAddress());
+        m_class_lines[lineClass(address)]--;
         //eviction++;
         //std::cout << "eviction from Cache" << eviction << std::endl;
     }
@@ -291,8 +331,22 @@ CacheMemory::cacheProbe(const Address& address) const
     assert(!cacheAvail(address));
 
     int64 cacheSet = addressToCacheSet(address);
-    return m_cache[cacheSet][m_replacementPolicy_ptr->getVictim(cacheSet)]->
-        m_Address;
+    int victim = m_replacementPolicy_ptr->getVictim(cacheSet);
+    int first, end;
+    wayRange(address, first, end);
+
+    if (victim < first || victim >= end) {
+        // the policy picked a way of the other class, take the least
+        // recently used way of this one instead
+        victim = first;
+        for (int i = first + 1; i < end; i++) {
+            if (m_replacementPolicy_ptr->getLastAccess(cacheSet, i) <
+                m_replacementPolicy_ptr->getLastAccess(cacheSet, victim))
+                victim = i;
+        }
+    }
+
+    return m_cache[cacheSet][victim]->m_Address;
 }
 
 // looks an address up in the cache
@@ -513,6 +567,39 @@ CacheMemory::regStats()
         .desc("number of stalls caused by data array")
         .flags(Stats::nozero)
         ;
+
+    m_class_lines
+        .init(NumLineClasses)
+        .name(name() + ".class_lines")
+        .desc("lines held per class")
+        .subname(DataLine, "data")
+        .subname(MetadataLine, "metadata")
+        ;
+
+    m_class_hits
+        .init(NumLineClasses)
+        .name(name() + ".class_hits")
+        .desc("demand hits per line class")
+        .subname(DataLine, "data")
+        .subname(MetadataLine, "metadata")
+        ;
+
+    m_class_misses
+        .init(NumLineClasses)
+        .name(name() + ".class_misses")
+        .desc("demand misses per line class")
+        .subname(DataLine, "data")
+        .subname(MetadataLine, "metadata")
+        ;
+}
+
+void
+CacheMemory::profileDemandAccess(const Address& address, bool hit)
+{
+    if (hit)
+        m_class_hits[lineClass(address)]++;
+    else
+        m_class_misses[lineClass(address)]++;
 }
 
 void
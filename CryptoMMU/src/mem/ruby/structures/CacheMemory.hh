@@ -32,7 +32,6 @@
 #include <string>
 #include <vector>
 
-#include "base/hashmap.hh"
 #include "base/statistics.hh"
 #include "mem/protocol/CacheRequestType.hh"
 #include "mem/protocol/CacheResourceType.hh"
@@ -41,6 +40,7 @@
 #include "mem/ruby/slicc_interface/AbstractCacheEntry.hh"
 #include "mem/ruby/slicc_interface/RubySlicc_ComponentMapping.hh"
 #include "mem/ruby/structures/BankedArray.hh"
+#include "mem/ruby/structures/CacheTagIndex.hh"
 #include "mem/ruby/structures/LRUPolicy.hh"
 #include "mem/ruby/structures/PseudoLRUPolicy.hh"
 #include "mem/ruby/system/CacheRecorder.hh"
@@ -111,6 +111,8 @@ class CacheMemory : public SimObject
     void regStats();
     bool checkResourceAvailable(CacheResourceType res, Address addr);
     void recordRequestType(CacheRequestType requestType);
+    // count a demand hit or miss against the class of the line
+    void profileDemandAccess(const Address& address, bool hit);
 
   public:
     Stats::Scalar m_demand_hits;
@@ -131,7 +133,22 @@ class CacheMemory : public SimObject
     Stats::Scalar numTagArrayStalls;
     Stats::Scalar numDataArrayStalls;
 
+    // per line class, see LineClass
+    Stats::Vector m_class_lines;
+    Stats::Vector m_class_hits;
+    Stats::Vector m_class_misses;
+
   private:
+    // Protection table lines are metadata, everything else is data.
+    // With metadata ways set, metadata lines live in ways
+    // [0, m_metadata_ways) of each set and data lines in the rest, so
+    // streaming data cannot evict them.
+    enum LineClass { DataLine, MetadataLine, NumLineClasses };
+
+    LineClass lineClass(const Address& address) const;
+    // the ways of a set a line of this address may use
+    void wayRange(const Address& address, int& first, int& end) const;
+
     // convert a Address to its location in the cache
     int64 addressToCacheSet(const Address& address) const;
 
@@ -153,7 +170,8 @@ class CacheMemory : public SimObject
 
     // The first index is the # of cache lines.
     // The second index is the the amount associativity.
-    m5::hash_map<Address, int> m_tag_index;
+    CacheTagIndex::Kind m_tag_index_kind;
+    CacheTagIndex m_tag_index;
     std::vector<std::vector<AbstractCacheEntry*> > m_cache;
 
     AbstractReplacementPolicy *m_replacementPolicy_ptr;
@@ -168,6 +186,7 @@ class CacheMemory : public SimObject
     int m_cache_assoc;
     int m_start_index_bit;
     bool m_resource_stalls;
+    int m_metadata_ways;
 };
 
 std::ostream& operator<<(std::ostream& out, const CacheMemory& obj);
@@ -0,0 +1,125 @@
+/*
+ * Tag index of a Ruby CacheMemory: maps a line address to the way of its
+ * set that holds it.
+ *
+ * Two layouts give the same answers. Hash keeps one hash map for the whole
+ * cache. Flat keeps the tags of each set in a contiguous array and
+ * compares the assoc tags of the set, which avoids hashing and the pointer
+ * chasing of the map on every lookup. An address maps to at most one way:
+ * inserting it in a way drops it from any other way of the set, as the
+ * hash map does by overwriting its entry.
+ *
+ * Header only so that src/unittest/tagindextime.cc can time it without
+ * the rest of Ruby.
+ */
+
+#ifndef __MEM_RUBY_STRUCTURES_CACHETAGINDEX_HH__
+#define __MEM_RUBY_STRUCTURES_CACHETAGINDEX_HH__
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "base/hashmap.hh"
+#include "base/types.hh"
+
+class CacheTagIndex
+{
+  public:
+    enum Kind { Hash, Flat };
+
+    CacheTagIndex() : m_kind(Hash), m_assoc(0) {}
+
+    /** Parse a tag_index parameter, returns false for an unknown name. */
+    static bool
+    parseKind(const std::string& name, Kind& kind)
+    {
+        if (name == "hash")
+            kind = Hash;
+        else if (name == "flat")
+            kind = Flat;
+        else
+            return false;
+
+        return true;
+    }
+
+    void
+    init(Kind kind, int num_sets, int assoc)
+    {
+        m_kind = kind;
+        m_assoc = assoc;
+        m_hash.clear();
+        m_tags.clear();
+
+        if (m_kind == Flat)
+            m_tags.resize((size_t)num_sets * assoc, invalidTag());
+    }
+
+    /** Way of set holding tag, -1 if there is none. */
+    int
+    find(int64_t set, Addr tag) const
+    {
+        if (m_kind == Hash) {
+            m5::hash_map<Addr, int>::const_iterator it = m_hash.find(tag);
+            return it == m_hash.end() ? -1 : it->second;
+        }
+
+        const Addr *tags = &m_tags[set * m_assoc];
+
+        for (int way = 0; way < m_assoc; way++) {
+            if (tags[way] == tag)
+                return way;
+        }
+
+        return -1;
+    }
+
+    /** Record tag in way of set, the way's old tag must be erased first. */
+    void
+    insert(int64_t set, int way, Addr tag)
+    {
+        assert(tag != invalidTag());
+
+        if (m_kind == Hash) {
+            m_hash[tag] = way;
+            return;
+        }
+
+        Addr *tags = &m_tags[set * m_assoc];
+
+        for (int i = 0; i < m_assoc; i++) {
+            if (tags[i] == tag)
+                tags[i] = invalidTag();
+        }
+
+        tags[way] = tag;
+    }
+
+    /** Forget tag if way of set is where it is recorded. */
+    void
+    erase(int64_t set, int way, Addr tag)
+    {
+        if (m_kind == Hash) {
+            m5::hash_map<Addr, int>::iterator it = m_hash.find(tag);
+            if (it != m_hash.end() && it->second == way)
+                m_hash.erase(it);
+            return;
+        }
+
+        Addr &slot = m_tags[set * m_assoc + way];
+        if (slot == tag)
+            slot = invalidTag();
+    }
+
+  private:
+    // line addresses are block aligned, so this is never one
+    static Addr invalidTag() { return ~Addr(0); }
+
+    Kind m_kind;
+    int m_assoc;
+    m5::hash_map<Addr, int> m_hash;
+    std::vector<Addr> m_tags;
+};
+
+#endif // __MEM_RUBY_STRUCTURES_CACHETAGINDEX_HH__
@@ -0,0 +1,367 @@
+#include "mem/ruby/structures/MetadataCache.hh"
+
+#include <algorithm>
+
+#include "base/intmath.hh"
+#include "base/misc.hh"
+#include "debug/RubyMetadataCache.hh"
+#include "mem/protection_table.hh"
+#include "mem/ruby/system/System.hh"
+
+MetadataCache::DirSidePort::DirSidePort(const std::string& name,
+                                        MetadataCache *cache)
+    : QueuedSlavePort(name, cache, m_queue),
+      m_queue(*cache, *this), m_cache(cache)
+{
+}
+
+Tick
+MetadataCache::DirSidePort::recvAtomic(PacketPtr pkt)
+{
+    panic("MetadataCache only supports timing accesses\n");
+}
+
+void
+MetadataCache::DirSidePort::recvFunctional(PacketPtr pkt)
+{
+    m_cache->recvFunctional(pkt);
+}
+
+bool
+MetadataCache::DirSidePort::recvTimingReq(PacketPtr pkt)
+{
+    return m_cache->recvTimingReq(pkt);
+}
+
+AddrRangeList
+MetadataCache::DirSidePort::getAddrRanges() const
+{
+    return m_cache->m_mem_port.getAddrRanges();
+}
+
+MetadataCache::MemSidePort::MemSidePort(const std::string& name,
+                                        MetadataCache *cache)
+    : MasterPort(name, cache), m_cache(cache)
+{
+}
+
+bool
+MetadataCache::MemSidePort::recvTimingResp(PacketPtr pkt)
+{
+    m_cache->recvTimingResp(pkt);
+    return true;
+}
+
+void
+MetadataCache::MemSidePort::recvRetry()
+{
+    m_cache->trySendTiming();
+}
+
+void
+MetadataCache::MemSidePort::recvRangeChange()
+{
+    m_cache->m_dir_port.sendRangeChange();
+}
+
+MetadataCache::MetadataCache(const Params *p)
+    : MemObject(p),
+      m_dir_port(name() + ".slave", this),
+      m_mem_port(name() + ".master", this),
+      m_size(p->size), m_assoc(p->assoc), m_hit_latency(p->hit_latency),
+      m_queue_size(p->queue_size), m_num_devices(p->num_devices),
+      m_mmu_policies(p->mmu_policies), m_enabled(false), m_line_bytes(0),
+      m_sets(0), m_use_count(0), m_retry_req(false), m_send_event(this)
+{
+    if (m_assoc == 0)
+        fatal("%s: associativity must be at least 1\n", name());
+
+    if (m_queue_size == 0)
+        fatal("%s: the request queue needs at least one entry\n", name());
+}
+
+void
+MetadataCache::init()
+{
+    MemObject::init();
+
+    if (!m_dir_port.isConnected() || !m_mem_port.isConnected())
+        fatal("%s: both ports must be connected\n", name());
+
+    m_dir_port.sendRangeChange();
+
+    // the block size and MMU policy are only known once RubySystem exists
+    m_line_bytes = RubySystem::getBlockSizeBytes();
+    m_sets = m_size / (m_line_bytes * m_assoc);
+
+    if (m_sets == 0 || !isPowerOf2(m_sets))
+        fatal("%s: %d bytes in %d ways do not give a power of two number "
+              "of %d byte sets\n", name(), m_size, m_assoc, m_line_bytes);
+
+    m_lines.resize(m_sets * m_assoc);
+
+    m_enabled = m_mmu_policies.empty() ||
+        std::find(m_mmu_policies.begin(), m_mmu_policies.end(),
+                  RubySystem::getMMUPolicy()) != m_mmu_policies.end();
+
+    if (!m_enabled) {
+        inform("%s: disabled for MMU policy %s\n", name(),
+               RubySystem::getMMUPolicy());
+    }
+}
+
+BaseMasterPort&
+MetadataCache::getMasterPort(const std::string& if_name, PortID idx)
+{
+    if (if_name == "master") {
+        return m_mem_port;
+    } else {
+        return MemObject::getMasterPort(if_name, idx);
+    }
+}
+
+BaseSlavePort&
+MetadataCache::getSlavePort(const std::string& if_name, PortID idx)
+{
+    if (if_name == "slave") {
+        return m_dir_port;
+    } else {
+        return MemObject::getSlavePort(if_name, idx);
+    }
+}
+
+bool
+MetadataCache::caches(PacketPtr pkt) const
+{
+    return m_enabled && ProtectionTableLayout::contains(pkt->getAddr());
+}
+
+unsigned
+MetadataCache::deviceGroup(PacketPtr pkt) const
+{
+    uint64_t device_id = pkt->req->GetdeviceId();
+    return device_id < m_num_devices ? device_id : m_num_devices;
+}
+
+MetadataCache::Line *
+MetadataCache::lookup(Addr line_addr)
+{
+    Addr block = line_addr / m_line_bytes;
+    Line *set = &m_lines[(block & (m_sets - 1)) * m_assoc];
+
+    for (unsigned way = 0; way < m_assoc; way++) {
+        if (set[way].valid && set[way].tag == block)
+            return &set[way];
+    }
+
+    return NULL;
+}
+
+void
+MetadataCache::insert(Addr line_addr)
+{
+    Line *line = lookup(line_addr);
+
+    if (line == NULL) {
+        Addr block = line_addr / m_line_bytes;
+        Line *set = &m_lines[(block & (m_sets - 1)) * m_assoc];
+        line = &set[0];
+
+        for (unsigned way = 0; way < m_assoc && line->valid; way++) {
+            if (!set[way].valid || set[way].lastUse < line->lastUse)
+                line = &set[way];
+        }
+
+        line->tag = block;
+        line->valid = true;
+    }
+
+    line->lastUse = ++m_use_count;
+}
+
+bool
+MetadataCache::recvTimingReq(PacketPtr pkt)
+{
+    Addr line_addr = lineAddr(pkt->getAddr());
+    Line *line = NULL;
+
+    if (caches(pkt) && pkt->isRead())
+        line = lookup(line_addr);
+
+    // everything but a hit needs room in the request queue
+    if (line == NULL && m_req_queue.size() >= m_queue_size) {
+        DPRINTF(RubyMetadataCache, "queue full, retry %#x\n",
+                pkt->getAddr());
+        m_retries++;
+        m_retry_req = true;
+        return false;
+    }
+
+    if (!caches(pkt)) {
+        forward(pkt, curTick());
+        return true;
+    }
+
+    if (pkt->isWrite()) {
+        // write-through, memory keeps the only copy of the data
+        m_writes++;
+        insert(line_addr);
+        forward(pkt, curTick());
+        return true;
+    }
+
+    unsigned device = deviceGroup(pkt);
+
+    if (line == NULL) {
+        DPRINTF(RubyMetadataCache, "miss %#x device %d\n", line_addr,
+                pkt->req->GetdeviceId());
+        m_misses[device]++;
+        forward(pkt, clockEdge(m_hit_latency));
+        return true;
+    }
+
+    DPRINTF(RubyMetadataCache, "hit %#x device %d\n", line_addr,
+            pkt->req->GetdeviceId());
+    m_hits[device]++;
+    line->lastUse = ++m_use_count;
+
+    // writes still queued here are newer than memory
+    if (!checkQueuedRequests(pkt))
+        m_mem_port.sendFunctional(pkt);
+
+    if (!pkt->isResponse())
+        pkt->makeResponse();
+
+    m_dir_port.schedTimingResp(pkt, clockEdge(m_hit_latency));
+    return true;
+}
+
+void
+MetadataCache::forward(PacketPtr pkt, Tick when)
+{
+    // misses wait for the tag check, so the queue is in order of arrival
+    // rather than of when; a request never overtakes an older one
+    m_req_queue.push_back(DeferredPacket(pkt, when));
+
+    if (m_req_queue.size() == 1 && !m_send_event.scheduled())
+        schedule(m_send_event, std::max(when, clockEdge()));
+}
+
+void
+MetadataCache::trySendTiming()
+{
+    assert(!m_req_queue.empty());
+
+    DeferredPacket req = m_req_queue.front();
+
+    if (req.tick > curTick()) {
+        // a retry came while the head was still in its tag check
+        if (!m_send_event.scheduled())
+            schedule(m_send_event, req.tick);
+        return;
+    }
+
+    if (!m_mem_port.sendTimingReq(req.pkt)) {
+        // the memory controller calls recvRetry once it has room
+        return;
+    }
+
+    m_req_queue.pop_front();
+
+    if (!m_req_queue.empty() && !m_send_event.scheduled())
+        schedule(m_send_event, std::max(m_req_queue.front().tick,
+                                        clockEdge()));
+
+    if (m_retry_req) {
+        m_retry_req = false;
+        m_dir_port.sendRetry();
+    }
+}
+
+bool
+MetadataCache::checkQueuedRequests(PacketPtr pkt)
+{
+    std::deque<DeferredPacket>::reverse_iterator i;
+
+    // the newest request holding the data decides
+    for (i = m_req_queue.rbegin(); i != m_req_queue.rend(); ++i) {
+        if (pkt->checkFunctional(i->pkt))
+            return true;
+    }
+
+    return false;
+}
+
+void
+MetadataCache::recvTimingResp(PacketPtr pkt)
+{
+    if (pkt->isRead() && caches(pkt))
+        insert(lineAddr(pkt->getAddr()));
+
+    m_dir_port.schedTimingResp(pkt, curTick());
+}
+
+void
+MetadataCache::recvFunctional(PacketPtr pkt)
+{
+    if (m_dir_port.checkFunctional(pkt) || checkQueuedRequests(pkt)) {
+        if (pkt->needsResponse())
+            pkt->makeResponse();
+        return;
+    }
+
+    m_mem_port.sendFunctional(pkt);
+}
+
+void
+MetadataCache::regStats()
+{
+    MemObject::regStats();
+
+    unsigned groups = m_num_devices + 1;
+
+    m_hits
+        .init(groups)
+        .name(name() + ".hits")
+        .desc("protection table reads served by the metadata cache")
+        .flags(Stats::total | Stats::nozero)
+        ;
+
+    m_misses
+        .init(groups)
+        .name(name() + ".misses")
+        .desc("protection table reads sent to memory")
+        .flags(Stats::total | Stats::nozero)
+        ;
+
+    m_hit_rate
+        .name(name() + ".hit_rate")
+        .desc("fraction of protection table reads that hit")
+        .flags(Stats::nozero)
+        ;
+    m_hit_rate = m_hits / (m_hits + m_misses);
+
+    for (unsigned i = 0; i < groups; i++) {
+        std::string device = i < m_num_devices ? csprintf("device%d", i) :
+                             std::string("other");
+        m_hits.subname(i, device);
+        m_misses.subname(i, device);
+        m_hit_rate.subname(i, device);
+    }
+
+    m_writes
+        .name(name() + ".writes")
+        .desc("protection table writes passed to memory")
+        ;
+
+    m_retries
+        .name(name() + ".retries")
+        .desc("requests refused as the queue to memory was full")
+        ;
+}
+
+MetadataCache *
+MetadataCacheParams::create()
+{
+    return new MetadataCache(this);
+}
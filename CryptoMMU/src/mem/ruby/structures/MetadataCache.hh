@@ -0,0 +1,151 @@
+/*
+ * Near-memory cache of protection table lines.
+ *
+ * The metadata cache sits on the memory port of a directory controller,
+ * in front of its memory controller. Reads of lines in the protection
+ * table region (ProtectionTableLayout::contains) are looked up in a
+ * set-associative LRU tag store and, on a hit, answered after hit_latency
+ * without reaching DRAM. All other traffic, and every write, goes to
+ * memory unchanged. Writes of protection lines allocate, so the cache is
+ * write-through and memory always holds the data; a hit reads its data
+ * functionally from the memory side.
+ *
+ * Requests that go on to memory wait in a queue of queue_size entries.
+ * When it is full the directory is told to retry, and a request the
+ * memory controller refuses is resent on its retry, so the backpressure
+ * of the memory controller reaches the directory as without the cache.
+ *
+ * The cache is active only for the MMU policies in mmu_policies (all of
+ * them when empty). With any other policy it passes every packet through,
+ * so the same configuration compares BCC-only and near-memory caching of
+ * permissions across MMU variants.
+ *
+ * Reads are counted per device id of the request, which the protection
+ * fetch unit sets and Ruby carries to the directory's memory request.
+ */
+
+#ifndef __MEM_RUBY_STRUCTURES_METADATACACHE_HH__
+#define __MEM_RUBY_STRUCTURES_METADATACACHE_HH__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "mem/mem_object.hh"
+#include "mem/qport.hh"
+#include "params/MetadataCache.hh"
+
+class MetadataCache : public MemObject
+{
+  public:
+    typedef MetadataCacheParams Params;
+    MetadataCache(const Params *p);
+
+    void init();
+    void regStats();
+
+    BaseMasterPort& getMasterPort(const std::string& if_name,
+                                  PortID idx = InvalidPortID);
+    BaseSlavePort& getSlavePort(const std::string& if_name,
+                                PortID idx = InvalidPortID);
+
+  private:
+    /** Port the directory controller sends its memory requests to. */
+    class DirSidePort : public QueuedSlavePort
+    {
+      private:
+        SlavePacketQueue m_queue;
+        MetadataCache *m_cache;
+
+      public:
+        DirSidePort(const std::string& name, MetadataCache *cache);
+
+      protected:
+        Tick recvAtomic(PacketPtr pkt);
+        void recvFunctional(PacketPtr pkt);
+        bool recvTimingReq(PacketPtr pkt);
+        AddrRangeList getAddrRanges() const;
+    };
+
+    /** Port to the memory controller. */
+    class MemSidePort : public MasterPort
+    {
+      private:
+        MetadataCache *m_cache;
+
+      public:
+        MemSidePort(const std::string& name, MetadataCache *cache);
+
+      protected:
+        bool recvTimingResp(PacketPtr pkt);
+        void recvRetry();
+        void recvRangeChange();
+    };
+
+    /** A request waiting to go to memory, and when it may. */
+    struct DeferredPacket
+    {
+        Tick tick;
+        PacketPtr pkt;
+        DeferredPacket(PacketPtr _pkt, Tick _tick) : tick(_tick), pkt(_pkt)
+        {}
+    };
+
+    struct Line
+    {
+        Addr tag;
+        bool valid;
+        uint64_t lastUse;
+        Line() : tag(0), valid(false), lastUse(0) {}
+    };
+
+    bool recvTimingReq(PacketPtr pkt);
+    void recvTimingResp(PacketPtr pkt);
+    void recvFunctional(PacketPtr pkt);
+
+    /** Queue pkt for memory, to be sent at when. */
+    void forward(PacketPtr pkt, Tick when);
+    /** Send the head of the request queue to memory. */
+    void trySendTiming();
+    /** Whether a queued write holds data for pkt, reading it if so. */
+    bool checkQueuedRequests(PacketPtr pkt);
+    /** Stats group of the device pkt is made for. */
+    unsigned deviceGroup(PacketPtr pkt) const;
+
+    /** Whether pkt is a protection table access the cache handles. */
+    bool caches(PacketPtr pkt) const;
+    Addr lineAddr(Addr addr) const { return addr & ~Addr(m_line_bytes - 1); }
+    Line *lookup(Addr line_addr);
+    void insert(Addr line_addr);
+
+    DirSidePort m_dir_port;
+    MemSidePort m_mem_port;
+
+    const uint64_t m_size;
+    const unsigned m_assoc;
+    const Cycles m_hit_latency;
+    const unsigned m_queue_size;
+    const unsigned m_num_devices;
+    const std::vector<std::string> m_mmu_policies;
+
+    bool m_enabled;
+    unsigned m_line_bytes;
+    unsigned m_sets;
+    std::vector<Line> m_lines;
+    uint64_t m_use_count;
+
+    std::deque<DeferredPacket> m_req_queue;
+    /** A request of the directory was refused for a full queue. */
+    bool m_retry_req;
+    EventWrapper<MetadataCache, &MetadataCache::trySendTiming> m_send_event;
+
+    // per device id, ids from num_devices on share the last entry
+    Stats::Vector m_hits;
+    Stats::Vector m_misses;
+    Stats::Formula m_hit_rate;
+    Stats::Scalar m_writes;
+    Stats::Scalar m_retries;
+};
+
+#endif // __MEM_RUBY_STRUCTURES_METADATACACHE_HH__
@@ -0,0 +1,23 @@
+from m5.params import *
+from MemObject import MemObject
+
+# Cache of protection table lines between a directory controller and its
+# memory controller. It is write-through and holds tags only, every other
+# access passes through unchanged.
+class MetadataCache(MemObject):
+    type = 'MetadataCache'
+    cxx_class = 'MetadataCache'
+    cxx_header = "mem/ruby/structures/MetadataCache.hh"
+
+    size = Param.MemorySize("64kB", "capacity")
+    assoc = Param.Unsigned(8, "associativity")
+    hit_latency = Param.Cycles(4, "cycles to answer a hit or forward a miss")
+    queue_size = Param.Unsigned(16,
+        "requests waiting to go to memory before the directory must retry")
+    num_devices = Param.Unsigned(64,
+        "device ids with their own stats, higher ids are counted as other")
+    mmu_policies = VectorParam.String([],
+        "MMU policies the cache is active for, empty for all")
+
+    slave = SlavePort("Port to the directory controller")
+    master = MasterPort("Port to the memory controller")
@@ -255,6 +255,7 @@ DMASequencer::makeRequest(PacketPtr pkt)
     msg->getPhysicalAddress() = Address(paddr);
     msg->getLineAddress() = line_address(msg->getPhysicalAddress());
     msg->getType() = write ? SequencerRequestType_ST : SequencerRequestType_LD;
+    msg->getReqClass() = pkt->req->requestorClass();
     int offset = paddr & m_data_block_mask;
 
     msg->getLen() = (offset + len) <= RubySystem::getBlockSizeBytes() ?
@@ -296,6 +297,7 @@ DMASequencer::issueNext()
 
     assert((msg->getPhysicalAddress().getAddress() & m_data_block_mask) == 0);
     msg->getLineAddress() = line_address(msg->getPhysicalAddress());
+    msg->getReqClass() = active_request.pkt->req->requestorClass();
 
     msg->getType() = (active_request.write ? SequencerRequestType_ST :
                      SequencerRequestType_LD);
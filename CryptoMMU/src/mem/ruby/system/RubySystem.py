@@ -46,6 +46,48 @@ class RubySystem(ClockedObject):
     td_tlb_latency = Param.UInt32(3, "the lookup latency for td tlb");
     td_tlb_assoc = Param.UInt32(4, "the associativity of td tlb");
 
+    td_prefetch = Param.Bool(False,
+        "prefetch translations of upcoming tasks into the td tlb");
+    td_prefetch_tasks = Param.UInt32(4,
+        "number of tasks ahead of dispatch covered by td prefetch");
+    td_prefetch_max_inflight = Param.UInt32(8,
+        "max number of outstanding td translation prefetches");
+    td_prefetch_verify = Param.Bool(False,
+        "pre-verify prefetched translations against the protection table");
+
+    td_concurrent_loads = Param.UInt32(4,
+        "max number of program reads in flight in the td");
+    td_tenant_weights = Param.String("",
+        "comma separated process:weight list for td fair queueing");
+
+    prot_table_base = Param.Addr(0x800000, "base address of the protection table");
+    prot_table_size = Param.Addr(0x1800000,
+        "bytes from prot_table_base holding the tables of all devices");
+    prot_table_device_stride = Param.Addr(0,
+        "distance between the tables of devices, 0 to share one table");
+    prot_table_packed = Param.Bool(False,
+        "pack per-page entries into lines instead of base + (paddr >> 2)");
+    prot_table_mac_bits = Param.UInt32(5,
+        "MAC tag bits stored next to the R/W/X bits of each page");
+    prot_table_pages_per_line = Param.UInt32(0,
+        "pages per protection table line, 0 for as many as fit");
+    prot_table_pack_devices = Param.UInt32(1,
+        "number of devices whose entries share a protection table line");
+    prot_fetch_max_outstanding = Param.UInt32(4,
+        "max number of protection table reads in flight per network interrupt");
+    prot_fetch_latency = Param.UInt32(0,
+        "cycles a protection table read takes without a fetch port, 0 to resolve BCC misses like hits");
+    bcc_entries = Param.UInt32(10, "number of BCC entries per network interrupt");
+    bcc_assoc = Param.UInt32(10, "BCC associativity");
+    host_ptw_walkers = Param.UInt32(1,
+        "max number of host page table walks in flight per network interrupt");
+    translation_warmup_tasks = Param.UInt32(0,
+        "tasks per program whose translations are warmed up functionally");
+    translation_trace = Param.String("",
+        "binary trace of the translation pipeline, empty to disable");
+    translation_trace_entries = Param.UInt32(65536,
+        "records buffered before the translation trace is written out");
+
     lcacc_tlb_size = Param.UInt32(32, "number of LCAcc TLB entries");
     lcacc_tlb_latency = Param.UInt32(1, "the lookup latency for lcacc tlb");
     lcacc_tlb_assoc = Param.UInt32(2, "the associativity of lcacc tlb");
@@ -73,6 +115,16 @@ class RubySystem(ClockedObject):
     lcacc_tlb_mshr = Param.UInt32(1, "number of MSHRs in LCAcc TLBs");
 
     dma_issue_width = Param.UInt32(64, "LCAcc DMA issue width");
+    merge_write_checks = Param.Bool(False,
+        "LCAcc write hits wait for a check of their page already in flight "
+        "instead of sending their own");
+    dma_stream_stores = Param.Bool(False,
+        "LCAcc DMA writes go to the L2 without allocating in the L1");
+    acc_compute_threads = Param.UInt32(0,
+        "host threads running LCAcc compute kernels, 0 runs them inline");
+    acc_compute_quantum = Param.UInt32(1,
+        "cycles of LCAcc compute kernels run as one parallel batch; above 1 "
+        "a kernel finishes up to quantum-1 cycles late");
 
 
 
@@ -86,4 +138,10 @@ class RubySystem(ClockedObject):
     cryptommu_serial = Param.Bool(False, "simulate the Behaviour of CryptoMMU Serial");
     cryptommu_parallel = Param.Bool(False, "simulate the Behaviour of CryptoMMU parallel");
     cryptommu_parallel_ra = Param.Bool(False, "simulate the Behaviour of CryptoMMU with read acceleration");
+    mmu_policy = Param.String("",
+        "accelerator MMU model: ideal, full_iommu, ats_only, border_control, "
+        "cryptommu_serial, cryptommu_parallel or cryptommu_read_acc; "
+        "empty picks one from the flags above");
+    mac_latency = Param.UInt32(0,
+        "cycles to compute a MAC, 0 charges only the BCC lookup");
  
@@ -631,6 +631,20 @@ Sequencer::hitCallback(SequencerRequest* srequest, DataBlock& data,
       makeRequestCBSet.erase(request_line_address);
       makeRequestCBArgs.erase(request_line_address);
     }
+
+    // the entry of this request is free, wake whoever was turned away;
+    // the lists are swapped out first as a woken caller may wait again
+    if (!readyCBSet.empty())
+    {
+      std::vector<MakeRequestCallback> readyCBs;
+      std::vector<void*> readyArgs;
+      readyCBs.swap(readyCBSet);
+      readyArgs.swap(readyCBArgs);
+      for(unsigned int i = 0; i < readyCBs.size(); i++)
+      {
+        readyCBs[i](readyArgs[i]);
+      }
+    }
 #endif
 
     if (g_system_ptr->m_warmup_enabled) {
@@ -672,11 +686,23 @@ bool Sequencer::isReady(uint64_t pAddr){
 }
 RequestStatus Sequencer::makeRequest(PacketPtr pkt, void(*cb)(void*), void* args)
 {
+  RequestStatus status = makeRequest(pkt);
+  if (status != RequestStatus_Issued)
+    return status;
+
+  // the line completes no earlier than the next cycle, so registering
+  // after the issue cannot miss the callback
   Address addr(pkt->getAddr());
   addr.makeLineAddress();
   makeRequestCBSet[addr].push_back(cb);
   makeRequestCBArgs[addr].push_back(args);
-  return makeRequest(pkt);
+  return status;
+}
+
+void Sequencer::addReadyCallback(void(*cb)(void*), void* args)
+{
+  readyCBSet.push_back(cb);
+  readyCBArgs.push_back(args);
 }
 
 void Sequencer::makeBufferRequest(uint64_t bufferBlockAddr, int bufferID, RubyRequestType typeOfRequest, void(*cb)(void*), void* args)
@@ -851,6 +877,9 @@ Sequencer::issueRequest(PacketPtr pkt, RubyRequestType secondary_type)
         msg->m_BypassCache = true;
     }
 
+    msg->m_ReqClass = pkt->req->requestorClass();
+    msg->m_DeviceId = pkt->req->GetdeviceId();
+
     DPRINTFR(ProtocolTrace, "%15s %3s %10s%20s %6s>%-6s %s %s\n",
             curTick(), m_version, "Seq", "Begin", "", "",
             msg->getPhysicalAddress(),
@@ -94,7 +94,11 @@ class Sequencer : public RubyPort
 
 #if defined(SIM_ENHANCE) || defined(BUFFER_IN_CACHE)
     bool isReady(uint64_t pAddr);
+    // Issue pkt and call cb(args) when its line completes. BufferFull and
+    // Aliased are retryable: nothing is kept and the caller still owns pkt.
     RequestStatus makeRequest(PacketPtr pkt, void(*cb)(void*), void* args);
+    // Call cb(args) once, the next time a request table entry frees up
+    void addReadyCallback(void(*cb)(void*), void* args);
     void makeBufferRequest(uint64_t bufferBlockAddr, int bufferID, RubyRequestType typeOfRequest, void(*cb)(void*), void* args);
 #endif
     RequestStatus makeRequest(PacketPtr pkt);
@@ -200,6 +204,8 @@ class Sequencer : public RubyPort
   typedef void (*MakeRequestCallback)(void*);
   std::map<Address, std::vector<MakeRequestCallback> > makeRequestCBSet;
   std::map<Address, std::vector<void*> > makeRequestCBArgs;
+  std::vector<MakeRequestCallback> readyCBSet;
+  std::vector<void*> readyCBArgs;
 #endif
     // Global outstanding request count, across all request tables
     int m_outstanding_count;
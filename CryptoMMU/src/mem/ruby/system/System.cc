@@ -30,11 +30,15 @@
 #include <zlib.h>
 
 #include <cstdio>
+#include <cstdlib>
+#include <sstream>
 
 #include "base/intmath.hh"
 #include "base/statistics.hh"
 #include "debug/RubyCacheTrace.hh"
 #include "debug/RubySystem.hh"
+#include "mem/protection_table.hh"
+#include "mem/translation_trace.hh"
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/network/Network.hh"
 #include "mem/ruby/system/System.hh"
@@ -83,11 +87,27 @@ uint32_t RubySystem::m_memory_size_bits;
 uint32_t RubySystem::m_td_tlb_size;
 uint32_t RubySystem::m_td_tlb_latency;
 uint32_t RubySystem::m_td_tlb_assoc;
+bool RubySystem::m_td_prefetch;
+uint32_t RubySystem::m_td_prefetch_tasks;
+uint32_t RubySystem::m_td_prefetch_max_inflight;
+bool RubySystem::m_td_prefetch_verify;
+uint32_t RubySystem::m_td_concurrent_loads;
+uint32_t RubySystem::m_prot_fetch_max_outstanding;
+uint32_t RubySystem::m_prot_fetch_latency;
+uint32_t RubySystem::m_bcc_entries;
+uint32_t RubySystem::m_bcc_assoc;
+uint32_t RubySystem::m_host_ptw_walkers;
+uint32_t RubySystem::m_translation_warmup_tasks;
+std::map<unsigned int, uint32_t> RubySystem::m_td_tenant_weights;
 uint32_t RubySystem::m_lcacc_tlb_size;
 uint32_t RubySystem::m_lcacc_tlb_mshr;
 uint32_t RubySystem::m_lcacc_tlb_latency;
 uint32_t RubySystem::m_lcacc_tlb_assoc;
 uint32_t RubySystem::m_dma_issue_width;
+bool RubySystem::m_merge_write_checks;
+bool RubySystem::m_dma_stream_stores;
+uint32_t RubySystem::m_acc_compute_threads;
+uint32_t RubySystem::m_acc_compute_quantum;
 #ifdef SIM_NET_PORTS
 std::vector<std::string> RubySystem::accTypes;
 int RubySystem::m_num_simics_net_ports;
@@ -102,6 +122,8 @@ bool RubySystem::m_iommu;
 bool RubySystem::m_cryptommu_serial;
 bool RubySystem::m_cryptommu_parallel;
 bool RubySystem::m_cryptommu_parallel_ra;
+std::string RubySystem::m_mmu_policy;
+uint32_t RubySystem::m_mac_latency;
 
 #endif
 
@@ -122,12 +144,44 @@ RubySystem::RubySystem(const Params *p)
 
     m_td_tlb_size       = p->td_tlb_size;
     m_td_tlb_latency    = p->td_tlb_latency;
+    m_td_tlb_assoc      = p->td_tlb_assoc;
+    m_td_prefetch       = p->td_prefetch;
+    m_td_prefetch_tasks = p->td_prefetch_tasks;
+    m_td_prefetch_max_inflight = p->td_prefetch_max_inflight;
+    m_td_prefetch_verify = p->td_prefetch_verify;
+    m_td_concurrent_loads = p->td_concurrent_loads;
+    parseTenantWeights(p->td_tenant_weights);
+    ProtectionTableLayout::configure(p->prot_table_base,
+                                     p->prot_table_size,
+                                     p->prot_table_device_stride,
+                                     p->prot_table_packed,
+                                     p->prot_table_mac_bits,
+                                     p->prot_table_pages_per_line,
+                                     p->prot_table_pack_devices,
+                                     m_block_size_bytes, 12);
+    m_prot_fetch_max_outstanding = p->prot_fetch_max_outstanding;
+    m_prot_fetch_latency = p->prot_fetch_latency;
+    m_bcc_entries = p->bcc_entries;
+    m_bcc_assoc = p->bcc_assoc;
+    m_host_ptw_walkers = p->host_ptw_walkers;
+    m_translation_warmup_tasks = p->translation_warmup_tasks;
+    if (m_bcc_assoc == 0 || m_bcc_entries % m_bcc_assoc != 0)
+        fatal("bcc_entries (%d) must be a multiple of bcc_assoc (%d)\n",
+              m_bcc_entries, m_bcc_assoc);
+    if (m_host_ptw_walkers == 0)
+        fatal("host_ptw_walkers must be at least 1\n");
+    TranslationTrace::open(p->translation_trace,
+                           p->translation_trace_entries);
     m_lcacc_tlb_size    = p->lcacc_tlb_size;
     m_lcacc_tlb_latency = p->lcacc_tlb_latency;
     m_lcacc_tlb_assoc   = p->lcacc_tlb_assoc;
     m_lcacc_tlb_mshr    = p->lcacc_tlb_mshr;
 
     m_dma_issue_width   = p->dma_issue_width;
+    m_merge_write_checks = p->merge_write_checks;
+    m_dma_stream_stores = p->dma_stream_stores;
+    m_acc_compute_threads = p->acc_compute_threads;
+    m_acc_compute_quantum = p->acc_compute_quantum;
 
 
 #ifdef SIM_NET_PORTS
@@ -140,6 +194,22 @@ RubySystem::RubySystem(const Params *p)
     m_cryptommu_serial = p->cryptommu_serial;
     m_cryptommu_parallel = p->cryptommu_parallel;
     m_cryptommu_parallel_ra = p->cryptommu_parallel_ra;
+    m_mac_latency = p->mac_latency;
+    m_mmu_policy = p->mmu_policy;
+
+    // without an explicit policy the older variant flags pick one
+    if (m_mmu_policy.empty()) {
+        if (m_iommu)
+            m_mmu_policy = "full_iommu";
+        else if (m_ideal_mmu)
+            m_mmu_policy = "ideal";
+        else if (m_cryptommu_parallel_ra)
+            m_mmu_policy = "cryptommu_read_acc";
+        else if (m_cryptommu_parallel)
+            m_mmu_policy = "cryptommu_parallel";
+        else
+            m_mmu_policy = "cryptommu_serial";
+    }
     m_num_simics_net_ports = p->num_simics_net_ports;
     // m_num_accelerators = p->num_accelerators;
     m_num_TDs = p->num_TDs;
@@ -183,6 +253,39 @@ RubySystem::parseAccTypes(std::string acc_types)
     m_num_accelerators += typeDeviceNames.size();
 }
 
+void
+RubySystem::parseTenantWeights(std::string weights)
+{
+    std::stringstream ss(weights);
+    std::string token;
+
+    while (std::getline(ss, token, ',')) {
+        if (token.empty())
+            continue;
+
+        size_t pos = token.find(':');
+        if (pos == std::string::npos)
+            fatal("td_tenant_weights entry '%s' is not process:weight\n",
+                  token);
+
+        unsigned int process = atoi(token.substr(0, pos).c_str());
+        int weight = atoi(token.substr(pos + 1).c_str());
+        if (weight <= 0)
+            fatal("td_tenant_weights entry '%s' needs a positive weight\n",
+                  token);
+
+        m_td_tenant_weights[process] = weight;
+    }
+}
+
+uint32_t
+RubySystem::getTDTenantWeight(unsigned int process)
+{
+    std::map<unsigned int, uint32_t>::const_iterator it =
+        m_td_tenant_weights.find(process);
+    return (it == m_td_tenant_weights.end()) ? 1 : it->second;
+}
+
 void
 RubySystem::registerNetwork(Network* network_ptr)
 {
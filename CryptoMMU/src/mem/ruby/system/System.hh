@@ -84,12 +84,16 @@ class RubySystem : public ClockedObject
     static bool m_cryptommu_serial;
     static bool m_cryptommu_parallel;
     static bool m_cryptommu_parallel_ra;
+    static std::string m_mmu_policy;
+    static uint32_t m_mac_latency;
     static bool iommu() { return m_iommu; }
     static bool idealMMU() { return m_ideal_mmu; }
     static bool TLBHack() { return m_tlb_hack; }
     static bool CryptoMMU_Serial() {return m_cryptommu_serial;}
     static bool CryptoMMU_Parallel() {return m_cryptommu_parallel;}
     static bool CryptoMMU_Parallel_RA () {return m_cryptommu_parallel_ra;}
+    static const std::string& getMMUPolicy() { return m_mmu_policy; }
+    static uint32_t getMACLatency() { return m_mac_latency; }
     static int numberOfAccelerators() { return m_num_accelerators; }
     static int numberOfSimicsNetworkPortPerChip() { return m_num_simics_net_ports; }
     static int numberOfSimicsNetworkPortPerChip(NodeID&) {return numberOfSimicsNetworkPortPerChip(); }
@@ -121,8 +125,26 @@ class RubySystem : public ClockedObject
     static uint32_t getTDTLBSize() { return m_td_tlb_size; }
     static uint32_t getTDTLBLatency() { return m_td_tlb_latency; }
     static uint32_t getTDTLBAssoc() { return m_td_tlb_assoc; }
+    static bool TDPrefetch() { return m_td_prefetch; }
+    static uint32_t getTDPrefetchTasks() { return m_td_prefetch_tasks; }
+    static uint32_t getTDPrefetchMaxInflight()
+    { return m_td_prefetch_max_inflight; }
+    static bool TDPrefetchVerify() { return m_td_prefetch_verify; }
+    static uint32_t getTDConcurrentLoads() { return m_td_concurrent_loads; }
+    static uint32_t getProtFetchMaxOutstanding() { return m_prot_fetch_max_outstanding; }
+    static uint32_t getProtFetchLatency() { return m_prot_fetch_latency; }
+    static uint32_t getBCCEntries() { return m_bcc_entries; }
+    static uint32_t getBCCAssoc() { return m_bcc_assoc; }
+    static uint32_t getHostPTWalkers() { return m_host_ptw_walkers; }
+    static uint32_t getTranslationWarmupTasks()
+    { return m_translation_warmup_tasks; }
+    static uint32_t getTDTenantWeight(unsigned int process);
 
     static uint32_t getDMAIssueWidth() { return m_dma_issue_width; }
+    static bool MergeWriteChecks() { return m_merge_write_checks; }
+    static bool DMAStreamStores() { return m_dma_stream_stores; }
+    static uint32_t getAccComputeThreads() { return m_acc_compute_threads; }
+    static uint32_t getAccComputeQuantum() { return m_acc_compute_quantum; }
 
     SimpleMemory *getPhysMem() { return m_phys_mem; }
 
@@ -139,6 +161,7 @@ class RubySystem : public ClockedObject
     void resetStats();
 
     void parseAccTypes(std::string acc_types);
+    void parseTenantWeights(std::string weights);
 
     void serialize(std::ostream &os);
     void unserialize(Checkpoint *cp, const std::string &section);
@@ -178,11 +201,27 @@ class RubySystem : public ClockedObject
     static uint32_t m_td_tlb_size;
     static uint32_t m_td_tlb_latency;
     static uint32_t m_td_tlb_assoc;
+    static bool m_td_prefetch;
+    static uint32_t m_td_prefetch_tasks;
+    static uint32_t m_td_prefetch_max_inflight;
+    static bool m_td_prefetch_verify;
+    static uint32_t m_td_concurrent_loads;
+    static uint32_t m_prot_fetch_max_outstanding;
+    static uint32_t m_prot_fetch_latency;
+    static uint32_t m_bcc_entries;
+    static uint32_t m_bcc_assoc;
+    static uint32_t m_host_ptw_walkers;
+    static uint32_t m_translation_warmup_tasks;
+    static std::map<unsigned int, uint32_t> m_td_tenant_weights;
     static uint32_t m_lcacc_tlb_size;
     static uint32_t m_lcacc_tlb_mshr;
     static uint32_t m_lcacc_tlb_latency;
     static uint32_t m_lcacc_tlb_assoc;
     static uint32_t m_dma_issue_width;
+    static bool m_merge_write_checks;
+    static bool m_dma_stream_stores;
+    static uint32_t m_acc_compute_threads;
+    static uint32_t m_acc_compute_quantum;
     SimpleMemory *m_phys_mem;
 
     Network* m_network;
@@ -0,0 +1,71 @@
+#include "mem/translation_trace.hh"
+
+#include <cstring>
+#include <ostream>
+
+#include "base/callback.hh"
+#include "base/misc.hh"
+#include "base/output.hh"
+#include "sim/sim_exit.hh"
+
+bool TranslationTrace::m_enabled = false;
+std::ostream *TranslationTrace::m_stream = NULL;
+std::vector<TranslationTraceRecord> TranslationTrace::m_ring;
+size_t TranslationTrace::m_used = 0;
+
+namespace {
+
+class TranslationTraceExitCallback : public Callback
+{
+  public:
+    void process() { TranslationTrace::close(); }
+};
+
+} // anonymous namespace
+
+void
+TranslationTrace::open(const std::string &name, unsigned ring_entries)
+{
+    if (name.empty())
+        return;
+
+    if (ring_entries == 0)
+        fatal("Translation trace needs a ring of at least one record\n");
+
+    if (m_enabled)
+        fatal("Translation trace is already open\n");
+
+    m_stream = simout.create(name, true);
+    m_ring.resize(ring_entries);
+    m_used = 0;
+
+    TranslationTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, TRANSLATION_TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRANSLATION_TRACE_VERSION;
+    header.recordSize = sizeof(TranslationTraceRecord);
+    m_stream->write((const char *)&header, sizeof(header));
+
+    m_enabled = true;
+    registerExitCallback(new TranslationTraceExitCallback);
+}
+
+void
+TranslationTrace::flush()
+{
+    m_stream->write((const char *)&m_ring[0],
+                    m_used * sizeof(TranslationTraceRecord));
+    m_used = 0;
+}
+
+void
+TranslationTrace::close()
+{
+    if (!m_enabled)
+        return;
+
+    flush();
+    m_enabled = false;
+    simout.close(m_stream);
+    m_stream = NULL;
+}
@@ -0,0 +1,114 @@
+/*
+ * Binary trace of the accelerator translation/verification pipeline.
+ *
+ * Every stage a translation passes through (accelerator TLB issue, task
+ * distributor arrival, BCC lookup, host walk start/end, MAC completion
+ * and finishTranslation) appends one fixed size record to an in-memory
+ * ring. The ring is written to the trace file whenever it fills and when
+ * the simulator exits. util/decode_translation_trace.py pairs the
+ * records of a page back into lifecycles and prints latency histograms
+ * per stage.
+ *
+ * File format: a TranslationTraceHeader followed by records, both in
+ * host byte order.
+ */
+
+#ifndef __MEM_TRANSLATION_TRACE_HH__
+#define __MEM_TRANSLATION_TRACE_HH__
+
+#include <stdint.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "base/types.hh"
+#include "sim/core.hh"
+
+#define TRANSLATION_TRACE_MAGIC "CMMUTRC"
+#define TRANSLATION_TRACE_VERSION 1
+#define TRANSLATION_TRACE_PAGE_SHIFT 12
+
+struct TranslationTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct TranslationTraceRecord
+{
+    uint64_t tick;
+    uint64_t vpn;
+    uint64_t ppn;
+    uint32_t device;
+    uint8_t event;
+    uint8_t outcome;
+    uint16_t context;
+};
+
+class TranslationTrace
+{
+  public:
+    enum Event {
+        Issue,
+        TDArrive,
+        BCCLookup,
+        WalkStart,
+        WalkEnd,
+        MACDone,
+        Finish
+    };
+
+    enum Outcome {
+        None,
+        TLBHit,     ///< hit on an already verified page, nothing follows
+        TLBMiss,    ///< miss sent for a walk
+        Verify,     ///< hit sent for MAC verification
+        BCCHit,
+        BCCMiss,
+        Walked,     ///< finished with a walked translation
+        Verified    ///< finished with a verified translation
+    };
+
+    /**
+     * Start tracing into file name (relative to the output directory),
+     * buffering ring_entries records between writes. An empty name
+     * leaves tracing off.
+     */
+    static void open(const std::string &name, unsigned ring_entries);
+    /// Write out what is buffered and close the file
+    static void close();
+
+    static bool enabled() { return m_enabled; }
+
+    static void
+    record(Event event, uint64_t device, Addr vaddr, Addr paddr,
+           Outcome outcome = None, unsigned context = 0)
+    {
+        if (!m_enabled)
+            return;
+
+        TranslationTraceRecord &r = m_ring[m_used];
+        r.tick = curTick();
+        r.vpn = vaddr >> TRANSLATION_TRACE_PAGE_SHIFT;
+        r.ppn = paddr >> TRANSLATION_TRACE_PAGE_SHIFT;
+        r.device = device;
+        r.event = event;
+        r.outcome = outcome;
+        r.context = context;
+
+        if (++m_used == m_ring.size())
+            flush();
+    }
+
+  private:
+    static bool m_enabled;
+    static std::ostream *m_stream;
+    static std::vector<TranslationTraceRecord> m_ring;
+    static size_t m_used;
+
+    static void flush();
+};
+
+#endif // __MEM_TRANSLATION_TRACE_HH__
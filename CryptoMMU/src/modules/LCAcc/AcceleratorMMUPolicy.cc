@@ -0,0 +1,30 @@
+#include "AcceleratorMMUPolicy.hh"
+#include "base/misc.hh"
+#include "mem/ruby/system/System.hh"
+
+AcceleratorMMUPolicy*
+AcceleratorMMUPolicy::Create(const std::string& name)
+{
+  AcceleratorMMUPolicy* policy = NULL;
+#define MMU_POLICY_LISTING(x, y) if (name == x) policy = new y();
+#include "AcceleratorMMUPolicyListing.hh"
+#undef MMU_POLICY_LISTING
+  return policy;
+}
+
+AcceleratorMMUPolicy*
+AcceleratorMMUPolicy::Instance()
+{
+  static AcceleratorMMUPolicy* policy = NULL;
+
+  if (policy == NULL) {
+    policy = Create(RubySystem::getMMUPolicy());
+
+    if (policy == NULL) {
+      fatal("Unknown accelerator MMU policy '%s'\n",
+            RubySystem::getMMUPolicy());
+    }
+  }
+
+  return policy;
+}
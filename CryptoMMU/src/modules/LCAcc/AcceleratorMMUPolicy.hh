@@ -0,0 +1,145 @@
+#ifndef ACCELERATOR_MMU_POLICY_H
+#define ACCELERATOR_MMU_POLICY_H
+
+#include <stdint.h>
+#include <string>
+
+// How accelerator translations are cached and checked.  Exactly one policy
+// is active per run, chosen by RubySystem's mmu_policy; the names are in
+// AcceleratorMMUPolicyListing.hh.  The accelerator DMA controller asks the
+// policy what to do on a TLB lookup, the network interrupt asks it how long
+// a verification takes once the permission is known.
+class AcceleratorMMUPolicy
+{
+public:
+  virtual ~AcceleratorMMUPolicy() {}
+  virtual const char* GetPolicyName() const = 0;
+  // translations come straight from the host page table at no cost
+  virtual bool IsIdeal() const
+  {
+    return false;
+  }
+  // the accelerator caches translations in its own TLB
+  virtual bool HasDeviceTLB() const
+  {
+    return true;
+  }
+  // a device TLB hit has to be checked by the host before it is used
+  virtual bool VerifyHits() const
+  {
+    return true;
+  }
+  // reads may use a device TLB hit while its check is still in flight
+  virtual bool ForwardReadsOnHit() const
+  {
+    return false;
+  }
+  // cycles from the permission being known to the reply leaving the host,
+  // elapsed is the time since the request reached the host
+  virtual uint64_t MACDelay(uint64_t macLatency, uint64_t elapsed) const
+  {
+    return 0;
+  }
+
+  static AcceleratorMMUPolicy* Create(const std::string& name);
+  static AcceleratorMMUPolicy* Instance();
+};
+
+class IdealMMUPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "ideal";
+  }
+  bool IsIdeal() const
+  {
+    return true;
+  }
+};
+
+// every access is translated by the IOMMU, the device keeps no TLB
+class FullIOMMUPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "full_iommu";
+  }
+  bool HasDeviceTLB() const
+  {
+    return false;
+  }
+  bool VerifyHits() const
+  {
+    return false;
+  }
+};
+
+// the device TLB is trusted, only misses reach the host
+class ATSOnlyPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "ats_only";
+  }
+  bool VerifyHits() const
+  {
+    return false;
+  }
+};
+
+// hits are checked against the protection table, no MAC
+class BorderControlPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "border_control";
+  }
+};
+
+// the MAC is computed once the protection table entry is known
+class CryptoMMUSerialPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "cryptommu_serial";
+  }
+  uint64_t MACDelay(uint64_t macLatency, uint64_t elapsed) const
+  {
+    return macLatency;
+  }
+};
+
+// the MAC is computed alongside the BCC lookup and protection table read
+class CryptoMMUParallelPolicy : public AcceleratorMMUPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "cryptommu_parallel";
+  }
+  uint64_t MACDelay(uint64_t macLatency, uint64_t elapsed) const
+  {
+    return elapsed >= macLatency ? 0 : macLatency - elapsed;
+  }
+};
+
+// parallel, and reads go ahead on a hit while the check completes
+class CryptoMMUReadAccPolicy : public CryptoMMUParallelPolicy
+{
+public:
+  const char* GetPolicyName() const
+  {
+    return "cryptommu_read_acc";
+  }
+  bool ForwardReadsOnHit() const
+  {
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,9 @@
+//List as "MMU_POLICY_LISTING("name", class name)"
+//for example:  MMU_POLICY_LISTING("ats_only", ATSOnlyPolicy);
+MMU_POLICY_LISTING("ideal", IdealMMUPolicy)
+MMU_POLICY_LISTING("full_iommu", FullIOMMUPolicy)
+MMU_POLICY_LISTING("ats_only", ATSOnlyPolicy)
+MMU_POLICY_LISTING("border_control", BorderControlPolicy)
+MMU_POLICY_LISTING("cryptommu_serial", CryptoMMUSerialPolicy)
+MMU_POLICY_LISTING("cryptommu_parallel", CryptoMMUParallelPolicy)
+MMU_POLICY_LISTING("cryptommu_read_acc", CryptoMMUReadAccPolicy)
@@ -0,0 +1,134 @@
+#include "ComputePool.hh"
+
+#include <cassert>
+#include <map>
+#include <thread>
+
+#include "base/barrier.hh"
+#include "base/misc.hh"
+#include "mem/ruby/system/System.hh"
+
+namespace LCAcc
+{
+
+ComputePool::ComputePool(unsigned int threads, uint64_t quantum)
+  : numThreads(threads), quantum(quantum), started(false), startBarrier(NULL),
+    endBarrier(NULL), nextGroup(0)
+{
+}
+
+ComputePool*
+ComputePool::Instance()
+{
+  static ComputePool* pool = NULL;
+
+  if (pool == NULL) {
+    fatal_if(RubySystem::getAccComputeQuantum() == 0,
+             "acc_compute_quantum must be at least one cycle\n");
+    pool = new ComputePool(RubySystem::getAccComputeThreads(),
+                           RubySystem::getAccComputeQuantum());
+  }
+
+  return pool;
+}
+
+void
+ComputePool::Start()
+{
+  // the simulation thread is one of the threads, it joins every batch
+  startBarrier = new Barrier(numThreads);
+  endBarrier = new Barrier(numThreads);
+
+  for (unsigned int i = 1; i < numThreads; i++) {
+    std::thread(&ComputePool::WorkerLoop, this).detach();
+  }
+
+  inform("Running accelerator compute kernels on %d host threads\n",
+         numThreads);
+  started = true;
+}
+
+void
+ComputePool::WorkerLoop()
+{
+  while (true) {
+    startBarrier->wait();
+    RunGroups();
+    endBarrier->wait();
+  }
+}
+
+void
+ComputePool::RunGroups()
+{
+  size_t group;
+
+  while ((group = nextGroup++) < work.size()) {
+    std::vector<CallbackBase*>& kernels = work[group];
+
+    for (size_t i = 0; i < kernels.size(); i++) {
+      kernels[i]->Call();
+      kernels[i]->Dispose();
+    }
+  }
+}
+
+void
+ComputePool::Defer(int group, CallbackBase* compute, CallbackBase* finish)
+{
+  assert(IsParallel());
+  assert(compute);
+  assert(finish);
+  Job job;
+  job.group = group;
+  job.compute = compute;
+  job.finish = finish;
+  jobs.push_back(job);
+}
+
+bool
+ComputePool::Run(uint64_t cycle)
+{
+  if (jobs.empty() || (cycle + 1) % quantum != 0) {
+    return false;
+  }
+
+  if (!started) {
+    Start();
+  }
+
+  std::vector<Job> batch;
+  batch.swap(jobs);
+
+  // groups are numbered in the order they first appear in the batch
+  std::map<int, size_t> groupIndex;
+  work.clear();
+
+  for (size_t i = 0; i < batch.size(); i++) {
+    std::map<int, size_t>::iterator it = groupIndex.find(batch[i].group);
+
+    if (it == groupIndex.end()) {
+      it = groupIndex.insert(std::make_pair(batch[i].group,
+                                            work.size())).first;
+      work.push_back(std::vector<CallbackBase*>());
+    }
+
+    work[it->second].push_back(batch[i].compute);
+  }
+
+  nextGroup = 0;
+  startBarrier->wait();
+  RunGroups();
+  endBarrier->wait();
+
+  // continuations may schedule more callbacks and defer more kernels, so
+  // they only run once the pool is idle again
+  for (size_t i = 0; i < batch.size(); i++) {
+    batch[i].finish->Call();
+    batch[i].finish->Dispose();
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Host threads for the compute kernels of accelerator operating modes.
+ *
+ * A kernel reads and writes only the scratch pad of its own accelerator
+ * and the state of its own operating mode, so the kernels that fall due
+ * in one cycle can run side by side. With acc_compute_threads at 0 they
+ * run inline as before. Otherwise LCAccDevice defers them here, and after
+ * the callbacks of every cycle the simulation loop calls Run(). Kernels
+ * are collected for acc_compute_quantum cycles; on the last cycle of the
+ * quantum Run() spreads them over the threads, keeping all the kernels of
+ * one scratch pad on one thread and in order. It then calls the
+ * continuations serially in the order the kernels were deferred, so the
+ * results do not depend on the thread count. A larger quantum pays for the
+ * two barriers of a batch less often, at the price of kernels finishing
+ * up to quantum-1 cycles after they fell due.
+ */
+
+#ifndef LCACC_COMPUTE_POOL_H
+#define LCACC_COMPUTE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "../Common/BaseCallbacks.hh"
+
+class Barrier;
+
+namespace LCAcc
+{
+class ComputePool
+{
+  class Job
+  {
+  public:
+    int group;
+    CallbackBase* compute;
+    CallbackBase* finish;
+  };
+
+  unsigned int numThreads;
+  uint64_t quantum;
+  bool started;
+  Barrier* startBarrier;
+  Barrier* endBarrier;
+
+  // kernels deferred since the last Run(), in order
+  std::vector<Job> jobs;
+  // kernels of the running batch, one list per group
+  std::vector<std::vector<CallbackBase*> > work;
+  std::atomic<size_t> nextGroup;
+
+  ComputePool(unsigned int threads, uint64_t quantum);
+  void Start();
+  void RunGroups();
+  void WorkerLoop();
+
+public:
+  static ComputePool* Instance();
+  bool IsParallel() const
+  {
+    return numThreads > 0;
+  }
+  // compute runs on a pool thread together with the other kernels of
+  // group, finish runs afterwards on the simulation thread
+  void Defer(int group, CallbackBase* compute, CallbackBase* finish);
+  // runs the deferred kernels if cycle ends a quantum, returns false if
+  // nothing ran
+  bool Run(uint64_t cycle);
+};
+}
+
+#endif
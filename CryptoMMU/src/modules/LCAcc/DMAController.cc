@@ -8,10 +8,13 @@
 #include "../MsgLogger/MsgLogger.hh"
 #include "arch/isa_traits.hh"
 #include "../Common/BitConverter.hh"
+#include "../Common/PolyhedralAddresser.hh"
 #include "../MsgLogger/MsgLogger.hh"
 #include "mem/ruby/common/Global.hh"
 #include "../TLBHack/TLBHack.hh"
 #include "arch/vtophys.hh"
+#include "mem/translation_trace.hh"
+#include "AcceleratorMMUPolicy.hh"
 
 using namespace LCAcc;
 
@@ -53,6 +56,7 @@ DMAController::DMAController(NetworkInterface* ni, SPMInterface* spm,
   ni->RegisterRecvHandler(OnNetworkMsgCB::Create(this));
 
   isHookedToMemory = false;
+  currentASID = 0;
 
   numEntries = RubySystem::getLCAccTLBSize();
   hitLatency = RubySystem::getLCAccTLBLatency();
@@ -73,6 +77,13 @@ DMAController::DMAController(NetworkInterface* ni, SPMInterface* spm,
   transferStatus = Running;
   timeStamp = 0;
   BCCMshrhits = 0;
+  prefetchIssued = 0;
+  prefetchUseful = 0;
+  prefetchLate = 0;
+  prefetchUseless = 0;
+  prefetchVerified = 0;
+  verifyLatencyHist.init(10);
+  missLatencyHist.init(10);
   //protection_table_Memory =new int[1024*1024];
   
 }
@@ -95,7 +106,42 @@ DMAController::GetPageAddr(uint64_t addr) const
 void
 DMAController::finishTranslation(uint64_t vp_base, uint64_t pp_base, uint64_t MAC_return)
 {
- 
+  if (FinishStaleRequest(vp_base, pp_base)) {
+    return;
+  }
+
+  if (FinishPrefetch(vp_base, pp_base, MAC_return) &&
+      MSHRs.find(vp_base) == MSHRs.end()) {
+    // prefetch reply nobody is waiting on yet
+    return;
+  }
+
+  std::map<uint64_t, uint64_t>::iterator issued = translationIssued.find(vp_base);
+
+  if (issued != translationIssued.end()) {
+    uint64_t latency = GetSystemTime() - issued->second;
+
+    if (MAC_return == 1) {
+      verifyLatencyHist.sample(latency);
+    } else {
+      missLatencyHist.sample(latency);
+    }
+
+    translationIssued.erase(issued);
+  }
+
+  readsVerifying.erase(vp_base);
+
+  if (MSHRs.find(vp_base) == MSHRs.end()) {
+    // the check of a hit whose reads were forwarded ahead of it
+    return;
+  }
+
+  TranslationTrace::record(TranslationTrace::Finish, network->GetNodeID(),
+                           vp_base, pp_base,
+                           MAC_return == 1 ? TranslationTrace::Verified :
+                           TranslationTrace::Walked, currentASID);
+
   std::list<TransferData*> &tds = MSHRs[vp_base];
   std::list<TransferData*>::iterator it;
   for (it = tds.begin(); it != tds.end(); it++) {
@@ -117,7 +163,9 @@ DMAController::finishTranslation(uint64_t vp_base, uint64_t pp_base, uint64_t MA
     
   }
      
-    tlbMemory->insert(vp_base, pp_base);
+    if (AcceleratorMMUPolicy::Instance()->HasDeviceTLB()) {
+      tlbMemory->insert(currentASID, spm->GetID(), vp_base, pp_base);
+    }
     MSHRs.erase(vp_base);
    
     if (MSHRs.empty()) {
@@ -131,7 +179,7 @@ DMAController::finishTranslation(uint64_t vp_base, uint64_t pp_base, uint64_t MA
 void
 DMAController::beginTranslateTiming(TransferData* td)
 {
-  if (RubySystem::idealMMU()) {
+  if (AcceleratorMMUPolicy::Instance()->IsIdeal()) {
     // The below code implements a perfect TLB with instant access to the
     // host page table.
     uint64_t vaddr = td->getVaddr();
@@ -165,23 +213,96 @@ DMAController::translateTiming(TransferData* td)
   uint64_t offset = vaddr - vp_base;
   uint64_t pp_base;
   uint64_t MAC_dma;
+  AcceleratorMMUPolicy* policy = AcceleratorMMUPolicy::Instance();
 
+  if (staleMSHRs.find(vp_base) != staleMSHRs.end()) {
+    // replies are matched by page only, so the previous tenant's request
+    // for this page has to be answered before ours goes out
+    staleWaiters[vp_base].push_back(td);
+    return;
+  }
   
-  if (tlbMemory->lookup(vp_base, pp_base)) {
+  if (policy->HasDeviceTLB() &&
+      tlbMemory->lookup(currentASID, vp_base, pp_base)) {
     hits++;
+
+    if (prefetchedPages.erase(vp_base)) {
+      prefetchUseful++;
+    }
+
+    if (!policy->VerifyHits() ||
+        verifiedPages.find(vp_base) != verifiedPages.end()) {
+      // translation is trusted or was verified when it was prefetched
+      TranslationTrace::record(TranslationTrace::Issue, network->GetNodeID(),
+                               vp_base, pp_base, TranslationTrace::TLBHit,
+                               currentASID);
+      td->setPaddr(pp_base + offset);
+      td->MAC_ver = 1;
+      dmaInterface->finishTranslation(dmaDevice, td);
+      return;
+    }
+
+    if (policy->ForwardReadsOnHit() && td->isRead()) {
+      // the read goes ahead, the check of the page is sent once and its
+      // reply only retires the MSHRs of writes that arrive meanwhile
+      td->setPaddr(pp_base + offset);
+      td->MAC_ver = 1;
+      dmaInterface->finishTranslation(dmaDevice, td);
+
+      if (readsVerifying.find(vp_base) != readsVerifying.end() ||
+          MSHRs.find(vp_base) != MSHRs.end()) {
+        return;
+      }
+
+      readsVerifying.insert(vp_base);
+      MAC_verfication++;
+      TranslationTrace::record(TranslationTrace::Issue, network->GetNodeID(),
+                               vp_base, pp_base, TranslationTrace::Verify,
+                               currentASID);
+      translationIssued.insert(std::make_pair(vp_base, GetSystemTime()));
+      onTLBMiss->Call(vp_base, 1, pp_base);
+      return;
+    }
+
     //BCCMshrhits++;
     //std::cout <<"No Read Acceleration is running" << std::endl;
+    if (MSHRs.empty()) {
+      // the transfer waits on the check as it would on a walk
+      transferStatus = TlbWait;
+      timeStamp = GetSystemTime();
+    }
+
     td->setPaddr(pp_base + offset);
     td->MAC_ver =1; //if it is a read request immediately finish translation
+
+    if (RubySystem::MergeWriteChecks() &&
+        (readsVerifying.find(vp_base) != readsVerifying.end() ||
+         MSHRs.find(vp_base) != MSHRs.end())) {
+      // a check of this page is already in flight, its reply retires us
+      MSHRs[vp_base].push_back(td);
+      return;
+    }
+
     MSHRs[vp_base].push_back(td);
     MAC_dma =1;
     MAC_verfication++;
     //std::cout <<"MAC_verifcation" << hits << std::endl;
+    TranslationTrace::record(TranslationTrace::Issue, network->GetNodeID(),
+                             vp_base, pp_base, TranslationTrace::Verify,
+                             currentASID);
+    translationIssued.insert(std::make_pair(vp_base, GetSystemTime()));
     onTLBMiss->Call(vp_base, MAC_dma,pp_base);
   }
   else
   {
     misses++;
+
+    if (prefetchedPages.erase(vp_base)) {
+      // evicted before the demand stream got there
+      prefetchUseless++;
+    }
+
+    verifiedPages.erase(vp_base);
     //std::cout <<"Miss in LcAcc TLB" << std::endl;
     if (MSHRs.empty()) {
       transferStatus = TlbWait;
@@ -191,6 +312,17 @@ DMAController::translateTiming(TransferData* td)
     MAC_dma =0;
     pp_base=0;
     MSHRs[vp_base].push_back(td);
+    TranslationTrace::record(TranslationTrace::Issue, network->GetNodeID(),
+                             vp_base, 0, TranslationTrace::TLBMiss,
+                             currentASID);
+
+    if (prefetchInFlight.find(vp_base) != prefetchInFlight.end()) {
+      // the prefetch walk for this page is still outstanding
+      prefetchLate++;
+      return;
+    }
+
+    translationIssued.insert(std::make_pair(vp_base, GetSystemTime()));
     onTLBMiss->Call(vp_base, MAC_dma,pp_base);
 
   }
@@ -399,10 +531,115 @@ DMAController::BeginTransfer(int srcSpm, uint64_t srcAddr,
 void
 DMAController::PrefetchMemory(uint64_t baseAddr,
                               const std::vector<unsigned int>& size,
-                              const std::vector<int>& stride, size_t elementSize)
+                              const std::vector<int>& stride, size_t elementSize,
+                              bool isRead)
+{
+  assert(size.size() == stride.size());
+
+  if (size.empty()) {
+    return;
+  }
+
+  PolyhedralAddresser pa(baseAddr, size, stride);
+  uint64_t blockSize = RubySystem::getBlockSizeBytes();
+  // key virtual page, value blocks of the transfer within that page
+  std::map<uint64_t, std::set<uint64_t> > pages;
+
+  for (uint32_t i = 0; i < pa.TotalSize(); i++) {
+    uint64_t addr = pa.GetAddr(i);
+    uint64_t last = addr + elementSize - 1;
+
+    for (uint64_t block = addr - addr % blockSize; block <= last;
+         block += blockSize) {
+      pages[GetPageAddr(block)].insert(block);
+    }
+  }
+
+  std::map<uint64_t, std::set<uint64_t> >::iterator it;
+
+  for (it = pages.begin(); it != pages.end(); it++) {
+    uint64_t vp_base = it->first;
+    uint64_t pp_base;
+
+    if (tlbMemory->lookup(currentASID, vp_base, pp_base, false)) {
+      if (isRead) {
+        PrefetchBlocks(vp_base, pp_base, it->second);
+      }
+
+      continue;
+    }
+
+    if (MSHRs.find(vp_base) != MSHRs.end() ||
+        staleMSHRs.find(vp_base) != staleMSHRs.end()) {
+      // demand walk already outstanding
+      continue;
+    }
+
+    if (isRead) {
+      prefetchBlocks[vp_base].insert(it->second.begin(), it->second.end());
+    }
+
+    if (prefetchInFlight.find(vp_base) != prefetchInFlight.end()) {
+      continue;
+    }
+
+    prefetchIssued++;
+    prefetchInFlight.insert(vp_base);
+    onTLBMiss->Call(vp_base, 0, 0);
+  }
+}
+
+bool
+DMAController::FinishPrefetch(uint64_t vp_base, uint64_t pp_base, uint64_t MAC)
+{
+  if (MAC == 0 && prefetchInFlight.erase(vp_base)) {
+    tlbMemory->insert(currentASID, spm->GetID(), vp_base, pp_base);
+
+    if (MSHRs.find(vp_base) == MSHRs.end()) {
+      // verify the fresh translation before the demand stream needs it
+      prefetchedPages.insert(vp_base);
+      prefetchVerifying.insert(vp_base);
+      onTLBMiss->Call(vp_base, 1, pp_base);
+    }
+
+    if (prefetchBlocks.find(vp_base) != prefetchBlocks.end()) {
+      PrefetchBlocks(vp_base, pp_base, prefetchBlocks[vp_base]);
+      prefetchBlocks.erase(vp_base);
+    }
+
+    return true;
+  }
+
+  if (MAC != 0 && prefetchVerifying.erase(vp_base)) {
+    prefetchVerified++;
+    verifiedPages.insert(vp_base);
+    return true;
+  }
+
+  return false;
+}
+
+void
+DMAController::PrefetchBlocks(uint64_t vp_base, uint64_t pp_base,
+                              const std::set<uint64_t>& blocks)
 {
-  dmaInterface->Prefetch(dmaDevice, baseAddr, size.size(),
-                         &(size[0]), &(stride[0]), elementSize);
+  std::set<uint64_t>::const_iterator it;
+
+  for (it = blocks.begin(); it != blocks.end(); it++) {
+    dmaInterface->PrefetchBlock(dmaDevice, *it, pp_base + (*it - vp_base));
+  }
+}
+
+uint64_t
+DMAController::getDataPrefetches()
+{
+  return dmaDevice->ptd->getPrefetchesIssued();
+}
+
+uint64_t
+DMAController::getDataPrefetchesMerged()
+{
+  return dmaDevice->ptd->getPrefetchesMerged();
 }
 
 void
@@ -416,6 +653,107 @@ DMAController::FlushTLB()
 {
   flushTlb++;
   tlbMemory->flushAll();
+  // replies to outstanding walks and checks must not refill the TLB
+  RetireTenantRequests();
+}
+
+// Called when a process exits or its id is handed to a new process. Returns
+// whether the accelerator translated for it, in which case the caller also
+// drops the device's protection entries.
+bool
+DMAController::FlushASID(unsigned int asid)
+{
+  tlbMemory->flushASID(asid);
+
+  if (asid == currentASID) {
+    RetireTenantRequests();
+  }
+
+  return servedASIDs.erase(asid) > 0;
+}
+
+void
+DMAController::SetASID(unsigned int asid)
+{
+  servedASIDs.insert(asid);
+
+  if (asid == currentASID) {
+    return;
+  }
+
+  // entries of the previous tenant stay in the TLB for when it returns;
+  // only the bookkeeping, which is not tagged, is dropped
+  RetireTenantRequests();
+  currentASID = asid;
+}
+
+// Drops the untagged state of the current tenant. Its outstanding requests
+// become stale: their replies still finish the transfers waiting on them,
+// but are neither cached nor handed to the next tenant.
+void
+DMAController::RetireTenantRequests()
+{
+  std::set<uint64_t> outstanding(prefetchInFlight);
+  outstanding.insert(prefetchVerifying.begin(), prefetchVerifying.end());
+  outstanding.insert(readsVerifying.begin(), readsVerifying.end());
+
+  std::set<uint64_t>::iterator page;
+
+  for (page = outstanding.begin(); page != outstanding.end(); page++) {
+    staleMSHRs[*page];
+  }
+
+  std::map<uint64_t, std::list<TransferData*> >::iterator it;
+
+  for (it = MSHRs.begin(); it != MSHRs.end(); it++) {
+    std::list<TransferData*>& stale = staleMSHRs[it->first];
+    stale.splice(stale.end(), it->second);
+  }
+
+  if (!MSHRs.empty()) {
+    transferStatus = Running;
+    tlbCycles += GetSystemTime() - timeStamp;
+  }
+
+  MSHRs.clear();
+  translationIssued.clear();
+  prefetchUseless += prefetchedPages.size();
+  prefetchedPages.clear();
+  verifiedPages.clear();
+  readsVerifying.clear();
+  prefetchInFlight.clear();
+  prefetchVerifying.clear();
+  prefetchBlocks.clear();
+}
+
+bool
+DMAController::FinishStaleRequest(uint64_t vp_base, uint64_t pp_base)
+{
+  std::map<uint64_t, std::list<TransferData*> >::iterator stale =
+    staleMSHRs.find(vp_base);
+
+  if (stale == staleMSHRs.end()) {
+    return false;
+  }
+
+  std::list<TransferData*>::iterator it;
+
+  for (it = stale->second.begin(); it != stale->second.end(); it++) {
+    (*it)->setPaddr(pp_base + (*it)->getVaddr() % TheISA::PageBytes);
+    dmaInterface->finishTranslation(dmaDevice, *it);
+  }
+
+  staleMSHRs.erase(stale);
+
+  std::list<TransferData*> waiting;
+  waiting.swap(staleWaiters[vp_base]);
+  staleWaiters.erase(vp_base);
+
+  for (it = waiting.begin(); it != waiting.end(); it++) {
+    translateTiming(*it);
+  }
+
+  return true;
 }
 
 void
@@ -426,7 +764,7 @@ DMAController::AddTLBEntry(uint64_t vAddr, uint64_t pAddr)
 
   assert(vAddr - vp_base == pAddr - pp_base);
 
-  tlbMemory->insert(vp_base, pp_base);
+  tlbMemory->insert(currentASID, spm->GetID(), vp_base, pp_base);
 }
 
 void
@@ -480,13 +818,38 @@ TLBMemory::flushAll()
   }
 }
 
+void
+TLBMemory::flushASID(unsigned int asid)
+{
+  for (int set = 0; set < sets; set++) {
+    for (int assc = 0; assc < assoc; assc++) {
+      if (!entries[set][assc].free && entries[set][assc].asid == asid) {
+        entries[set][assc].free = true;
+      }
+    }
+  }
+}
+
+void
+TLBMemory::flushDevice(int deviceID)
+{
+  for (int set = 0; set < sets; set++) {
+    for (int assc = 0; assc < assoc; assc++) {
+      if (!entries[set][assc].free && entries[set][assc].deviceID == deviceID) {
+        entries[set][assc].free = true;
+      }
+    }
+  }
+}
+
 bool
-TLBMemory::lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru)
+TLBMemory::lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru)
 {
   int set = (vp_base / TheISA::PageBytes) % sets;
   //std::cout << "set" << set << std::endl;
   for (int i = 0; i < assoc; i++) {
-    if (entries[set][i].vpBase == vp_base && !entries[set][i].free) {
+    if (entries[set][i].vpBase == vp_base && entries[set][i].asid == asid &&
+        !entries[set][i].free) {
       pp_base = entries[set][i].ppBase;
       assert(entries[set][i].mruTick > 0);
 
@@ -503,11 +866,11 @@ TLBMemory::lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru)
 }
 
 void
-TLBMemory::insert(uint64_t vp_base, uint64_t pp_base)
+TLBMemory::insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base)
 {
   uint64_t a;
 
-  if (lookup(vp_base, a)) {
+  if (lookup(asid, vp_base, a)) {
     return;
   }
 
@@ -527,6 +890,8 @@ TLBMemory::insert(uint64_t vp_base, uint64_t pp_base)
 
   assert(entry);
 
+  entry->asid = asid;
+  entry->deviceID = deviceID;
   entry->vpBase = vp_base;
   entry->ppBase = pp_base;
   entry->free = false;
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <map>
+#include <set>
 #include <vector>
 #include <list>
 #include <string>
@@ -11,18 +12,24 @@
 #include "modules/Common/BaseCallbacks.hh"
 #include "modules/linked-prefetch-tile/prefetcher-tile.hh"
 #include "modules/MsgLogger/MsgLogger.hh"
+#include "base/statistics.hh"
 
 namespace LCAcc
 {
 
+// Entries carry the process (asid) they translate for and the device that
+// installed them, so a tenant switch or a device reset only has to drop the
+// entries it owns.
 class TLBEntry
 {
 public:
+  unsigned int asid;
+  int deviceID;
   uint64_t vpBase;
   uint64_t ppBase;
   bool free;
   uint64_t mruTick;
-  TLBEntry() : vpBase(0), ppBase(0), free(true), mruTick(0) {}
+  TLBEntry() : asid(0), deviceID(-1), vpBase(0), ppBase(0), free(true), mruTick(0) {}
   void setMRU()
   {
     mruTick = GetSystemTime();
@@ -32,9 +39,11 @@ public:
 class BaseTLBMemory
 {
 public:
-  virtual bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true) = 0;
-  virtual void insert(uint64_t vp_base, uint64_t pp_base) = 0;
+  virtual bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true) = 0;
+  virtual void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base) = 0;
   virtual void flushAll() = 0;
+  virtual void flushASID(unsigned int asid) = 0;
+  virtual void flushDevice(int deviceID) = 0;
 };
 // assoc mean associativity
 // sets mean set
@@ -75,35 +84,60 @@ public:
     delete [] entries;
   }
 
-  virtual bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true);
-  virtual void insert(uint64_t vp_base, uint64_t pp_base);
+  virtual bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true);
+  virtual void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base);
   virtual void flushAll();
+  virtual void flushASID(unsigned int asid);
+  virtual void flushDevice(int deviceID);
 };
 
 class InfiniteTLBMemory : public BaseTLBMemory
 {
-  std::map<uint64_t, uint64_t> entries;
+  //key <asid, virtual page>
+  std::map<std::pair<unsigned int, uint64_t>, TLBEntry> entries;
 public:
   InfiniteTLBMemory() {}
   ~InfiniteTLBMemory() {}
 
-  bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true)
+  bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true)
   {
-    auto it = entries.find(vp_base);
+    auto it = entries.find(std::make_pair(asid, vp_base));
     if (it != entries.end()) {
-      pp_base = it->second;
+      pp_base = it->second.ppBase;
       return true;
     } else {
       pp_base = 0;
       return false;
     }
   }
-  void insert(uint64_t vp_base, uint64_t pp_base)
+  void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base)
   {
-    entries[vp_base] = pp_base;
+    TLBEntry& e = entries[std::make_pair(asid, vp_base)];
+    e.asid = asid;
+    e.deviceID = deviceID;
+    e.vpBase = vp_base;
+    e.ppBase = pp_base;
+    e.free = false;
   }
   void flushAll() {}
-          
+  void flushASID(unsigned int asid)
+  {
+    auto it = entries.lower_bound(std::make_pair(asid, (uint64_t)0));
+
+    while (it != entries.end() && it->first.first == asid) {
+      entries.erase(it++);
+    }
+  }
+  void flushDevice(int deviceID)
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->second.deviceID == deviceID) {
+        entries.erase(it++);
+      } else {
+        it++;
+      }
+    }
+  }
 };
 
 class DMAController
@@ -152,15 +186,47 @@ private:
   typedef Arg1MemberCallback<DMAController, uint64_t, &DMAController::OnAccessError> OnAccessErrorCB;
   typedef Arg3MemberCallback<DMAController, int, const void*, unsigned int, &DMAController::OnNetworkMsg> OnNetworkMsgCB;
   bool isHookedToMemory;
+  // process whose translations the accelerator currently uses
+  unsigned int currentASID;
+
+  // Translation prefetch. Pages of upcoming transfers are walked (and
+  // verified) ahead of the demand stream; data blocks follow once the
+  // translation is known.
+  std::set<uint64_t> prefetchInFlight;
+  std::set<uint64_t> prefetchVerifying;
+  //prefetched pages not yet touched by a demand access
+  std::set<uint64_t> prefetchedPages;
+  //pages whose translation was verified ahead, cleared on TLB flush
+  std::set<uint64_t> verifiedPages;
+  //pages whose reads were forwarded on a hit and whose check is in flight
+  std::set<uint64_t> readsVerifying;
+  //key virtual page, value virtual block addresses waiting on the walk
+  std::map<uint64_t, std::set<uint64_t> > prefetchBlocks;
+  //key virtual page, value cycle its walk or verification was requested
+  std::map<uint64_t, uint64_t> translationIssued;
+  //processes the accelerator has translated for since they last exited
+  std::set<unsigned int> servedASIDs;
+  //key virtual page with a request of a switched out tenant outstanding,
+  //value its transfers, finished by the reply but not cached
+  std::map<uint64_t, std::list<TransferData*> > staleMSHRs;
+  //key virtual page, value misses of the current tenant held back until
+  //the stale reply for the page is in
+  std::map<uint64_t, std::list<TransferData*> > staleWaiters;
+  bool FinishPrefetch(uint64_t vp_base, uint64_t pp_base, uint64_t MAC);
+  void PrefetchBlocks(uint64_t vp_base, uint64_t pp_base, const std::set<uint64_t>& blocks);
+  void RetireTenantRequests();
+  bool FinishStaleRequest(uint64_t vp_base, uint64_t pp_base);
 public:
   DMAController(NetworkInterface* ni, SPMInterface* spmInterface, Arg3CallbackBase<uint64_t, uint64_t, uint64_t>* TLBMiss, Arg1CallbackBase<uint64_t>* accessViolation, Arg1CallbackBase<uint64_t>* MACver);
   ~DMAController();
   void BeginTransfer(int srcSpm, uint64_t srcAddr, const std::vector<unsigned int>& srcSize, const std::vector<int>& srcStride, int dstSpm, uint64_t dstAddr, const std::vector<unsigned int>& dstSize, const std::vector<int>& dstStride, size_t elementSize, CallbackBase* finishedCB);
   void BeginTransfer(int srcSpm, uint64_t srcAddr, const std::vector<unsigned int>& srcSize, const std::vector<int>& srcStride, int dstSpm, uint64_t dstAddr, const std::vector<unsigned int>& dstSize, const std::vector<int>& dstStride, size_t elementSize, int priority, CallbackBase* finishedCB);
-  void PrefetchMemory(uint64_t baseAddr, const std::vector<unsigned int>& size, const std::vector<int>& stride, size_t elementSize);
+  void PrefetchMemory(uint64_t baseAddr, const std::vector<unsigned int>& size, const std::vector<int>& stride, size_t elementSize, bool isRead);
   void BeginSingleElementTransfer(int mySPM, uint64_t src, uint64_t dst, uint32_t size, int type, CallbackBase* finishedCB);
   void SetBuffer(int buf);
   void FlushTLB();
+  bool FlushASID(unsigned int asid);
+  void SetASID(unsigned int asid);
   void AddTLBEntry(uint64_t vAddr, uint64_t pAddr);
   void HookToMemoryController(const std::string& deviceName);
 
@@ -192,6 +258,14 @@ protected:
   TransferStatus transferStatus;
   uint64_t timeStamp;
   uint64_t MAC_verfication=0;
+  uint64_t prefetchIssued;
+  uint64_t prefetchUseful;
+  uint64_t prefetchLate;
+  uint64_t prefetchUseless;
+  uint64_t prefetchVerified;
+  // request to reply, TLB hits sent for MAC verification and TLB misses
+  Stats::Histogram verifyLatencyHist;
+  Stats::Histogram missLatencyHist;
 
 public:
   // private TLB entries
@@ -240,6 +314,36 @@ public:
   {
     return BCCMshrhits;
   }
+  uint64_t getPrefetchIssued()
+  {
+    return prefetchIssued;
+  }
+  uint64_t getPrefetchUseful()
+  {
+    return prefetchUseful;
+  }
+  uint64_t getPrefetchLate()
+  {
+    return prefetchLate;
+  }
+  uint64_t getPrefetchUseless()
+  {
+    return prefetchUseless;
+  }
+  uint64_t getPrefetchVerified()
+  {
+    return prefetchVerified;
+  }
+  Stats::Histogram& getVerifyLatencyHist()
+  {
+    return verifyLatencyHist;
+  }
+  Stats::Histogram& getMissLatencyHist()
+  {
+    return missLatencyHist;
+  }
+  uint64_t getDataPrefetches();
+  uint64_t getDataPrefetchesMerged();
 };
 
 }
@@ -1,9 +1,11 @@
 #include "LCAccDevice.hh"
 #include "SimicsInterface.hh"
 #include "DMAController.hh"
+#include "ComputePool.hh"
 #include "SPMInterface.hh"
 #include "NetworkInterface.hh"
 #include "memInterface.hh"
+#include "ProtectionMemobj.hh"
 #include <iostream>
 #include <fstream>
 #include <cassert>
@@ -41,7 +43,7 @@ LCAccDevice::PrefetchOrder(const TransferOrder& to)
   const EndNodeTransferData& entd =
     (to.src.spm == NO_SPM_ID) ? to.src : to.dst;
   dma->PrefetchMemory(entd.addr, entd.sizeSet, entd.strideSet,
-                      to.elementSize);
+                      to.elementSize, to.src.spm == NO_SPM_ID);
 }
 
 void
@@ -228,17 +230,36 @@ LCAccDevice::PerformComputeElement(ComputeElement* ce)
   assert(ce->host->mode);
   assert(ce->host->computesToFinish > 0);
 
-  std::vector<uint64_t> seedAddrs;
-
   for (size_t i = 0; i < ce->host->argumentAddressGen.size(); i++) {
-    seedAddrs.push_back(ce->host->CalcArgAddress(i, ce->index));
+    ce->seedAddrs.push_back(ce->host->CalcArgAddress(i, ce->index));
+  }
+
+  if (ComputePool::Instance()->IsParallel()) {
+    ComputePool::Instance()->Defer(spm->GetID(),
+                                   RunComputeKernelCB::Create(this, ce),
+                                   FinishComputeElementCB::Create(this, ce));
+    return;
   }
 
+  RunComputeKernel(ce);
+  FinishComputeElement(ce);
+}
+
+// Only touches the scratch pad and the operating mode of this device, it
+// may run on a ComputePool thread.
+void
+LCAccDevice::RunComputeKernel(ComputeElement* ce)
+{
   ce->host->mode->Compute(ce->index, ce->maxCompute, ce->taskID,
-                          seedAddrs, ce->host->argumentActive);
+                          ce->seedAddrs, ce->host->argumentActive);
+}
+
+void
+LCAccDevice::FinishComputeElement(ComputeElement* ce)
+{
   std::vector<uint64_t> writeAddrs;
   ce->host->mode->GetSPMWriteIndexSet(ce->index, ce->maxCompute,
-                                      ce->taskID, seedAddrs, ce->host->argumentActive, writeAddrs);
+                                      ce->taskID, ce->seedAddrs, ce->host->argumentActive, writeAddrs);
   ce->writesRemaining = writeAddrs.size();
   ce->randomAccessesRemaining = ce->host->mode->MemoryAccessCount();
   ce->host->computesToFinish--;
@@ -510,7 +531,13 @@ LCAccDevice::ProtectionTableAccess()
       cout_protection++;
       //std::cout << "Protection verfication Count" << cout_protection << std::endl;
           
-          dma->finishTranslation(vAddr, pAddr,MAC_return);
+          // a delivered translation lets this device reach the page in memory
+    if (pAddr) {
+      ProtectionMemobj::setPermissionAll(pAddr, GetNodeID(),
+                                         PROT_PERM_READ | PROT_PERM_WRITE);
+    }
+
+    dma->finishTranslation(vAddr, pAddr,MAC_return);
     }
     
     if(protection_table_request.size())
@@ -535,6 +562,12 @@ LCAccDevice::TimedReadComplete()
     {
     std::cout << "data" << data << std::endl;
     std::cout << "address" << addr << std::endl;
+    // a delivered translation lets this device reach the page in memory
+    if (pAddr) {
+      ProtectionMemobj::setPermissionAll(pAddr, GetNodeID(),
+                                         PROT_PERM_READ | PROT_PERM_WRITE);
+    }
+
     dma->finishTranslation(vAddr, pAddr,MAC_return);
     }
     */
@@ -568,7 +601,8 @@ void LCAccDevice::MsgHandler(int src, const void* packet, unsigned int packetSiz
     bufferID = msg[2];
     bufferSize = msg[3];//unused for the time being
     assert(bufferID == -1 || bufferSize > 0);
-    dma->FlushTLB();
+    // switch address spaces instead of flushing; entries are asid tagged
+    dma->SetASID(process);
 
     spm->SetBuffer(bufferID);
     dma->SetBuffer(bufferID);
@@ -600,6 +634,8 @@ void LCAccDevice::MsgHandler(int src, const void* packet, unsigned int packetSiz
     if (t.startingAddress) {
       assert(pAddr);
       dma->AddTLBEntry(t.startingAddress, pAddr);
+      ProtectionMemobj::setPermissionAll(pAddr, GetNodeID(),
+                                         PROT_PERM_READ | PROT_PERM_WRITE);
     }
 
     t.bufferSize = msg[6];
@@ -636,6 +672,7 @@ void LCAccDevice::MsgHandler(int src, const void* packet, unsigned int packetSiz
 
     // dma->FlushTLB();
     // ML_LOG(GetDeviceName(), "Flushing DMA TLB");
+    dma->SetASID(process);
 
     spm->SetBuffer(bufferID);
     dma->SetBuffer(bufferID);
@@ -668,6 +705,12 @@ void LCAccDevice::MsgHandler(int src, const void* packet, unsigned int packetSiz
     //ML_LOG(GetDeviceName(), "END TLB miss 0x" << std::hex << vAddr);
     //ML_LOG(GetDeviceName(), "TLB miss serviced 0x" << std::hex
     //    << vAddr << " -> 0x" << pAddr);
+    // a delivered translation lets this device reach the page in memory
+    if (pAddr) {
+      ProtectionMemobj::setPermissionAll(pAddr, GetNodeID(),
+                                         PROT_PERM_READ | PROT_PERM_WRITE);
+    }
+
     dma->finishTranslation(vAddr, pAddr,MAC_return);
   
     
@@ -767,18 +810,20 @@ LCAccDevice::ParseTaskSignature(PacketReader& pr)
     tdSet.push_back(td);
   }
 
-  if (pr.SizeRemaining() > 2 * sizeof(uint32_t) + sizeof(uint64_t)) {
+  if (pr.SizeRemaining() >= sizeof(uint32_t) + 2 * sizeof(uint64_t)) {
     // TLB preload entries
     uint32_t tlbCounter = pr.Read<uint32_t>();
     //ML_LOG(GetDeviceName(), "Preload TLB with "
     //       << tlbCounter << "entries");
 
     for (uint32_t i = 0; i < tlbCounter; i++) {
-      uint32_t logicalPage = pr.Read<uint32_t>();
+      uint64_t logicalPage = pr.Read<uint64_t>();
       uint64_t physicalPage = pr.Read<uint64_t>();
       //ML_LOG(GetDeviceName(), "0x" << std::hex << logicalPage
       //       << " -> 0x" << std::hex << physicalPage);
       dma->AddTLBEntry(logicalPage, physicalPage);
+      ProtectionMemobj::setPermissionAll(physicalPage, GetNodeID(),
+                                         PROT_PERM_READ | PROT_PERM_WRITE);
     }
   }
 
@@ -956,7 +1001,6 @@ LCAccDevice::ParseTaskSignature(PacketReader& pr)
       //std::cout << "[" << (int32_t)controlRegisterValue[x] << "] ";
     }
 
-    std::cout << std::endl;
     unsigned int computeSize = 0;
     std::vector<PolyhedralAddresser> argAddr;
     std::vector<uint32_t> argSize;
@@ -36,6 +36,8 @@ class LCAccDevice
     size_t writesRemaining;
     size_t randomAccessesRemaining;
     bool hasComputed;
+    // argument addresses of this element, taken when it computes
+    std::vector<uint64_t> seedAddrs;
   };
   class ComputeOrder
   {
@@ -204,6 +206,8 @@ class LCAccDevice
   void IssueComputeElement(ComputeElement* ce);
   void AnnounceComputeBegin(ComputeElement* ce);
   void PerformComputeElement(ComputeElement* ce);
+  void RunComputeKernel(ComputeElement* ce);
+  void FinishComputeElement(ComputeElement* ce);
   void ComputeRandomAccessComplete(ComputeElement* ce, int iteration, int maxIteration, int taskID, uint64_t spmAddr, uint64_t memAddr, int accessType);
   void SPMWriteComplete(ComputeElement* ce);
   void TryRetireComputeElement(ComputeElement* ce);
@@ -242,6 +246,8 @@ class LCAccDevice
   typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::IssueComputeElement> IssueComputeElementCB;
   typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::AnnounceComputeBegin> AnnounceComputeBeginCB;
   typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::PerformComputeElement> PerformComputeElementCB;
+  typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::RunComputeKernel> RunComputeKernelCB;
+  typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::FinishComputeElement> FinishComputeElementCB;
   typedef MemberCallback7<LCAccDevice, ComputeElement*, int, int, int, uint64_t, uint64_t, int, &LCAccDevice::ComputeRandomAccessComplete> ComputeRandomAccessCompleteCB;
   typedef MemberCallback1<LCAccDevice, ComputeElement*, &LCAccDevice::SPMWriteComplete> SPMWriteCompleteCB;
   typedef MemberCallback2<LCAccDevice, LCAccDevice::Action*, size_t, &LCAccDevice::FinishedActionRead> FinishedActionReadCB;
@@ -311,6 +317,10 @@ public:
   {
     return dma;
   }
+  int GetNodeID()
+  {
+    return netPort->GetNodeID();
+  }
 
 };
 }
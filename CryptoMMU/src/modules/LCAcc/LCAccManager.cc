@@ -1,11 +1,13 @@
 #include "LCAccManager.hh"
 #include <cassert>
+#include "base/trace.hh"
+#include "debug/CryptoMMU.hh"
 
 namespace LCAcc
 {
 void LCAccManager::SetTiming(int deviceHandle, int CycleTime, int PipelineDepth, int InitiationInterval)
 {
-  std::cout << "SetTiming for Device " << deviceHandle << "CycleTime: " << CycleTime << "PipelineDepth: " << PipelineDepth << "InitiationInterval: " << InitiationInterval << std::endl;
+  DPRINTFR(CryptoMMU, "SetTiming for Device %d CycleTime: %d PipelineDepth: %d InitiationInterval: %d\n", deviceHandle, CycleTime, PipelineDepth, InitiationInterval);
   deviceSet[deviceHandle]->SetTiming(CycleTime, PipelineDepth, InitiationInterval);
 }
 void LCAccManager::RegisterDevice(int deviceHandle)
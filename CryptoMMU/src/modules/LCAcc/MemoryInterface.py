@@ -8,3 +8,6 @@ class MemoryInterface(MemObject):
 
     master_port = MasterPort("Accelerator Master Port")
     system = Param.System(Parent.any, "system")
+    port_id = Param.Int(-1, "accelerator port index, -1 for the shared interface")
+    max_outstanding = Param.UInt32(16, "max number of timing requests in flight")
+    protection_port = Param.Bool(False, "reserved for protection table fetches")
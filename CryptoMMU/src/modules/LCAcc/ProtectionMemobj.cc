@@ -30,45 +30,152 @@
 
 #include "modules/LCAcc/ProtectionMemobj.hh"
 
-//#include "debug/ProtectionMemobj.hh"
+#include <cstdint>
+#include <cstring>
+
+#include "debug/ProtectionMemobj.hh"
+
+std::vector<ProtectionMemobj *> ProtectionMemobj::instances;
+
+PermissionCache::PermissionCache(unsigned _numEntries, unsigned associativity) :
+    numEntries(_numEntries), assoc(associativity)
+{
+    if (assoc == 0) {
+        assoc = numEntries;
+    }
+
+    assert(numEntries % assoc == 0);
+    sets = numEntries / assoc;
+    entries = new PermissionLine*[sets];
+
+    for (unsigned i = 0; i < sets; i++) {
+        entries[i] = new PermissionLine[assoc];
+    }
+}
+
+PermissionCache::~PermissionCache()
+{
+    for (unsigned i = 0; i < sets; i++) {
+        delete [] entries[i];
+    }
+
+    delete [] entries;
+}
+
+bool
+PermissionCache::lookup(Addr line_addr)
+{
+    PermissionLine *set =
+        entries[(line_addr / ProtectionTableLayout::lineBytes()) % sets];
+
+    for (unsigned i = 0; i < assoc; i++) {
+        if (set[i].valid && set[i].lineAddr == line_addr) {
+            set[i].mruTick = curTick();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+PermissionCache::insert(Addr line_addr)
+{
+    PermissionLine *set =
+        entries[(line_addr / ProtectionTableLayout::lineBytes()) % sets];
+    unsigned victim = 0;
+
+    for (unsigned i = 0; i < assoc; i++) {
+        if (!set[i].valid) {
+            victim = i;
+            break;
+        }
+
+        if (set[i].mruTick < set[victim].mruTick) {
+            victim = i;
+        }
+    }
+
+    set[victim].lineAddr = line_addr;
+    set[victim].valid = true;
+    set[victim].mruTick = curTick();
+}
+
+void
+PermissionCache::invalidate(Addr line_addr)
+{
+    PermissionLine *set =
+        entries[(line_addr / ProtectionTableLayout::lineBytes()) % sets];
+
+    for (unsigned i = 0; i < assoc; i++) {
+        if (set[i].valid && set[i].lineAddr == line_addr) {
+            set[i].valid = false;
+        }
+    }
+}
+
+void
+PermissionCache::flushAll()
+{
+    for (unsigned i = 0; i < sets; i++) {
+        for (unsigned j = 0; j < assoc; j++) {
+            entries[i][j].valid = false;
+        }
+    }
+}
 
 ProtectionMemobj::ProtectionMemobj(ProtectionMemobjParams *params) :
     MemObject(params),
     instPort(params->name + ".inst_port", this),
     dataPort(params->name + ".data_port", this),
     memPort(params->name + ".mem_side", this),
-    blocked(false)
+    maxOutstanding(params->max_outstanding),
+    checkLatency(params->check_latency),
+    tableLatency(params->table_latency),
+    speculativeForward(params->speculative_forward),
+    allowUntracked(params->allow_untracked),
+    permCache(params->perm_cache_entries, params->perm_cache_assoc),
+    checkEvent(this)
 {
+    assert(maxOutstanding > 0);
+    instances.push_back(this);
 }
 
-Port&
-ProtectionMemobj::getPort(const std::string& if_name, PortID idx)
+BaseMasterPort&
+ProtectionMemobj::getMasterPort(const std::string& if_name, PortID idx)
+{
+    panic_if(idx != InvalidPortID, "This object doesn't support vector ports");
+
+    // This is the name from the Python SimObject declaration in
+    // Protectiontable.py
+    if (if_name == "mem_side") {
+        return memPort;
+    } else {
+        // pass it along to our super class
+        return MemObject::getMasterPort(if_name, idx);
+    }
+}
+
+BaseSlavePort&
+ProtectionMemobj::getSlavePort(const std::string& if_name, PortID idx)
 {
     panic_if(idx != InvalidPortID, "This object doesn't support vector ports");
 
-    // This is the name from the Python SimObject declaration in SimpleCache.py
     if (if_name == "inst_port") {
         return instPort;
     } else if (if_name == "data_port") {
         return dataPort;
-    } else if (if_name == "mem_side") {
-        return memPort;
     } else {
-        // pass it along to our super class
-        return MemObject::getPort(if_name, idx);
+        return MemObject::getSlavePort(if_name, idx);
     }
 }
 
 void
 ProtectionMemobj::CPUSidePort::sendPacket(PacketPtr pkt)
 {
-    // Note: This flow control is very simple since the memobj is blocking.
-
-    panic_if(blockedPacket != nullptr, "Should never try to send if blocked!");
-
-    // If we can't send the packet across the port, store it for later.
-    if (!sendTimingResp(pkt)) {
-        blockedPacket = pkt;
+    // Keep responses in order: once one is blocked, queue the rest behind it
+    if (!blockedPackets.empty() || !sendTimingResp(pkt)) {
+        blockedPackets.push_back(pkt);
     }
 }
 
@@ -81,11 +188,10 @@ ProtectionMemobj::CPUSidePort::getAddrRanges() const
 void
 ProtectionMemobj::CPUSidePort::trySendRetry()
 {
-    if (needRetry && blockedPacket == nullptr) {
-        // Only send a retry if the port is now completely free
+    if (needRetry) {
         needRetry = false;
-        DPRINTF(ProtectionMemobj, "Sending retry req for %d\n", id);
-        sendRetryReq();
+        DPRINTF(ProtectionMemobj, "Sending retry req for %s\n", name());
+        sendRetry();
     }
 }
 
@@ -100,7 +206,7 @@ bool
 ProtectionMemobj::CPUSidePort::recvTimingReq(PacketPtr pkt)
 {
     // Just forward to the memobj.
-    if (!owner->handleRequest(pkt)) {
+    if (!owner->handleRequest(pkt, this)) {
         needRetry = true;
         return false;
     } else {
@@ -109,29 +215,26 @@ ProtectionMemobj::CPUSidePort::recvTimingReq(PacketPtr pkt)
 }
 
 void
-ProtectionMemobj::CPUSidePort::recvRespRetry()
+ProtectionMemobj::CPUSidePort::recvRetry()
 {
     // We should have a blocked packet if this function is called.
-    assert(blockedPacket != nullptr);
+    assert(!blockedPackets.empty());
 
-    // Grab the blocked packet.
-    PacketPtr pkt = blockedPacket;
-    blockedPacket = nullptr;
+    while (!blockedPackets.empty()) {
+        // It's possible that it fails again.
+        if (!sendTimingResp(blockedPackets.front())) {
+            return;
+        }
 
-    // Try to resend it. It's possible that it fails again.
-    sendPacket(pkt);
+        blockedPackets.pop_front();
+    }
 }
 
 void
 ProtectionMemobj::MemSidePort::sendPacket(PacketPtr pkt)
 {
-    // Note: This flow control is very simple since the memobj is blocking.
-
-    panic_if(blockedPacket != nullptr, "Should never try to send if blocked!");
-
-    // If we can't send the packet across the port, store it for later.
-    if (!sendTimingReq(pkt)) {
-        blockedPacket = pkt;
+    if (!blockedPackets.empty() || !sendTimingReq(pkt)) {
+        blockedPackets.push_back(pkt);
     }
 }
 
@@ -143,17 +246,17 @@ ProtectionMemobj::MemSidePort::recvTimingResp(PacketPtr pkt)
 }
 
 void
-ProtectionMemobj::MemSidePort::recvReqRetry()
+ProtectionMemobj::MemSidePort::recvRetry()
 {
-    // We should have a blocked packet if this function is called.
-    assert(blockedPacket != nullptr);
+    assert(!blockedPackets.empty());
 
-    // Grab the blocked packet.
-    PacketPtr pkt = blockedPacket;
-    blockedPacket = nullptr;
+    while (!blockedPackets.empty()) {
+        if (!sendTimingReq(blockedPackets.front())) {
+            return;
+        }
 
-    // Try to resend it. It's possible that it fails again.
-    sendPacket(pkt);
+        blockedPackets.pop_front();
+    }
 }
 
 void
@@ -162,56 +265,271 @@ ProtectionMemobj::MemSidePort::recvRangeChange()
     owner->sendRangeChange();
 }
 
+Cycles
+ProtectionMemobj::lookupPermission(uint64_t device_id, Addr paddr,
+                                   PermissionEntry& entry)
+{
+    Addr page = pageOf(paddr);
+    std::map<std::pair<Addr, int64_t>, PermissionEntry>::iterator it =
+        protectionTable.lower_bound(std::make_pair(page, INT64_MIN));
+
+    if (it == protectionTable.end() || it->first.first != page) {
+        entry = PermissionEntry();
+        entry.ppBase = page;
+    } else {
+        // a page tracked only for other devices is denied, not untracked
+        std::map<std::pair<Addr, int64_t>, PermissionEntry>::iterator own =
+            protectionTable.find(std::make_pair(page, (int64_t)device_id));
+        entry = own != protectionTable.end() ? own->second : it->second;
+    }
+
+    Addr line = ProtectionTableLayout::lineAddr(device_id, page);
+
+    if (permCache.lookup(line)) {
+        m_permCacheHits++;
+        return checkLatency;
+    }
+
+    m_permCacheMisses++;
+    permCache.insert(line);
+    return checkLatency + tableLatency;
+}
+
 bool
-ProtectionMemobj::handleRequest(PacketPtr pkt)
+ProtectionMemobj::handleRequest(PacketPtr pkt, CPUSidePort *port)
 {
-    if (blocked) {
-        // There is currently an outstanding request. Stall.
+    if (inflight.size() >= maxOutstanding) {
+        // Every slot is in use. Stall until a response frees one.
+        m_stalls++;
         return false;
     }
 
     DPRINTF(ProtectionMemobj, "Got request for addr %#x\n", pkt->getAddr());
 
-    // This memobj is now blocked waiting for the response to this packet.
-    blocked = true;
+    assert(inflight.find(pkt) == inflight.end());
+    CheckState& state = inflight[pkt];
+    state.port = port;
+    state.arrivalTick = curTick();
+    m_occupancy = inflight.size();
+    m_checks++;
+
+    PermissionEntry entry;
+    Cycles latency = lookupPermission(pkt->req->GetdeviceId(),
+                                      pkt->getAddr(), entry);
+
+    if (entry.deviceID < 0) {
+        state.permitted = allowUntracked;
+    } else {
+        uint8_t needed = pkt->isWrite() ? PROT_PERM_WRITE : PROT_PERM_READ;
+        state.permitted = entry.deviceID == (int64_t)pkt->req->GetdeviceId()
+                          && (entry.perms & needed);
+    }
 
-    // Simply forward to the memory port
-    memPort.sendPacket(pkt);
+    Tick when = clockEdge(latency);
+    pendingChecks.insert(std::make_pair(when, pkt));
+
+    if (!checkEvent.scheduled()) {
+        schedule(checkEvent, when);
+    } else if (when < checkEvent.when()) {
+        reschedule(checkEvent, when);
+    }
+
+    // Reads go to memory alongside the check; a write could not be undone
+    if (speculativeForward && pkt->isRead() && pkt->needsResponse()) {
+        state.forwarded = true;
+        m_speculativeForwards++;
+        memPort.sendPacket(pkt);
+    }
 
     return true;
 }
 
+void
+ProtectionMemobj::processChecks()
+{
+    while (!pendingChecks.empty() &&
+           pendingChecks.begin()->first <= curTick()) {
+        PacketPtr pkt = pendingChecks.begin()->second;
+        pendingChecks.erase(pendingChecks.begin());
+        completeCheck(pkt);
+    }
+
+    if (!pendingChecks.empty()) {
+        schedule(checkEvent, pendingChecks.begin()->first);
+    }
+}
+
+void
+ProtectionMemobj::completeCheck(PacketPtr pkt)
+{
+    std::map<PacketPtr, CheckState>::iterator it = inflight.find(pkt);
+    assert(it != inflight.end());
+    CheckState& state = it->second;
+    state.checked = true;
+    m_checkLatency.sample(ticksToCycles(curTick() - state.arrivalTick));
+
+    if (!state.permitted) {
+        DPRINTF(ProtectionMemobj, "Violation on addr %#x by device %d\n",
+                pkt->getAddr(), pkt->req->GetdeviceId());
+        m_violations++;
+    }
+
+    if (state.forwarded) {
+        // the response, if already back, was held for this check
+        if (state.heldResponse != NULL) {
+            PacketPtr resp = state.heldResponse;
+            state.heldResponse = NULL;
+            handleResponse(resp);
+        }
+
+        return;
+    }
+
+    if (state.permitted) {
+        state.forwarded = true;
+        bool needs_response = pkt->needsResponse();
+        memPort.sendPacket(pkt);
+
+        if (!needs_response) {
+            inflight.erase(it);
+            m_occupancy = inflight.size();
+            instPort.trySendRetry();
+            dataPort.trySendRetry();
+        }
+
+        return;
+    }
+
+    if (pkt->needsResponse()) {
+        pkt->makeResponse();
+        pkt->setBadAddress();
+        respond(pkt, state);
+    } else {
+        // a denied request without a response is simply dropped
+        inflight.erase(it);
+        m_occupancy = inflight.size();
+        delete pkt->req;
+        delete pkt;
+        instPort.trySendRetry();
+        dataPort.trySendRetry();
+    }
+}
+
 bool
 ProtectionMemobj::handleResponse(PacketPtr pkt)
 {
-    assert(blocked);
     DPRINTF(ProtectionMemobj, "Got response for addr %#x\n", pkt->getAddr());
 
-    // The packet is now done. We're about to put it in the port, no need for
-    // this object to continue to stall.
-    // We need to free the resource before sending the packet in case the CPU
-    // tries to send another request immediately (e.g., in the same callchain).
-    blocked = false;
+    std::map<PacketPtr, CheckState>::iterator it = inflight.find(pkt);
+    assert(it != inflight.end());
+    CheckState& state = it->second;
 
-    // Simply forward to the memory port
-    if (pkt->req->isInstFetch()) {
-        instPort.sendPacket(pkt);
-    } else {
-        dataPort.sendPacket(pkt);
+    if (!state.checked) {
+        // speculatively forwarded read, wait for its check
+        state.heldResponse = pkt;
+        return true;
+    }
+
+    if (!state.permitted) {
+        // squash: the requestor must not see the data
+        m_squashed++;
+
+        if (pkt->hasData()) {
+            std::memset(pkt->getPtr<uint8_t>(), 0, pkt->getSize());
+        }
+
+        pkt->setBadAddress();
     }
 
+    respond(pkt, state);
+    return true;
+}
+
+void
+ProtectionMemobj::respond(PacketPtr pkt, CheckState& state)
+{
+    CPUSidePort *port = state.port;
+    m_accessLatency.sample(ticksToCycles(curTick() - state.arrivalTick));
+
+    // We need to free the slot before sending the packet in case the CPU
+    // tries to send another request immediately (e.g., in the same
+    // callchain).
+    inflight.erase(pkt);
+    m_occupancy = inflight.size();
+
+    port->sendPacket(pkt);
+
     // For each of the cpu ports, if it needs to send a retry, it should do it
-    // now since this memory object may be unblocked now.
+    // now since a slot is free again.
     instPort.trySendRetry();
     dataPort.trySendRetry();
+}
 
-    return true;
+void
+ProtectionMemobj::setPermission(Addr pp_base, int64_t device_id,
+                                uint8_t perms)
+{
+    Addr page = pageOf(pp_base);
+    PermissionEntry& entry = protectionTable[std::make_pair(page, device_id)];
+    entry.ppBase = page;
+    entry.deviceID = device_id;
+    entry.perms = perms;
+    // the table line changed, drop the cached copy
+    permCache.invalidate(ProtectionTableLayout::lineAddr(device_id, page));
+}
+
+void
+ProtectionMemobj::revokePermission(Addr pp_base)
+{
+    Addr page = pageOf(pp_base);
+    std::map<std::pair<Addr, int64_t>, PermissionEntry>::iterator it =
+        protectionTable.lower_bound(std::make_pair(page, INT64_MIN));
+
+    while (it != protectionTable.end() && it->first.first == page) {
+        permCache.invalidate(
+            ProtectionTableLayout::lineAddr(it->second.deviceID, page));
+        protectionTable.erase(it++);
+    }
+}
+
+void
+ProtectionMemobj::revokeDevice(int64_t device_id)
+{
+    std::map<std::pair<Addr, int64_t>, PermissionEntry>::iterator it =
+        protectionTable.begin();
+
+    while (it != protectionTable.end()) {
+        if (it->first.second == device_id) {
+            permCache.invalidate(
+                ProtectionTableLayout::lineAddr(device_id, it->first.first));
+            protectionTable.erase(it++);
+        } else {
+            it++;
+        }
+    }
+}
+
+void
+ProtectionMemobj::setPermissionAll(Addr pp_base, int64_t device_id,
+                                   uint8_t perms)
+{
+    for (unsigned i = 0; i < instances.size(); i++) {
+        instances[i]->setPermission(pp_base, device_id, perms);
+    }
+}
+
+void
+ProtectionMemobj::revokeDeviceAll(int64_t device_id)
+{
+    for (unsigned i = 0; i < instances.size(); i++) {
+        instances[i]->revokeDevice(device_id);
+    }
 }
 
 void
 ProtectionMemobj::handleFunctional(PacketPtr pkt)
 {
-    // Just pass this on to the memory side to handle for now.
+    // Debug accesses are not checked, just pass them on.
     memPort.sendFunctional(pkt);
 }
 
@@ -230,7 +548,44 @@ ProtectionMemobj::sendRangeChange()
     dataPort.sendRangeChange();
 }
 
-
+void
+ProtectionMemobj::regStats()
+{
+    MemObject::regStats();
+
+    m_checks
+        .name(name() + ".checks")
+        .desc("Number of requests checked");
+    m_permCacheHits
+        .name(name() + ".perm_cache_hits")
+        .desc("Checks served by the permission cache");
+    m_permCacheMisses
+        .name(name() + ".perm_cache_misses")
+        .desc("Checks that walked the protection table");
+    m_violations
+        .name(name() + ".violations")
+        .desc("Requests denied by the protection table");
+    m_squashed
+        .name(name() + ".squashed")
+        .desc("Speculatively forwarded reads squashed on a violation");
+    m_speculativeForwards
+        .name(name() + ".speculative_forwards")
+        .desc("Reads forwarded before their check completed");
+    m_stalls
+        .name(name() + ".stalls")
+        .desc("Requests refused because all slots were in use");
+    m_checkLatency
+        .init(0, 200, 10)
+        .name(name() + ".check_latency")
+        .desc("Cycles from arrival to the end of the check");
+    m_accessLatency
+        .init(0, 1000, 50)
+        .name(name() + ".access_latency")
+        .desc("Cycles from arrival to the response");
+    m_occupancy
+        .name(name() + ".occupancy")
+        .desc("Average number of requests in flight");
+}
 
 ProtectionMemobj*
 ProtectionMemobjParams::create()
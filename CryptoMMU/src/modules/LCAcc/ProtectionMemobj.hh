@@ -28,19 +28,77 @@
  * Authors: Jason Lowe-Power
  */
 
-#ifndef __PROTECTION_MEMOBJ_PROTECTION__MEMOBJ_HH__
-#define __PROTECTION__MEMOBJ_PROTECTION__MEMOBJ_HH__
+#ifndef __LCACC_PROTECTION_MEMOBJ_HH__
+#define __LCACC_PROTECTION_MEMOBJ_HH__
 
+#include <deque>
+#include <map>
+#include <utility>
 #include <vector>
 
+#include "base/statistics.hh"
 #include "mem/mem_object.hh"
-//#include "params/ProtectionMemobj.hh"
+#include "mem/protection_table.hh"
+#include "params/ProtectionMemobj.hh"
 
 /**
- * A very simple memory object. Current implementation doesn't even cache
- * anything it just forwards requests and responses.
- * This memobj is fully blocking (not non-blocking). Only a single request can
- * be outstanding at a time.
+ * Permission bits held for a protection granule (page).
+ */
+#define PROT_PERM_READ  0x1
+#define PROT_PERM_WRITE 0x2
+
+class PermissionEntry
+{
+  public:
+    Addr ppBase;
+    /// Device holding the permissions, -1 for an untracked page
+    int64_t deviceID;
+    uint8_t perms;
+    PermissionEntry() : ppBase(0), deviceID(-1), perms(0) {}
+};
+
+class PermissionLine
+{
+  public:
+    Addr lineAddr;
+    bool valid;
+    Tick mruTick;
+    PermissionLine() : lineAddr(0), valid(false), mruTick(0) {}
+};
+
+/**
+ * Small set-associative LRU cache of protection table lines, so that most
+ * checks do not have to walk the table. A line holds the entries of
+ * ProtectionTableLayout::pagesPerLine() pages.
+ */
+class PermissionCache
+{
+    unsigned numEntries;
+    unsigned assoc;
+    unsigned sets;
+
+    PermissionLine **entries;
+
+  public:
+    PermissionCache(unsigned _numEntries, unsigned associativity);
+    ~PermissionCache();
+
+    bool lookup(Addr line_addr);
+    void insert(Addr line_addr);
+    void invalidate(Addr line_addr);
+    void flushAll();
+};
+
+/**
+ * Inline protection check for accelerator memory traffic. Every request is
+ * checked against the protection table (through the permission cache) for
+ * the device that issued it.
+ *
+ * The memobj is non-blocking: up to max_outstanding requests are in flight.
+ * With speculative_forward, reads are sent to memory while their check is
+ * still pending and the response is held until the check completes; a read
+ * that fails its check is squashed and returned with an error. Writes are
+ * never forwarded before their check passes.
  */
 class ProtectionMemobj : public MemObject
 {
@@ -49,7 +107,7 @@ class ProtectionMemobj : public MemObject
     /**
      * Port on the CPU-side that receives requests.
      * Mostly just forwards requests to the owner.
-     * Part of a vector of ports. One for each CPU port (e.g., data, inst)
+     * One for each CPU port (e.g., data, inst)
      */
     class CPUSidePort : public SlavePort
     {
@@ -60,21 +118,20 @@ class ProtectionMemobj : public MemObject
         /// True if the port needs to send a retry req.
         bool needRetry;
 
-        /// If we tried to send a packet and it was blocked, store it here
-        PacketPtr blockedPacket;
+        /// Responses waiting for the master to accept them
+        std::deque<PacketPtr> blockedPackets;
 
       public:
         /**
          * Constructor. Just calls the superclass constructor.
          */
         CPUSidePort(const std::string& name, ProtectionMemobj *owner) :
-            SlavePort(name, owner), owner(owner), needRetry(false),
-            blockedPacket(nullptr)
+            SlavePort(name, owner), owner(owner), needRetry(false)
         { }
 
         /**
-         * Send a packet across this port. This is called by the owner and
-         * all of the flow control is hanled in this function.
+         * Send a response across this port. Responses that cannot be sent
+         * are queued and resent in order on recvRetry.
          *
          * @param packet to send.
          */
@@ -87,20 +144,20 @@ class ProtectionMemobj : public MemObject
          *
          * @return a list of ranges responded to
          */
-        AddrRangeList getAddrRanges() const override;
+        AddrRangeList getAddrRanges() const;
 
         /**
          * Send a retry to the peer port only if it is needed. This is called
-         * from the SimpleCache whenever it is unblocked.
+         * from the memobj whenever a request slot frees up.
          */
         void trySendRetry();
 
       protected:
         /**
          * Receive an atomic request packet from the master port.
-         * No need to implement in this simple memobj.
+         * No need to implement in this memobj.
          */
-        Tick recvAtomic(PacketPtr pkt) override
+        Tick recvAtomic(PacketPtr pkt)
         { panic("recvAtomic unimpl."); }
 
         /**
@@ -109,7 +166,7 @@ class ProtectionMemobj : public MemObject
          *
          * @param packet the requestor sent.
          */
-        void recvFunctional(PacketPtr pkt) override;
+        void recvFunctional(PacketPtr pkt);
 
         /**
          * Receive a timing request from the master port.
@@ -119,14 +176,14 @@ class ProtectionMemobj : public MemObject
          *         will call sendRetry() when we can try to receive this
          *         request again.
          */
-        bool recvTimingReq(PacketPtr pkt) override;
+        bool recvTimingReq(PacketPtr pkt);
 
         /**
          * Called by the master port if sendTimingResp was called on this
          * slave port (causing recvTimingResp to be called on the master
          * port) and was unsuccesful.
          */
-        void recvRespRetry() override;
+        void recvRetry();
     };
 
     /**
@@ -139,20 +196,20 @@ class ProtectionMemobj : public MemObject
         /// The object that owns this object (ProtectionMemobj)
         ProtectionMemobj *owner;
 
-        /// If we tried to send a packet and it was blocked, store it here
-        PacketPtr blockedPacket;
+        /// Requests waiting for the slave to accept them
+        std::deque<PacketPtr> blockedPackets;
 
       public:
         /**
          * Constructor. Just calls the superclass constructor.
          */
         MemSidePort(const std::string& name, ProtectionMemobj *owner) :
-            MasterPort(name, owner), owner(owner), blockedPacket(nullptr)
+            MasterPort(name, owner), owner(owner)
         { }
 
         /**
-         * Send a packet across this port. This is called by the owner and
-         * all of the flow control is hanled in this function.
+         * Send a request across this port. Requests that cannot be sent
+         * are queued and resent in order on recvRetry.
          *
          * @param packet to send.
          */
@@ -162,33 +219,50 @@ class ProtectionMemobj : public MemObject
         /**
          * Receive a timing response from the slave port.
          */
-        bool recvTimingResp(PacketPtr pkt) override;
+        bool recvTimingResp(PacketPtr pkt);
 
         /**
          * Called by the slave port if sendTimingReq was called on this
          * master port (causing recvTimingReq to be called on the slave
          * port) and was unsuccesful.
          */
-        void recvReqRetry() override;
+        void recvRetry();
 
         /**
          * Called to receive an address range change from the peer slave
-         * port. The default implementation ignores the change and does
-         * nothing. Override this function in a derived class if the owner
-         * needs to be aware of the address ranges, e.g. in an
-         * interconnect component like a bus.
+         * port.
          */
-        void recvRangeChange() override;
+        void recvRangeChange();
+    };
+
+    /**
+     * Book-keeping for one request between arrival and its response.
+     */
+    class CheckState
+    {
+      public:
+        CPUSidePort *port;
+        Tick arrivalTick;
+        /// True once the request has been sent to memory
+        bool forwarded;
+        /// True once the permission check has completed
+        bool checked;
+        bool permitted;
+        /// Response that arrived before the check completed
+        PacketPtr heldResponse;
+        CheckState() : port(NULL), arrivalTick(0), forwarded(false),
+            checked(false), permitted(false), heldResponse(NULL) {}
     };
 
     /**
      * Handle the request from the CPU side
      *
      * @param requesting packet
+     * @param port the request arrived on
      * @return true if we can handle the request this cycle, false if the
      *         requestor needs to retry later
      */
-    bool handleRequest(PacketPtr pkt);
+    bool handleRequest(PacketPtr pkt, CPUSidePort *port);
 
     /**
      * Handle the response from the memory side
@@ -207,6 +281,35 @@ class ProtectionMemobj : public MemObject
      */
     void handleFunctional(PacketPtr pkt);
 
+    /**
+     * Look up the permission of paddr's page for device_id. The table line
+     * holding it is looked up in the permission cache and fetched on a
+     * miss.
+     *
+     * @return the number of cycles the lookup takes
+     */
+    Cycles lookupPermission(uint64_t device_id, Addr paddr,
+                            PermissionEntry& entry);
+
+    /**
+     * Complete every check whose latency has elapsed.
+     */
+    void processChecks();
+
+    /**
+     * Resolve the check of one request, forwarding, squashing or
+     * answering it.
+     */
+    void completeCheck(PacketPtr pkt);
+
+    /**
+     * Send a response to the requestor and release its slot.
+     */
+    void respond(PacketPtr pkt, CheckState& state);
+
+    Addr pageOf(Addr addr) const
+    { return addr & ~(Addr(ProtectionTableLayout::pageBytes()) - 1); }
+
     /**
      * Return the address ranges this memobj is responsible for. Just use the
      * same as the next upper level of the hierarchy.
@@ -227,8 +330,38 @@ class ProtectionMemobj : public MemObject
     /// Instantiation of the memory-side port
     MemSidePort memPort;
 
-    /// True if this is currently blocked waiting for a response.
-    bool blocked;
+    const unsigned maxOutstanding;
+    const Cycles checkLatency;
+    const Cycles tableLatency;
+    const bool speculativeForward;
+    const bool allowUntracked;
+
+    PermissionCache permCache;
+
+    //key page base and device, value permissions the device holds
+    std::map<std::pair<Addr, int64_t>, PermissionEntry> protectionTable;
+
+    //key request packet, value its progress through the memobj
+    std::map<PacketPtr, CheckState> inflight;
+
+    //key tick the check completes, value request being checked
+    std::multimap<Tick, PacketPtr> pendingChecks;
+
+    EventWrapper<ProtectionMemobj, &ProtectionMemobj::processChecks> checkEvent;
+
+    Stats::Scalar m_checks;
+    Stats::Scalar m_permCacheHits;
+    Stats::Scalar m_permCacheMisses;
+    Stats::Scalar m_violations;
+    Stats::Scalar m_squashed;
+    Stats::Scalar m_speculativeForwards;
+    Stats::Scalar m_stalls;
+    Stats::Distribution m_checkLatency;
+    Stats::Distribution m_accessLatency;
+    Stats::Average m_occupancy;
+
+    /// Every memobj in the system, kept in step by the static helpers
+    static std::vector<ProtectionMemobj *> instances;
 
   public:
 
@@ -236,19 +369,42 @@ class ProtectionMemobj : public MemObject
      */
     ProtectionMemobj(ProtectionMemobjParams *params);
 
+    void regStats();
+
     /**
-     * Get a port with a given name and index. This is used at
-     * binding time and returns a reference to a protocol-agnostic
-     * base master port.
-     *
-     * @param if_name Port name
-     * @param idx Index in the case of a VectorPort
-     *
-     * @return A reference to the given port
+     * Grant device the given PROT_PERM_* permissions on the page holding
+     * pp_base, replacing whatever was held before.
+     */
+    void setPermission(Addr pp_base, int64_t device_id, uint8_t perms);
+
+    /**
+     * Stop tracking the page holding pp_base for every device.
+     */
+    void revokePermission(Addr pp_base);
+
+    /**
+     * Drop every permission held by device.
+     */
+    void revokeDevice(int64_t device_id);
+
+    /**
+     * setPermission on every memobj in the system. Called when a verified
+     * translation is delivered to device.
      */
-    Port& getPort(const std::string& if_name,
-                                  PortID idx = InvalidPortID) override;
+    static void setPermissionAll(Addr pp_base, int64_t device_id,
+                                 uint8_t perms);
+
+    /**
+     * revokeDevice on every memobj in the system. Called when the tenant
+     * of device exits.
+     */
+    static void revokeDeviceAll(int64_t device_id);
+
+    BaseMasterPort& getMasterPort(const std::string& if_name,
+                                  PortID idx = InvalidPortID);
+    BaseSlavePort& getSlavePort(const std::string& if_name,
+                                PortID idx = InvalidPortID);
 };
 
 
-#endif // __LEARNING_GEM5_SIMPLE_MEMOBJ_SIMPLE_MEMOBJ_HH__
+#endif // __LCACC_PROTECTION_MEMOBJ_HH__
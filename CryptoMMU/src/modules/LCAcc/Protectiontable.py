@@ -33,8 +33,21 @@ from MemObject import MemObject
 
 class ProtectionMemobj(MemObject):
     type = 'ProtectionMemobj'
-    cxx_header = "modules/LCAcc/protection_memobj.hh"
+    cxx_header = "modules/LCAcc/ProtectionMemobj.hh"
 
     inst_port = SlavePort("CPU side port, receives requests")
     data_port = SlavePort("CPU side port, receives requests")
-    mem_side = MasterPort("Memory side port, sends requests")
\ No newline at end of file
+    mem_side = MasterPort("Memory side port, sends requests")
+
+    max_outstanding = Param.Unsigned(16, "max number of requests in flight")
+    perm_cache_entries = Param.Unsigned(64,
+        "protection table lines held by the permission cache")
+    perm_cache_assoc = Param.Unsigned(4,
+        "permission cache associativity, 0 for fully associative")
+    check_latency = Param.Cycles(1, "permission cache lookup latency")
+    table_latency = Param.Cycles(40,
+        "extra latency of a protection table walk on a cache miss")
+    speculative_forward = Param.Bool(True,
+        "forward reads to memory while their check is in flight")
+    allow_untracked = Param.Bool(False,
+        "allow accesses to pages the protection table does not track")
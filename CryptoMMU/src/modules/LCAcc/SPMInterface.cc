@@ -4,6 +4,8 @@
 #include "../MsgLogger/MsgLogger.hh"
 #include "../scratch-pad/scratch-pad.hh"
 #include "../../mem/ruby/common/Global.hh"
+#include "base/trace.hh"
+#include "debug/CryptoMMU.hh"
 #include <iostream>
 
 using namespace LCAcc;
@@ -18,12 +20,9 @@ void SPMInterface::DrainPending()
     if (p.isRead && pendingReadSet.size() < maxPendingReads) {
       bool repeat = pendingReadSet.find(p.addr) != pendingReadSet.end();
       pendingReadSet[p.addr].push_back(p.cb);
-      std::cout << 
-        "p.addr" << p.addr <<
-        "p.size" << p.size << std::endl;
-       std::cout << "Time buffer execute in SPM interface 30" << std::endl; 
+
       if (!repeat) {
-        std::cout << "Time buffer execute in read repeat" << std::endl;
+        DPRINTFR(CryptoMMU, "spm.%d: timed read %#x size %d\n", id, p.addr, p.size);
         SimicsInterface::TimedBufferRead(cpu, p.addr, p.size, buffer, TimedReadCompleteCB::Create(this, p.addr));
       }
 
@@ -32,7 +31,7 @@ void SPMInterface::DrainPending()
       pendingWriteSet[p.addr].push_back(p.cb);
 
       if (!repeat) {
-        std::cout << "Time buffer execute in write repeat" << std::endl; 
+        DPRINTFR(CryptoMMU, "spm.%d: timed write %#x size %d\n", id, p.addr, p.size);
         SimicsInterface::TimedBufferWrite(cpu, p.addr, p.size, buffer, TimedWriteCompleteCB::Create(this, p.addr));
       }
     } else {
@@ -80,7 +79,7 @@ SPMInterface::SPMInterface(const std::string& hostName, int cpuPort,
 {
   // size is ignored
   cpu = cpuPort;
-  std::cout << "CPU port" << cpuPort << std::endl;
+  DPRINTFR(CryptoMMU, "spm.%d: cpu port %d\n", identifier, cpuPort);
   this->hostName = hostName;
   buffer = -1;
   id = identifier;
@@ -213,7 +212,7 @@ SPMInterface::TimedRead(unsigned int addr, unsigned int size,
     SimicsInterface::RegisterCallback(cb, timeOfInit + readLatency);
   } else {
     addr = (addr / 64) * 64;
-    std::cout << "Time buffer execute in SPM interface" << std::endl;
+
     if (outstandingAccesses >= maxOutstandingAccesses ||
         (pendingReadSet.find(addr) == pendingReadSet.end() &&
          pendingReadSet.size() >= maxPendingReads)) {
@@ -49,6 +49,7 @@
 //#include "../../mem/ruby/common/Global.hh"
 #include "../../mem/ruby/system/System.hh"
 #include "memInterface.hh"
+#include "base/misc.hh"
 #define SP_WORD_SIZE 8
 
 using namespace LCAcc;
@@ -423,23 +424,24 @@ void CallCBWrapper(void* args)
   cb->Call();
   cb->Dispose();
 }
+// cpu is the network node of the requesting accelerator; each accelerator
+// goes through its own port when per-accelerator interfaces are configured
+static MemoryInterface* AccMemoryInterface(int cpu)
+{
+  int accID = RubySystem::deviceIDtoAccID(cpu);
+  fatal_if(accID < 0 || accID >= RubySystem::numberOfAccInstances(),
+           "Timed buffer access from node %d, which is not an accelerator\n",
+           cpu);
+  return MemoryInterface::Instance(accID);
+}
 void SimicsInterface::TimedBufferRead(int cpu, uint64_t addr, size_t size, int buffer, CallbackBase* cb)
 {
-  //TODO: Not accurate for multiple accelerators:
-  // Currently, all requests are sent from a single accelerator.
-  // One way to fix is to make a mapping from cpu to memory interface,
-  // if there is at most one accelerator per cpu.
-  std::cout << "Failure 2" << std::endl;
-  MemoryInterface::Instance()->sendReadRequest(addr, (uint8_t*) &buffer, size, CallCBWrapper, (void *)cb);
+  AccMemoryInterface(cpu)->sendReadRequest(addr, (uint8_t*) &buffer, size, CallCBWrapper, (void *)cb, cpu);
   //SimicsInterface::makeBufferRequestCB(cpu, addr, buffer, RubyRequestType_LD, CallCBWrapper, cb);
 }
 void SimicsInterface::TimedBufferWrite(int cpu, uint64_t addr, size_t size, int buffer, CallbackBase* cb)
 {
-  //TODO: Not accurate for multiple accelerators:
-  // Currently, all requests are sent from a single accelerator.
-  // One way to fix is to make a mapping from cpu to memory interface,
-  // if there is at most one accelerator per cpu.
-  MemoryInterface::Instance()->sendWriteRequest(addr, (uint8_t*) &buffer, size, CallCBWrapper, (void *)cb);
+  AccMemoryInterface(cpu)->sendWriteRequest(addr, (uint8_t*) &buffer, size, CallCBWrapper, (void *)cb, cpu);
   //SimicsInterface::makeBufferRequestCB(cpu, addr, buffer, RubyRequestType_ST, CallCBWrapper, cb);
 }
 
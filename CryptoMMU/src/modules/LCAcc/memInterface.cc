@@ -1,10 +1,15 @@
+#include <map>
 #include "modules/LCAcc/memInterface.hh"
 #include "mem/request.hh"
+#include "sim/stats.hh"
 #include "sim/system.hh"
 #include "base/types.hh"
 #include "mem/ruby/common/Global.hh"
 
 MemoryInterface *globalMemInterface = NULL;
+//key port id, value per-accelerator interface
+static std::map<int, MemoryInterface*> accMemInterfaces;
+static MemoryInterface *protectionMemInterface = NULL;
 
 MemoryInterface *
 MemoryInterfaceParams::create()
@@ -13,11 +18,61 @@ MemoryInterfaceParams::create()
 }
 
 MemoryInterface::MemoryInterface(const Params* params)
-  : MemObject(params), m_masterPort(this), m_latency(1),
-    m_masterId(params->system->getMasterId(name()))
+  : MemObject(params), m_sendEvent(this), m_masterPort(this), m_latency(1),
+    m_masterId(params->system->getMasterId(name())),
+    m_portId(params->port_id), m_maxOutstanding(params->max_outstanding),
+    m_outstanding(0), m_waitingRetry(false)
 {
-  if (globalMemInterface == NULL)
-    globalMemInterface = this;
+  assert(m_maxOutstanding > 0);
+
+  if (params->protection_port) {
+    assert(protectionMemInterface == NULL);
+    protectionMemInterface = this;
+  } else if (m_portId < 0) {
+    if (globalMemInterface == NULL)
+      globalMemInterface = this;
+  } else {
+    assert(accMemInterfaces.find(m_portId) == accMemInterfaces.end());
+    accMemInterfaces[m_portId] = this;
+  }
+}
+
+void
+MemoryInterface::regStats()
+{
+  MemObject::regStats();
+
+  m_readReqs
+    .name(name() + ".read_reqs")
+    .desc("Number of timing reads sent by the accelerators");
+  m_writeReqs
+    .name(name() + ".write_reqs")
+    .desc("Number of timing writes sent by the accelerators");
+  m_readBytes
+    .name(name() + ".read_bytes")
+    .desc("Bytes read through this port");
+  m_writeBytes
+    .name(name() + ".write_bytes")
+    .desc("Bytes written through this port");
+  m_retries
+    .name(name() + ".retries")
+    .desc("Number of times the port refused a packet");
+  m_queueTicks
+    .name(name() + ".queue_ticks")
+    .desc("Ticks packets waited before the port accepted them");
+  m_maxQueueDepth
+    .name(name() + ".max_queue_depth")
+    .desc("Largest number of packets waiting for the port");
+  m_readBandwidth
+    .name(name() + ".read_bandwidth")
+    .desc("Read bandwidth through this port (bytes/s)")
+    .precision(0);
+  m_readBandwidth = m_readBytes / simSeconds;
+  m_writeBandwidth
+    .name(name() + ".write_bandwidth")
+    .desc("Write bandwidth through this port (bytes/s)")
+    .precision(0);
+  m_writeBandwidth = m_writeBytes / simSeconds;
 }
 
 bool
@@ -39,9 +94,59 @@ MemoryInterface::AcceleratorMasterPort::recvTimingResp(PacketPtr pkt)
   pkt->req = NULL;
   delete pkt;
 
+  // a slot freed up, push out whatever was waiting for it
+  assert(acc->m_outstanding > 0);
+  acc->m_outstanding--;
+  acc->trySendPending();
+
   return success;
 }
 
+void
+MemoryInterface::AcceleratorMasterPort::recvRetry()
+{
+  MemoryInterface *acc = (dynamic_cast<MemoryInterface *>(&owner));
+  assert(acc);
+  acc->retrySend();
+}
+
+void
+MemoryInterface::retrySend()
+{
+  assert(m_waitingRetry);
+  m_waitingRetry = false;
+  trySendPending();
+}
+
+void
+MemoryInterface::trySendPending()
+{
+  while (!m_waitingRetry && !m_pendingPackets.empty()
+         && m_outstanding < m_maxOutstanding) {
+    PacketPtr pkt = m_pendingPackets.front();
+
+    if (!m_masterPort.sendTimingReq(pkt)) {
+      // the port calls recvRetry once it can take the packet
+      m_retries++;
+      m_waitingRetry = true;
+      return;
+    }
+
+    if (pkt->isRead()) {
+      m_readReqs++;
+      m_readBytes += pkt->getSize();
+    } else {
+      m_writeReqs++;
+      m_writeBytes += pkt->getSize();
+    }
+
+    m_queueTicks += curTick() - m_pendingTicks.front();
+    m_pendingPackets.pop_front();
+    m_pendingTicks.pop_front();
+    m_outstanding++;
+  }
+}
+
 /*
  * Callback when a packet is returned from a read request.
  * Calls the callback function passed to the sendRequest functions.
@@ -102,7 +207,7 @@ MemoryInterface::getMasterPort(const std::string& if_name, PortID idx)
  * after this packet receives a response.
  */
 void
-MemoryInterface::sendRequest(Addr paddr, uint8_t *data, int size, Packet::SenderState *state, MemCmd cmd, bool timing)
+MemoryInterface::sendRequest(Addr paddr, uint8_t *data, int size, Packet::SenderState *state, MemCmd cmd, bool timing, uint64_t device_id)
 {
   Request::Flags flags = 0;
   // Note: although the M5 classic memory system (which includes
@@ -111,6 +216,9 @@ MemoryInterface::sendRequest(Addr paddr, uint8_t *data, int size, Packet::Sender
   // more realistic (no unrealistically small caches).
 
   RequestPtr req = new Request(paddr, size, flags, m_masterId);
+  // Every port of this interface belongs to an accelerator
+  req->setRequestorClass(ReqClassAccelerator);
+  req->SetdeviceID(device_id);
   // Assumption: do not want to read a block of memory, just
   // one or more addresses. (Not sure if reading more than one works)
   PacketPtr pkt = new Packet(req, cmd);
@@ -121,9 +229,17 @@ MemoryInterface::sendRequest(Addr paddr, uint8_t *data, int size, Packet::Sender
 
   if (timing)
   {
-    std::cout<< "Failure 5" << std::endl;
     //std::cout << "m_masterPort" <<
-    m_masterPort.schedTimingReq(pkt, clockEdge(Cycles(m_latency)));
+    m_pendingPackets.push_back(pkt);
+    m_pendingTicks.push_back(curTick());
+
+    if (m_pendingPackets.size() > m_maxQueueDepth.value()) {
+      m_maxQueueDepth = m_pendingPackets.size();
+    }
+
+    if (!m_sendEvent.scheduled()) {
+      schedule(m_sendEvent, clockEdge(Cycles(m_latency)));
+    }
   }
     
   else {
@@ -149,15 +265,14 @@ MemoryInterface::sendRequest(Addr paddr, uint8_t *data, int size, Packet::Sender
 }
 
 void
-MemoryInterface::sendReadRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg)
+MemoryInterface::sendReadRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg, uint64_t device_id)
 {
   ReadCallbackState * state = new ReadCallbackState(callback, arg);
-  std::cout<<"Failure 3" << std::endl;
-  sendRequest(paddr, data, size, state, MemCmd(MemCmd::Command::ReadReq), true);
+  sendRequest(paddr, data, size, state, MemCmd(MemCmd::Command::ReadReq), true, device_id);
 }
 
 void
-MemoryInterface::sendWriteRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg)
+MemoryInterface::sendWriteRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg, uint64_t device_id)
 {
   //uint8_t* newData = new uint8_t[size];
   //memcpy(newData, data, size*sizeof(uint8_t));
@@ -170,7 +285,7 @@ MemoryInterface::sendWriteRequest(Addr paddr, uint8_t* data, int size, void (*ca
 
   WriteCallbackState * state = new WriteCallbackState(callback, arg);
 
-  sendRequest(paddr, data, size, state, MemCmd(MemCmd::Command::WriteReq), true);
+  sendRequest(paddr, data, size, state, MemCmd(MemCmd::Command::WriteReq), true, device_id);
 }
 
 void
@@ -203,8 +318,32 @@ MemoryInterface::scheduleCallback(void (*callback)(void*), Cycles delay,
 MemoryInterface*
 MemoryInterface::Instance()
 {
+  if (globalMemInterface == NULL && !accMemInterfaces.empty())
+    return accMemInterfaces.begin()->second;
+
   if (globalMemInterface == NULL)
     fatal ("Memory Interface expected to have been created already.\n");
 
   return globalMemInterface;
 }
+
+MemoryInterface*
+MemoryInterface::ProtectionInstance()
+{
+  return protectionMemInterface;
+}
+
+MemoryInterface*
+MemoryInterface::Instance(int accID)
+{
+  if (accID < 0 || accMemInterfaces.empty())
+    return Instance();
+
+  std::map<int, MemoryInterface*>::iterator it =
+    accMemInterfaces.find(accID % accMemInterfaces.size());
+
+  if (it == accMemInterfaces.end())
+    fatal("Accelerator memory ports must be numbered 0..n-1.\n");
+
+  return it->second;
+}
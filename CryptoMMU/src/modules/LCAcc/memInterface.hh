@@ -8,6 +8,8 @@
 #ifndef __MEMORY_INTERFACE_HH__
 #define __MEMORY_INTERFACE_HH__
 
+#include <deque>
+#include "base/statistics.hh"
 #include "mem/mem_object.hh"
 #include "mem/mport.hh"
 #include "debug/Accelerator.hh"
@@ -20,20 +22,20 @@ class MemoryInterface : public MemObject
   /*
    * M5 ports for the accelerator.
    *
-   * TODO: Alt design: inherit from MasterPort and SlavePort instead.
-   * The only difference will be that the accelerator handles resending
-   * packets if the port is busy.
+   * The port is a plain MasterPort: the interface itself queues packets,
+   * bounds the number in flight and resends them when the port is busy.
    */
 
-  class AcceleratorMasterPort : public MessageMasterPort
+  class AcceleratorMasterPort : public MasterPort
   {
   public:
     AcceleratorMasterPort(MemoryInterface* owner)
-      : MessageMasterPort(owner->name() + ".accelerator_port", owner)
+      : MasterPort(owner->name() + ".accelerator_port", owner)
     { }
 
   protected:
     bool recvTimingResp(PacketPtr pkt);
+    void recvRetry();
     void recvRangeChange() {}
   };
 
@@ -80,11 +82,23 @@ public:
 
   /**
    * A temporary (?) measure to give accelerators global access to the
-   * accelerator interface.  Will not work as implemented with multiple
-   * accelerator interfaces - Should then be altered to use python
-   * configuration.
+   * accelerator interface.  Returns the shared interface (port_id -1), or
+   * the first per-accelerator port when there is no shared one.
    */
   static MemoryInterface *Instance();
+  /**
+   * Interface used by accelerator accID.  Accelerators are spread over the
+   * per-accelerator ports configured in python (port_id 0..n-1); without
+   * any, all share Instance().
+   */
+  static MemoryInterface *Instance(int accID);
+  /**
+   * Interface reserved for protection table fetches (protection_port), or
+   * NULL if none is configured.
+   */
+  static MemoryInterface *ProtectionInstance();
+
+  void regStats();
 
 protected:
   /**
@@ -99,7 +113,14 @@ private:
   /**
    * Helper function to send all types of packets.
    */
-  void sendRequest(Addr paddr, uint8_t *data, int size, Packet::SenderState *state, MemCmd cmd, bool timing);
+  void sendRequest(Addr paddr, uint8_t *data, int size, Packet::SenderState *state, MemCmd cmd, bool timing, uint64_t device_id = 0);
+  /**
+   * Send queued packets while fewer than m_maxOutstanding are in flight and
+   * the port has not refused one.
+   */
+  void trySendPending();
+  void retrySend();
+  EventWrapper<MemoryInterface, &MemoryInterface::trySendPending> m_sendEvent;
 
 public:
   /**
@@ -110,15 +131,17 @@ public:
    * Assumption: data requested lies within one block.  Does not split
    * requests.
    * The buffer provided will contain the result when the packet returns.
+   * device_id is the network node of the requesting accelerator, checked
+   * by any protection memobj on the way to memory.
    */
-  virtual void sendReadRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg);
+  virtual void sendReadRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg, uint64_t device_id = 0);
   /**
    * Same as sendReadRequest, except it writes to the address instead
    * of reading.  Takes a pointer to the data, which is not copied,
    * and must remain valid until the packet returns.
    */
   
-  virtual void sendWriteRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg);
+  virtual void sendWriteRequest(Addr paddr, uint8_t* data, int size, void (*callback)(void*), void* arg, uint64_t device_id = 0);
   /**
    * Same as sendReadRequest, except the request travels instantly.
    * Read value is stored in the provided array.
@@ -144,6 +167,24 @@ protected:
   AcceleratorMasterPort m_masterPort;
   int m_latency;
   MasterID m_masterId;
+
+  int m_portId;
+  unsigned int m_maxOutstanding;
+  unsigned int m_outstanding;
+  bool m_waitingRetry;
+  //timing packets not yet accepted by the port, with their enqueue tick
+  std::deque<PacketPtr> m_pendingPackets;
+  std::deque<Tick> m_pendingTicks;
+
+  Stats::Scalar m_readReqs;
+  Stats::Scalar m_writeReqs;
+  Stats::Scalar m_readBytes;
+  Stats::Scalar m_writeBytes;
+  Stats::Scalar m_retries;
+  Stats::Scalar m_queueTicks;
+  Stats::Scalar m_maxQueueDepth;
+  Stats::Formula m_readBandwidth;
+  Stats::Formula m_writeBandwidth;
 };
 
 #endif //__MEMORY_INTERFACE_HH__
@@ -1,13 +1,88 @@
 #ifndef MSG_LOGGER_H
 #define MSG_LOGGER_H
 
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include "modules/Common/mf_api.hh"
 
-// std::cerr << std::dec << GetSystemTime() << ": " << x << ": " << y << std::endl;
+// Message levels.  Anything above ML_LOG_LEVEL is compiled out entirely;
+// what survives is further filtered by the ML_LOG_LEVEL environment
+// variable at run time (defaults to the compile-time level).
+#define ML_LEVEL_ERROR 0
+#define ML_LEVEL_INFO  1
+#define ML_LEVEL_DEBUG 2
+
+#ifndef ML_LOG_LEVEL
+#define ML_LOG_LEVEL ML_LEVEL_INFO
+#endif
+
+// Buffered sink so that enabled logging does not pay for a flush of
+// std::cerr per message.  Errors are written through immediately.
+class MsgLogSink
+{
+  std::string buffer;
+  int level;
+
+  MsgLogSink() : level(ML_LOG_LEVEL)
+  {
+    const char* env = getenv("ML_LOG_LEVEL");
+
+    if (env) {
+      level = atoi(env);
+    }
+
+    buffer.reserve(FlushThreshold);
+  }
+
+public:
+  static const size_t FlushThreshold = 64 * 1024;
+
+  ~MsgLogSink()
+  {
+    Flush();
+  }
+  static MsgLogSink& Instance()
+  {
+    static MsgLogSink sink;
+    return sink;
+  }
+  bool Enabled(int msgLevel) const
+  {
+    return msgLevel <= level;
+  }
+  void Write(int msgLevel, const std::string& msg)
+  {
+    buffer += msg;
+
+    if (msgLevel == ML_LEVEL_ERROR || buffer.size() >= FlushThreshold) {
+      Flush();
+    }
+  }
+  void Flush()
+  {
+    if (!buffer.empty()) {
+      std::cerr.write(buffer.data(), buffer.size());
+      std::cerr.flush();
+      buffer.clear();
+    }
+  }
+};
+
+#define ML_LOG_AT(level, x, y)                                          \
+  do {                                                                  \
+    if ((level) <= ML_LOG_LEVEL &&                                      \
+        MsgLogSink::Instance().Enabled(level)) {                        \
+      std::ostringstream ml_os;                                         \
+      ml_os << "[obj:\"" << x << "\"] [tick:" << std::dec               \
+            << GetSystemTime() << "] " << y << "\n";                    \
+      MsgLogSink::Instance().Write(level, ml_os.str());                 \
+    }                                                                   \
+  } while (0)
+
+#define ML_LOG(x, y) ML_LOG_AT(ML_LEVEL_DEBUG, x, y)
+#define ML_INFO(x, y) ML_LOG_AT(ML_LEVEL_INFO, x, y)
+#define ML_ERROR(x, y) ML_LOG_AT(ML_LEVEL_ERROR, x, y)
 
-#define ML_LOG(x, y)				\
-{ \
-  std::cerr << "[obj:\"" << x << "\"] [tick:" << std::dec << GetSystemTime() << "] " << y << std::endl; \
-}
 #endif
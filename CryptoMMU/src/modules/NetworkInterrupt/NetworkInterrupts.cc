@@ -8,16 +8,27 @@
 #include "../TLBHack/TLBHack.hh"
 #include "../../sim/system.hh"
 #include "../../mem/ruby/system/System.hh"
+#include "mem/protection_table.hh"
+#include "mem/translation_trace.hh"
+#include "modules/LCAcc/memInterface.hh"
+#include "modules/LCAcc/AcceleratorMMUPolicy.hh"
+#include "modules/LCAcc/ProtectionMemobj.hh"
 #include "../MsgLogger/MsgLogger.hh"
 #include "modules/Synchronize/Synchronize.hh"
 #include "sim/pseudo_inst.hh"
 #include "lwi.hh"
 #include "modules/LCAcc/SimicsInterface.hh"
+#include "modules/TaskDistributor/SimicsInterface.hh"
 #include "arch/vtophys.hh"
 
 #include "arch/x86/tlb.hh"
 #include "arch/x86/regs/misc.hh"
 #include "arch/x86/pagetable_walker.hh"
+#include "base/trace.hh"
+#include "debug/BCC.hh"
+#include "debug/CryptoMMU.hh"
+#include "debug/LWI.hh"
+#include "debug/ProtTable.hh"
 
 #define MAX_ISR_BUFFER_SIZE 128
 
@@ -105,19 +116,6 @@ void NetworkInterrupts::TryRaise(int thread)
       assert(m.packet.size() <= MAX_ISR_BUFFER_SIZE);
       lwi->raiseLightWeightInt(m.thread, &(m.packet[0]), m.packet.size(), m.lcacc);
       pendingMsgs[thread].pop();
-
-      uint64_t sum = 0;
-
-      for (int i = 0; i < queueLen.size(); i++)
-      {
-        sum += queueLen[i];
-      }
-
-      if (queueLen.size())
-      {
-        // ML_LOG(GetDeviceName(), "avg queue length: "
-        //        << (float)sum / queueLen.size());
-      }
     }
 
     // EnqueueEvent(nih->attachedCPU, TryRaiseCB::Create(this, thread), 1);
@@ -147,6 +145,33 @@ NetworkInterrupts::LookupNIByCpu(int cpu)
   return NULL;
 }
 
+NetworkInterrupts *
+NetworkInterrupts::LookupNIByDevice(int deviceID)
+{
+  std::map<int, NetworkInterrupts *>::iterator it;
+
+  for (it = cpuMap.begin(); it != cpuMap.end(); it++)
+  {
+    if (it->second->nih->deviceID == deviceID)
+    {
+      return it->second;
+    }
+  }
+
+  return NULL;
+}
+
+void
+NetworkInterrupts::FlushDeviceProtection(uint64_t deviceID)
+{
+  std::map<int, NetworkInterrupts *>::iterator it;
+
+  for (it = cpuMap.begin(); it != cpuMap.end(); it++)
+  {
+    it->second->Bcc->flushDevice(deviceID);
+  }
+}
+
 // NetworkInterrupts::NetworkInterrupts(const Params *p)
 // {
 
@@ -181,9 +206,12 @@ NetworkInterrupts::NetworkInterrupts(NetworkInterruptHandle *x)
   hostPTWLatency = RubySystem::getHostPTWLatency();
   // std::cout << "Host PAge walk Latency " << hostPTWLatency << std::endl;
   hostPTWalks = 0;
-  hostPTWalkTick = 0;
   hostPTWalkTime = 0;
-  currState = Ready;
+  numWalkers = RubySystem::getHostPTWalkers();
+  walkersBusy = 0;
+  Bcc = new BccCache(RubySystem::getBCCEntries(), RubySystem::getBCCAssoc());
+  protFetch = new ProtectionFetchUnit(RubySystem::getProtFetchMaxOutstanding(), RubySystem::getProtFetchLatency());
+  DPRINTF(BCC, "%d sets, %d ways\n", Bcc->getSets(), Bcc->getAssoc());
   tlbSize = 32;
   tlb = new X86ISA::TlbEntry[tlbSize];
   std::memset(tlb, 0, sizeof(X86ISA::TlbEntry) * tlbSize);
@@ -196,6 +224,12 @@ NetworkInterrupts::NetworkInterrupts(NetworkInterruptHandle *x)
 
   lruSeq = 0;
 
+  queueLenHist.init(8);
+  walkQueueHist.init(10);
+  walkServiceHist.init(10);
+  bccHitLatencyHist.init(10);
+  bccMissLatencyHist.init(10);
+
   interval = 1;
   EnqueueEvent(sampleQueueLenCB::Create(this), interval);
 }
@@ -206,6 +240,7 @@ NetworkInterrupts::~NetworkInterrupts()
   assert(cpuMap.find(nih->procID) != cpuMap.end());
   assert(cpuMap[nih->procID] == this);
   cpuMap.erase(nih->procID);
+  delete protFetch;
 }
 
 int NetworkInterrupts::GetSignal(int thread)
@@ -330,9 +365,7 @@ void NetworkInterrupts::RecvMessage(int source, const char *buffer, int size)
     else
     {
       // Page walk for normal request
-      uint64_t pAddr = 0;
-      uint64_t ver_req = 0;
-      setupWalk(thread, vAddr, device_id, pAddr, ver_req);
+      setupWalk(thread, vAddr, device_id);
     }
   }
   else
@@ -362,8 +395,64 @@ void NetworkInterrupts::startMAC()
   bc.u32[1] = bcc_lookup->buffer[9];
   uint64_t device_id = bc.u64[0];
   bcc_access++;
-  EnqueueEvent(SerialMACCB::Create(this, buffer), 1); /*Serial CrytoMMU will have a latency here*/
- 
+  buffer->arrivalCycle = g_system_ptr->curCycle();
+  buffer->bccHit = Bcc->lookup(pAddr, device_id);
+
+  if (buffer->bccHit)
+  {
+    DPRINTF(BCC, "hit paddr %#x device %d\n", pAddr, device_id);
+    TranslationTrace::record(TranslationTrace::BCCLookup, device_id, vAddr,
+                             pAddr, TranslationTrace::BCCHit, thread);
+    bcc_hit++;
+    EnqueueEvent(PermissionKnownCB::Create(this, buffer), 1);
+  }
+  else if (!protFetch->IsTimed())
+  {
+    // no table read is modelled: the permission is known after the same
+    // cycle as on a hit, as before the fetch unit existed
+    DPRINTF(BCC, "miss paddr %#x device %d\n", pAddr, device_id);
+    TranslationTrace::record(TranslationTrace::BCCLookup, device_id, vAddr,
+                             pAddr, TranslationTrace::BCCMiss, thread);
+    bcc_miss++;
+    EnqueueEvent(ProtectionLineFetchedCB::Create(this, buffer), 1);
+  }
+  else
+  {
+    // read the table line through the fetch unit, not the host walker
+    DPRINTF(BCC, "miss paddr %#x device %d\n", pAddr, device_id);
+    TranslationTrace::record(TranslationTrace::BCCLookup, device_id, vAddr,
+                             pAddr, TranslationTrace::BCCMiss, thread);
+    bcc_miss++;
+    protFetch->Fetch(ProtectionTableLayout::lineAddr(device_id, pAddr), device_id, ProtectionLineFetchedCB::Create(this, buffer));
+  }
+}
+
+void NetworkInterrupts::ProtectionLineFetched(MACptr buffer)
+{
+  BitConverter bc;
+  bc.u32[0] = buffer->buffer[4];
+  bc.u32[1] = buffer->buffer[5];
+  uint64_t pAddr = bc.u64[0];
+  bc.u32[0] = buffer->buffer[8];
+  bc.u32[1] = buffer->buffer[9];
+  uint64_t device_id = bc.u64[0];
+  Bcc->insert(pAddr, device_id);
+  PermissionKnown(buffer);
+}
+
+void NetworkInterrupts::PermissionKnown(MACptr buffer)
+{
+  // the policy decides how much of the MAC is left once the permission
+  // is known; parallel variants overlap it with the BCC and table lookups
+  uint64_t elapsed = g_system_ptr->curCycle() - buffer->arrivalCycle;
+  uint64_t delay = AcceleratorMMUPolicy::Instance()->MACDelay(
+                     RubySystem::getMACLatency(), elapsed);
+
+  if (delay > 0) {
+    EnqueueEvent(SerialMACCB::Create(this, buffer), delay);
+  } else {
+    SerialMAC(buffer);
+  }
 }
 
 void NetworkInterrupts::SerialMAC(MACptr buffer)
@@ -387,6 +476,10 @@ void NetworkInterrupts::SerialMAC(MACptr buffer)
   bno.u32[0] = args->buffer[8];
   bno.u32[1] = args->buffer[9];
   uint64_t node_id = bno.u64[0];
+  uint64_t latency = g_system_ptr->curCycle() - buffer->arrivalCycle;
+  (buffer->bccHit ? bccHitLatencyHist : bccMissLatencyHist).sample(latency);
+  TranslationTrace::record(TranslationTrace::MACDone, node_id, vAddr, pAddr,
+                           TranslationTrace::Verified, thread);
   uint32_t msg[10];
   msg[0] = LCACC_CMD_TLB_SERVICE;
   msg[1] = thread;
@@ -409,7 +502,7 @@ void NetworkInterrupts::SerialMAC(MACptr buffer)
   nih->snpi->SendMessageOnDevice(nih->deviceID, 0, msg, sizeof(msg));
 }
 
-void NetworkInterrupts::setupWalk(int thread, uint64_t vAddr, uint64_t device_id, uint64_t pAddr, uint64_t ver_req)
+void NetworkInterrupts::setupWalk(int thread, uint64_t vAddr, uint64_t device_id)
 {
   RequestPtr req = new Request();
   Request::Flags flags;
@@ -419,29 +512,23 @@ void NetworkInterrupts::setupWalk(int thread, uint64_t vAddr, uint64_t device_id
   req->setVirt(asid, vAddr, size, flags, Request::funcMasterId, pc);
   req->taskId(thread);
   req->SetdeviceID(device_id);
-  req->SetVerficationRequest(ver_req);
-  req->SetPaddr_Ver(pAddr);
-  uint64_t random_pAddr = RandomMap[pAddr];
-  req->SetPaddr_Rand(random_pAddr);
 
   // ML_LOG(GetDeviceName(), "Receive page table walking req from userthread"
   //     << thread << " on 0x" << std::hex << req->getVaddr());
   pendingTranslations.push_back(req);
+  pendingTranslationCycles.push_back(g_system_ptr->curCycle());
   walkerstate();
 
 }
 
 /*
-We are merging the request for translation and
-protection table access into same queue, howver
-we use a different constructor to build the object
-for the protection table verfication
+Only translations queue for the host walker; protection
+table reads for verification go through protFetch
 */
 
 void NetworkInterrupts::walkerstate()
 {
-  // std::cout<<"Current state" << currState << std::endl;
-  if (currState == Ready)
+  if (walkersBusy < numWalkers)
   {
     startWalk();
   }
@@ -450,14 +537,16 @@ void NetworkInterrupts::walkerstate()
 void NetworkInterrupts::startWalk()
 {
   assert(pendingTranslations.size());
-  currState = Waiting;
-  hostPTWalkTick = g_system_ptr->curCycle();
+  walkersBusy++;
+  uint64_t now = g_system_ptr->curCycle();
   RequestPtr req = pendingTranslations.front();
-  if(req->IsVerification())
-  {
-    verificationTick = g_system_ptr->curCycle();
-  }
   pendingTranslations.pop_front();
+  hostPTWalkTicks[req] = now;
+  walkQueueHist.sample(now - pendingTranslationCycles.front());
+  pendingTranslationCycles.pop_front();
+  TranslationTrace::record(TranslationTrace::WalkStart, req->GetdeviceId(),
+                           req->getVaddr(), 0, TranslationTrace::None,
+                           req->taskId());
   EnqueueEvent(HostPTWalkCB::Create(this, req), 1);
 }
 /*
@@ -474,11 +563,7 @@ void NetworkInterrupts::HostPTWalk(RequestPtr req)
       new WholeTranslationState(req, NULL, NULL, mode);
   DataTranslation<NetworkInterrupts *> *translation =
       new DataTranslation<NetworkInterrupts *>(this, state);
-  if (req->IsVerification() == 0)
-  {
-    //std::cout<< "Page_Table_walk/MAC_generation" << hostPTWalks << std::endl;
-    hostPTWalks++;
-  }
+  hostPTWalks++;
 
   System *m5_system = *(System::systemList.begin());
 
@@ -498,9 +583,14 @@ void NetworkInterrupts::finishTranslation(WholeTranslationState *state)
   }
 
   RequestPtr req = state->mainReq;
-  uint64_t hostPTWalkLatency = g_system_ptr->curCycle() - hostPTWalkTick;
+  std::map<RequestPtr, uint64_t>::iterator started = hostPTWalkTicks.find(req);
+  assert(started != hostPTWalkTicks.end());
+  uint64_t hostPTWalkLatency = g_system_ptr->curCycle() - started->second;
+  hostPTWalkTicks.erase(started);
   hostPTWalkTime += hostPTWalkLatency;
-  currState = Ready;
+  walkServiceHist.sample(hostPTWalkLatency);
+  assert(walkersBusy > 0);
+  walkersBusy--;
   uint64_t logicalPage = req->getVaddr();
   uint64_t physicalPage;
   uint64_t device_id = req->GetdeviceId();
@@ -509,6 +599,8 @@ void NetworkInterrupts::finishTranslation(WholeTranslationState *state)
   MAC = 0;
   physicalPage = req->getPaddr();
   int thread = req->taskId();
+  TranslationTrace::record(TranslationTrace::WalkEnd, device_id, logicalPage,
+                           physicalPage, TranslationTrace::Walked, thread);
   uint32_t buffer[12];
   buffer[0] = LCACC_CMD_TLB_SERVICE;
   buffer[1] = req->taskId();
@@ -541,8 +633,7 @@ void NetworkInterrupts::finishTranslation(WholeTranslationState *state)
 
 void NetworkInterrupts::sampleQueueLen()
 {
-  if (pendingTranslations.size())
-    queueLen.push_back(pendingTranslations.size());
+  queueLenHist.sample(pendingTranslations.size());
 
   EnqueueEvent(sampleQueueLenCB::Create(this), interval);
 }
@@ -597,9 +688,23 @@ void BccCache::flushAll()
 {
   for (int set = 0; set < sets; set++)
   {
-    for (int set = 0; set < assoc; set++)
+    for (int i = 0; i < assoc; i++)
     {
-      entries[set][set].free = true; // just free up all the entries
+      entries[set][i].free = true; // just free up all the entries
+    }
+  }
+}
+
+void BccCache::flushDevice(uint64_t device_id)
+{
+  for (int set = 0; set < sets; set++)
+  {
+    for (int i = 0; i < assoc; i++)
+    {
+      if (entries[set][i].device_id == device_id)
+      {
+        entries[set][i].free = true; // only the entries of this device
+      }
     }
   }
 }
@@ -617,18 +722,20 @@ NetworkInterrupts::lookup(uint64_t va, bool update_lru)
 
 bool BccCache::lookup(uint64_t pp_base, uint64_t &device_id, bool set_mru)
 {
-  int set = (pp_base % sets);
+  // the BCC holds protection table lines, so one entry covers every page
+  // sharing that line; the permissions it vouches for are those of the
+  // device that fetched it
+  uint64_t line = ProtectionTableLayout::lineAddr(device_id, pp_base);
+  int set = ((line / ProtectionTableLayout::lineBytes()) % sets);
   // std::cout<<"set in lookup" <<set<< std::endl;
   for (int i = 0; i < assoc; i++)
   {
-    //if (entries[set][i].ppBase == pp_base && entries[set][i].device_id == device_id && !entries[set][i].free)
-    if (entries[set][i].ppBase == pp_base && !entries[set][i].free)
+    if (entries[set][i].ppBase == line && entries[set][i].device_id == device_id && !entries[set][i].free)
     {
       // return true if the entry
-      // 1. same as physical address
+      // 1. holds the table line of the physical address
       // 2. same device id
       // 3. entry is not free
-      // pp_base = entries[set][i].ppBase;
       assert(entries[set][i].mruTick > 0);
 
       if (set_mru)
@@ -647,7 +754,8 @@ void BccCache::insert(uint64_t pp_base, uint64_t device_id)
 {
 
   // sets=1;
-  int set = (pp_base  % sets);
+  uint64_t line = ProtectionTableLayout::lineAddr(device_id, pp_base);
+  int set = ((line / ProtectionTableLayout::lineBytes()) % sets);
   BccEntry *entry = NULL;
   uint64_t minTick = GetSystemTime();
   for (int i = 0; i < assoc; i++)
@@ -664,12 +772,98 @@ void BccCache::insert(uint64_t pp_base, uint64_t device_id)
     }
   }
   assert(entry);
-  entry->ppBase = pp_base;
+  entry->ppBase = line;
   entry->device_id = device_id;
   entry->free = false;
   entry->setMRU();
 }
 
+ProtectionFetchUnit::ProtectionFetchUnit(unsigned max_outstanding, uint32_t fallback_latency)
+  : maxOutstanding(max_outstanding), outstanding(0), fallbackLatency(fallback_latency),
+    fetches(0), merged(0)
+{
+  assert(maxOutstanding > 0);
+}
+
+bool ProtectionFetchUnit::IsTimed() const
+{
+  return MemoryInterface::ProtectionInstance() != NULL || fallbackLatency > 0;
+}
+
+void ProtectionFetchUnit::Fetch(uint64_t line, uint64_t device_id, CallbackBase* onDone)
+{
+  std::list<CallbackBase*>& w = waiters[line];
+  w.push_back(onDone);
+
+  if (w.size() > 1)
+  {
+    // the line is already queued or in flight
+    DPRINTFR(ProtTable, "merge line %#x\n", line);
+    merged++;
+    return;
+  }
+
+  issueQueue.push_back(std::make_pair(line, device_id));
+  TryIssue();
+}
+
+void ProtectionFetchUnit::TryIssue()
+{
+  while (outstanding < maxOutstanding && !issueQueue.empty())
+  {
+    uint64_t line = issueQueue.front().first;
+    uint64_t device_id = issueQueue.front().second;
+    issueQueue.pop_front();
+    outstanding++;
+    fetches++;
+    DPRINTFR(ProtTable, "fetch line %#x, %d outstanding\n", line, outstanding);
+    MemoryInterface* port = MemoryInterface::ProtectionInstance();
+
+    if (port)
+    {
+      FetchState* state = new FetchState;
+      state->unit = this;
+      state->line = line;
+      state->data = new uint8_t[ProtectionTableLayout::lineBytes()];
+      // the device id lets the memory side attribute the read
+      port->sendReadRequest(line, state->data, ProtectionTableLayout::lineBytes(), ReadDone, state, device_id);
+    }
+    else
+    {
+      // no protection port configured, charge a fixed memory latency
+      EnqueueEvent(FetchCompleteCB::Create(this, line), fallbackLatency);
+    }
+  }
+}
+
+void ProtectionFetchUnit::ReadDone(void* arg)
+{
+  FetchState* state = (FetchState*)arg;
+  state->unit->FetchComplete(state->line);
+  delete [] state->data;
+  delete state;
+}
+
+void ProtectionFetchUnit::FetchComplete(uint64_t line)
+{
+  assert(outstanding > 0);
+  outstanding--;
+  DPRINTFR(ProtTable, "line %#x done\n", line);
+  std::map<uint64_t, std::list<CallbackBase*> >::iterator it = waiters.find(line);
+  assert(it != waiters.end());
+  std::list<CallbackBase*> done;
+  done.swap(it->second);
+  waiters.erase(it);
+
+  for (std::list<CallbackBase*>::iterator cb = done.begin(); cb != done.end(); cb++)
+  {
+    (*cb)->Call();
+    (*cb)->Dispose();
+  }
+
+  TryIssue();
+}
+
 uint64_t PhyMemRandomAlg(uint64_t physicalpage_low, uint64_t physicalpage_high)
 {
   uint64_t n = physicalpage_high - physicalpage_low + 1;
@@ -734,6 +928,36 @@ createNetworkInterruptHandle(int portID, int deviceID, int procID)
   return handle;
 }
 
+void
+LCAccReleaseProcess(unsigned int process)
+{
+  // The translations of the process go, and so do the cached permissions
+  // of the accelerators that worked for it: BCC entries are kept per
+  // device, not per process.
+  std::map<int, LCAcc::LCAccDevice *> &devices =
+      LCAcc::SimicsInterface::manager.deviceSet;
+  std::map<int, LCAcc::LCAccDevice *>::iterator dev;
+
+  for (dev = devices.begin(); dev != devices.end(); dev++)
+  {
+    LCAcc::DMAController *dma = dev->second->getDMA();
+
+    if (dma && dma->FlushASID(process))
+    {
+      NetworkInterrupts::FlushDeviceProtection(dev->second->GetNodeID());
+      ProtectionMemobj::revokeDeviceAll(dev->second->GetNodeID());
+    }
+  }
+
+  std::map<int, TD *> &tds = TaskDistributor::SimicsInterface::manager.tdSet;
+  std::map<int, TD *>::iterator td;
+
+  for (td = tds.begin(); td != tds.end(); td++)
+  {
+    td->second->ReleaseProcess(process);
+  }
+}
+
 uint64_t
 LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
                     uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4,
@@ -787,20 +1011,14 @@ LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
     int thread = (int)arg1; // cpu->readIntReg(X86ISA::INTREG_RSI);  //SIM_read_register(cpu, SIM_get_register_number(cpu, "l3"));
     int lcacc = (int)arg2;  // cpu->readIntReg(X86ISA::INTREG_RDX); //SIM_read_register(cpu, SIM_get_register_number(cpu, "l4"));
     int delay = (int)arg3;  // cpu->readIntReg(X86ISA::INTREG_RCX); // SIM_read_register(cpu, SIM_get_register_number(cpu, "l5"));
-    std::cout << "LCAcc_Reserve: thread " << thread << " lcacc " << lcacc << " delay " << delay << std::endl;
+    DPRINTFS(CryptoMMU, ni, "LCAcc_Reserve: thread %d lcacc %d delay %d\n", thread, lcacc, delay);
 
     if (lcacc == 0)
     {
       assert(NetworkInterrupts::pendingReservation.find(thread) != NetworkInterrupts::pendingReservation.end());
       assert(NetworkInterrupts::pendingReservation[thread].size() >= 1);
-      std::cout << "Reserving ";
-
-      for (size_t i = 0; i < NetworkInterrupts::pendingReservation[thread].size(); i++)
-      {
-        std::cout << "[" << NetworkInterrupts::pendingReservation[thread][i] << "]";
-      }
-
-      std::cout << " from " << nih->deviceID << std::endl;
+      DPRINTFS(CryptoMMU, ni, "Reserving %d accelerators from %d\n",
+               NetworkInterrupts::pendingReservation[thread].size(), nih->deviceID);
       std::vector<uint32_t> packet;
       int32_t target = 0; // gam target
       packet.push_back(GAM_CMD_RESERVE);
@@ -833,7 +1051,7 @@ LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
     }
     else
     {
-      std::cout << "Adding reservation for " << lcacc << " to pending queue of thread " << thread << std::endl;
+      DPRINTFS(CryptoMMU, ni, "Adding reservation for %d to pending queue of thread %d\n", lcacc, thread);
       NetworkInterrupts::pendingReservation[thread].push_back(lcacc);
     }
   }
@@ -852,9 +1070,8 @@ LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
 
   case (0xC020):
   { // MAGIC_BiN_CURVE
-    std::cout << "***** MAGIC_SEND_BiN_CURVE\n";
     int thread = (int)arg1; // cpu->readIntReg(X86ISA::INTREG_RSI); //SIM_read_register(cpu, SIM_get_register_number(cpu, "l3"));
-    std::cout << "Adding BiN curve info for thread " << thread << std::endl;
+    DPRINTFS(CryptoMMU, ni, "Adding BiN curve info for thread %d\n", thread);
     uint32_t size = (uint32_t)arg2; // cpu->readIntReg(X86ISA::INTREG_RDX); //SIM_read_register(cpu, SIM_get_register_number(cpu, "l4"));
 
     if (size != 0)
@@ -903,8 +1120,7 @@ LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
     buffer[0] = GAM_CMD_REQUEST;
     buffer[1] = (uint32_t)arg1;
     buffer[2] = (uint32_t)arg2;
-    std::cout << "Requesting " << std::dec << (int32_t)buffer[2]
-              << " from " << nih->deviceID << std::endl;
+    DPRINTFS(CryptoMMU, ni, "Requesting %d from %d\n", (int32_t)buffer[2], nih->deviceID);
     nih->snpi->SendMessageOnDevice(nih->deviceID, target, buffer,
                                    sizeof(buffer));
   }
@@ -1069,16 +1285,15 @@ LCAccMagicIntercept(void *, ThreadContext *cpu, int32_t op,
       assert(accepter.la_args[1]);
       assert(msg.packet.size() < 100);
       assert(msg.packet.size() % 4 == 0);
-      std::cout << "[LWI_MAGIC_CHECK] @ userthread " << thread
-                << ": msg of size" << msg.packet.size() / 4
-                << std::endl;
+      DPRINTFS(LWI, ni, "[LWI_MAGIC_CHECK] @ userthread %d: msg of size %d\n",
+               thread, msg.packet.size() / 4);
 
       for (int i = 0; i < msg.packet.size() / 4; i++)
       {
         // TODO: Check if this works with new 64 bit addresses.
         assert(accepter.la_args.size() > i * 4);
         uint32_t *v = (uint32_t *)&msg.packet[i * 4];
-        std::cout << i << ", " << accepter.la_args[i * 4] << ", " << accepter.pa_args[i * 4] << "," << *v << std::endl;
+        DPRINTFS(LWI, ni, "%d, %#x, %#x, %d\n", i, accepter.la_args[i * 4], accepter.pa_args[i * 4], *v);
         LCAcc::SimicsInterface::WritePhysical(accepter.pa_args[i * 4], (void *)v, 4);
       }
 
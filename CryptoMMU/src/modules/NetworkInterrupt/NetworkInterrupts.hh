@@ -4,6 +4,7 @@
 
 #define SIMICS30
 #include <stdint.h>
+#include <list>
 #include <map>
 #include <set>
 #include <queue>
@@ -20,6 +21,7 @@
 #include "../Common/mf_api.hh"
 #include "arch/x86/pagetable.hh"
 #include "base/trie.hh"
+#include "base/statistics.hh"
 #include <map>
 typedef struct NetworkInterruptHandle_t {
   SimicsNetworkPortInterface* snpi;
@@ -31,6 +33,7 @@ typedef struct NetworkInterruptHandle_t {
 class BccEntry
 {
 public:
+  // address of the cached protection table line
   uint64_t ppBase;
   uint64_t device_id;
   bool free;
@@ -60,14 +63,20 @@ public:
     
     assert(numEntries % assoc == 0);
     sets = numEntries / assoc;
-    std::cout << "class: sets" << sets << std::endl;
-    std::cout << "class: assoc" << assoc << std::endl;
     entries = new BccEntry*[sets];
 
     for (int i = 0; i < sets; i++) {
       entries[i] = new BccEntry[assoc];
     }
   }
+  int getSets() const
+  {
+    return sets;
+  }
+  int getAssoc() const
+  {
+    return assoc;
+  }
   virtual ~BccCache()
   {
     for (int i = 0; i < assoc; i++) {
@@ -79,6 +88,56 @@ public:
   bool lookup(uint64_t pp_base, uint64_t& device_id, bool set_mru = true);
   void insert(uint64_t pp_base, uint64_t device_id);
   void flushAll();
+  void flushDevice(uint64_t device_id);
+};
+
+/*
+Reads protection table lines for verification requests. It has its own
+queue, outstanding limit and memory port, so verifications do not wait
+behind host page table walks. Requests for a line already being read
+are merged onto that read.
+*/
+class ProtectionFetchUnit
+{
+  struct FetchState
+  {
+    ProtectionFetchUnit* unit;
+    uint64_t line;
+    uint8_t* data;
+  };
+
+  unsigned maxOutstanding;
+  unsigned outstanding;
+  uint32_t fallbackLatency;
+  //table lines to read, with the device whose miss queued them
+  std::list<std::pair<uint64_t, uint64_t> > issueQueue;
+  //key table line, value verifications waiting for it
+  std::map<uint64_t, std::list<CallbackBase*> > waiters;
+  uint64_t fetches;
+  uint64_t merged;
+
+  void TryIssue();
+  static void ReadDone(void* arg);
+
+public:
+  ProtectionFetchUnit(unsigned max_outstanding, uint32_t fallback_latency);
+
+  void Fetch(uint64_t line, uint64_t device_id, CallbackBase* onDone);
+  void FetchComplete(uint64_t line);
+  // false when there is neither a fetch port nor a fallback latency, so
+  // no table read is modelled
+  bool IsTimed() const;
+
+  typedef MemberCallback1<ProtectionFetchUnit, uint64_t, &ProtectionFetchUnit::FetchComplete> FetchCompleteCB;
+
+  uint64_t getFetches()
+  {
+    return fetches;
+  }
+  uint64_t getMerged()
+  {
+    return merged;
+  }
 };
 
 class NetworkInterrupts
@@ -124,23 +183,23 @@ private:
 
   uint32_t hostPTWLatency;
   uint64_t hostPTWalks;
-  uint64_t hostPTWalkTick;
+  //key walk request, value cycle it entered the walker
+  std::map<RequestPtr, uint64_t> hostPTWalkTicks;
   uint64_t hostPTWalkTime;
   uint64_t verificationTick;
   uint64_t verificationLatency;
   uint32_t bcc_latency=10;
   struct MACstruct{
           uint32_t buffer[10];
+          uint64_t arrivalCycle;
+          bool bccHit;
         };
   typedef MACstruct* MACptr;
   std::list<RequestPtr> pendingTranslations;
+  std::list<uint64_t> pendingTranslationCycles;
   std::list<MACstruct* > MAC_verf;
-  enum State {
-    Ready,
-    Waiting
-  };
-
-  State currState;
+  uint32_t numWalkers;
+  uint32_t walkersBusy;
 
   int interval;
 
@@ -162,12 +221,23 @@ public:
   static std::map<int, std::vector<AcceleratorDeclaration> > accDeclInfo; //key thread, value declaration
   static std::map<int, std::vector<int> > pendingReservation; //key threadID, vector of lcaccID's
   static NetworkInterrupts* LookupNIByCpu(int cpu);
-
-  std::vector<int> queueLen;
+  static NetworkInterrupts* LookupNIByDevice(int deviceID);
+  // drops the cached permissions of an accelerator on every core
+  static void FlushDeviceProtection(uint64_t deviceID);
+
+  // translation walks waiting for the walker, sampled every interval
+  Stats::Histogram queueLenHist;
+  // cycles walks wait for the walker and spend in it
+  Stats::Histogram walkQueueHist;
+  Stats::Histogram walkServiceHist;
+  // verification request to reply, split by BCC outcome
+  Stats::Histogram bccHitLatencyHist;
+  Stats::Histogram bccMissLatencyHist;
 
   // typedef NetworkInterruptsParams Params;
   // NetworkInterrupts(const Params *p);
-  BccCache* Bcc = new BccCache(10,10);
+  BccCache* Bcc;
+  ProtectionFetchUnit* protFetch;
   NetworkInterrupts(NetworkInterruptHandle* x);
   ~NetworkInterrupts();
 
@@ -182,6 +252,8 @@ public:
   void HostPTWalk(RequestPtr req);
   void SerialMAC( MACptr buffer);
   void startMAC();
+  void ProtectionLineFetched(MACptr buffer);
+  void PermissionKnown(MACptr buffer);
   void sampleQueueLen();
   typedef MemberCallback4<NetworkInterrupts, int, int, const void*, int, &NetworkInterrupts::RaiseInterrupt> RaiseInterruptCB;
   typedef Arg3MemberCallback<NetworkInterrupts, int, const char*, int, &NetworkInterrupts::RecvMessage> RecvMessageCB;
@@ -189,19 +261,24 @@ public:
   typedef MemberCallback1<NetworkInterrupts, RequestPtr, &NetworkInterrupts::HostPTWalk> HostPTWalkCB;
   typedef MemberCallback0<NetworkInterrupts, &NetworkInterrupts::sampleQueueLen> sampleQueueLenCB;
   typedef MemberCallback1<NetworkInterrupts, MACptr, &NetworkInterrupts::SerialMAC> SerialMACCB;
+  typedef MemberCallback1<NetworkInterrupts, MACptr, &NetworkInterrupts::ProtectionLineFetched> ProtectionLineFetchedCB;
+  typedef MemberCallback1<NetworkInterrupts, MACptr, &NetworkInterrupts::PermissionKnown> PermissionKnownCB;
   inline std::string GetDeviceName()
   {
     char s[20];
     sprintf(s, "netinterrupts.%02d", nih->portID);
     return s;
   }
+  std::string name()
+  {
+    return GetDeviceName();
+  }
   int ver_iommu=0;
   void finishTranslation(WholeTranslationState *state);
 
   void startWalk();
   void walkerstate();
-  void setupWalk(int thread, uint64_t vAddr, uint64_t device_id, uint64_t pAddr, uint64_t ver_req);
-  void ProtectionTableWalk(int thread, uint64_t vAddr, int ver_req, uint64_t device_id, uint64_t pAddr);
+  void setupWalk(int thread, uint64_t vAddr, uint64_t device_id);
 
   /** This function is used by the page table walker to determin if it could
   * translate a pending request or if the underlying request has been
@@ -238,6 +315,41 @@ public:
     return bcc_hit;
   }
 
+  uint64_t getProtFetches()
+  {
+    return protFetch->getFetches();
+  }
+
+  uint64_t getProtFetchMerged()
+  {
+    return protFetch->getMerged();
+  }
+
+  Stats::Histogram& getQueueLenHist()
+  {
+    return queueLenHist;
+  }
+
+  Stats::Histogram& getWalkQueueHist()
+  {
+    return walkQueueHist;
+  }
+
+  Stats::Histogram& getWalkServiceHist()
+  {
+    return walkServiceHist;
+  }
+
+  Stats::Histogram& getBccHitLatencyHist()
+  {
+    return bccHitLatencyHist;
+  }
+
+  Stats::Histogram& getBccMissLatencyHist()
+  {
+    return bccMissLatencyHist;
+  }
+
   X86ISA::TlbEntry *lookup(uint64_t va, bool update_lru = true);
   
 
@@ -277,6 +389,9 @@ public:
 
 //X86ISA::IntReg LCAccMagicIntercept(void*, ThreadContext* cpu, int32_t op);
 uint64_t LCAccMagicIntercept(void*, ThreadContext* cpu, int32_t op, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4, uint64_t arg5, uint64_t arg6, uint64_t arg7);
+// a process (the thread id the benchmarks hand to the accelerators) left,
+// or its id now belongs to a new one
+void LCAccReleaseProcess(unsigned int process);
 NetworkInterruptHandle* createNetworkInterruptHandle(int portID, int deviceID, int procID);
 void HandleEvent(void* arg);
 
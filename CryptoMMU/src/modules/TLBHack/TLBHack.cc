@@ -3,16 +3,23 @@
 #include <iostream>
 #include <map>
 
-#include "modules/MsgLogger/MsgLogger.hh"
 #include "TLBHack.hh"
 #include "arch/vtophys.hh"
 #include "arch/isa_traits.hh"
+#include "base/trace.hh"
+#include "debug/TLBHack.hh"
 
 #define SYSTEM_PAGE (TheISA::PageBytes)
 #define Round(x, y) (((x) / (y)) * (y))
 
 std::map<int, std::map<logical_address_t, physical_address_t> > largeTLB;
 
+static std::string
+name()
+{
+  return "tlbhack";
+}
+
 void
 MagicHandler(void*, ThreadContext* cpu, integer_t op, int thread,
              logical_address_t lAddr)
@@ -43,9 +50,8 @@ LookupHandler(int thread, logical_address_t addr)
 {
   logical_address_t pageAddr = Round(addr, SYSTEM_PAGE);
   assert(PageKnownHandler(thread, pageAddr));
-  ML_LOG("tlbhack", "servicing TLB miss for userthread "
-         << thread << ": 0x" << std::hex << addr << " -> 0x" << std::hex
-         << largeTLB[thread][pageAddr] + (addr - pageAddr))
+  DPRINTF(TLBHack, "servicing TLB miss for userthread %d: %#x -> %#x\n",
+          thread, addr, largeTLB[thread][pageAddr] + (addr - pageAddr));
 
   return largeTLB[thread][pageAddr] + (addr - pageAddr);
 }
@@ -56,7 +62,7 @@ AddEntryHandler(int thread, logical_address_t lAddr, physical_address_t pAddr)
   lAddr = Round(lAddr, SYSTEM_PAGE);
   assert(largeTLB[thread].find(lAddr) == largeTLB[thread].end());
   pAddr = Round(pAddr, SYSTEM_PAGE);
-  ML_LOG("tlbhack", "storing 0x" << std::hex << lAddr << " -> 0x"
-         << pAddr << " for userthread " << thread);
+  DPRINTF(TLBHack, "storing %#x -> %#x for userthread %d\n",
+          lAddr, pAddr, thread);
   largeTLB[thread][lAddr] = pAddr;
 }
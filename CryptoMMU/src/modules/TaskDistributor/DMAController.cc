@@ -16,7 +16,7 @@ const int opmode_send = 3;
 const int opmode_recv = 4;
 
 DMAController::DMAController(NetworkInterface* ni, SPMInterface* spm,
-                             Arg1CallbackBase<uint64_t>* TLBMiss,
+                             Arg2CallbackBase<uint64_t, unsigned int>* TLBMiss,
                              Arg1CallbackBase<uint64_t>* accessViolation)
 {
   assert(ni);
@@ -57,12 +57,39 @@ DMAController::GetPageAddr(uint64_t addr) const
   return addr - (addr % TheISA::PageBytes);
 }
 
+unsigned int
+DMAController::GetASID(TransferData* td) const
+{
+  uint64_t spmAddr = td->isRead() ? td->dstLAddr : td->srcLAddr;
+  std::map<uint64_t, unsigned int>::const_iterator it = spmRegionASID.upper_bound(spmAddr);
+
+  if (it == spmRegionASID.begin()) {
+    return 0;
+  }
+
+  --it;
+  return it->second;
+}
+
 void
-DMAController::finishTranslation(uint64_t vp_base, uint64_t pp_base)
+DMAController::SetRegionASID(uint64_t spmBase, unsigned int asid)
 {
-//  assert(MSHRs.find(vp_base) != MSHRs.end());
+  spmRegionASID[spmBase] = asid;
+}
 
-  std::list<TransferData*> &tds = MSHRs[vp_base];
+bool
+DMAController::IsTranslationPending(unsigned int asid, uint64_t vp_base)
+{
+  std::map<unsigned int, std::map<uint64_t, std::list<TransferData*> > >::iterator it = MSHRs.find(asid);
+  return it != MSHRs.end() && it->second.find(vp_base) != it->second.end();
+}
+
+void
+DMAController::finishTranslation(unsigned int asid, uint64_t vp_base, uint64_t pp_base)
+{
+//  assert(IsTranslationPending(asid, vp_base));
+
+  std::list<TransferData*> &tds = MSHRs[asid][vp_base];
   std::list<TransferData*>::iterator it;
 
   for (it = tds.begin(); it != tds.end(); it++) {
@@ -74,9 +101,13 @@ DMAController::finishTranslation(uint64_t vp_base, uint64_t pp_base)
     dmaInterface->finishTranslation(dmaDevice, td);
   }
 
-  tlbMemory->insert(vp_base, pp_base);
+  tlbMemory->insert(asid, network->GetNodeID(), vp_base, pp_base);
+
+  MSHRs[asid].erase(vp_base);
 
-  MSHRs.erase(vp_base);
+  if (MSHRs[asid].empty()) {
+    MSHRs.erase(asid);
+  }
 }
 
 void
@@ -93,18 +124,19 @@ DMAController::translateTiming(TransferData* td)
   uint64_t vp_base = GetPageAddr(vaddr);
   uint64_t offset = vaddr - vp_base;
   uint64_t pp_base;
+  unsigned int asid = GetASID(td);
 
-  if (tlbMemory->lookup(vp_base, pp_base)) {
+  if (tlbMemory->lookup(asid, vp_base, pp_base)) {
     hits++;
     td->setPaddr(pp_base + offset);
     dmaInterface->finishTranslation(dmaDevice, td);
-  } else if (MSHRs.find(vp_base) != MSHRs.end()) {
+  } else if (IsTranslationPending(asid, vp_base)) {
     mshrhits++;
-    MSHRs[vp_base].push_back(td);
+    MSHRs[asid][vp_base].push_back(td);
   } else {
     misses++;
-    MSHRs[vp_base].push_back(td);
-    onTLBMiss->Call(vp_base);
+    MSHRs[asid][vp_base].push_back(td);
+    onTLBMiss->Call(vp_base, asid);
   }
 }
 
@@ -308,18 +340,25 @@ DMAController::BeginTransfer(int srcSpm, uint64_t srcAddr,
 void
 DMAController::FlushTLB()
 {
+  flushTlb++;
   tlbMemory->flushAll();
 }
 
 void
-DMAController::AddTLBEntry(uint64_t vAddr, uint64_t pAddr)
+DMAController::FlushASID(unsigned int asid)
+{
+  tlbMemory->flushASID(asid);
+}
+
+void
+DMAController::AddTLBEntry(unsigned int asid, uint64_t vAddr, uint64_t pAddr)
 {
   uint64_t vp_base = GetPageAddr(vAddr);
   uint64_t pp_base = GetPageAddr(pAddr);
 
   assert(vAddr - vp_base == pAddr - pp_base);
 
-  tlbMemory->insert(vp_base, pp_base);
+  tlbMemory->insert(asid, network->GetNodeID(), vp_base, pp_base);
 }
 
 void
@@ -349,13 +388,38 @@ TLBMemory::flushAll()
   }
 }
 
+void
+TLBMemory::flushASID(unsigned int asid)
+{
+  for (int way = 0; way < ways; way++) {
+    for (int set = 0; set < sets; set++) {
+      if (entries[way][set].asid == asid) {
+        entries[way][set].free = true;
+      }
+    }
+  }
+}
+
+void
+TLBMemory::flushDevice(int deviceID)
+{
+  for (int way = 0; way < ways; way++) {
+    for (int set = 0; set < sets; set++) {
+      if (entries[way][set].deviceID == deviceID) {
+        entries[way][set].free = true;
+      }
+    }
+  }
+}
+
 bool
-TLBMemory::lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru)
+TLBMemory::lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru)
 {
   int way = (vp_base / TheISA::PageBytes) % ways;
 
   for (int i = 0; i < sets; i++) {
-    if (entries[way][i].vpBase == vp_base && !entries[way][i].free) {
+    if (entries[way][i].vpBase == vp_base && entries[way][i].asid == asid &&
+        !entries[way][i].free) {
       pp_base = entries[way][i].ppBase;
       assert(entries[way][i].mruTick > 0);
 
@@ -372,11 +436,11 @@ TLBMemory::lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru)
 }
 
 void
-TLBMemory::insert(uint64_t vp_base, uint64_t pp_base)
+TLBMemory::insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base)
 {
   uint64_t a;
 
-  if (lookup(vp_base, a)) {
+  if (lookup(asid, vp_base, a)) {
     return;
   }
 
@@ -396,6 +460,8 @@ TLBMemory::insert(uint64_t vp_base, uint64_t pp_base)
 
   assert(entry);
 
+  entry->asid = asid;
+  entry->deviceID = deviceID;
   entry->vpBase = vp_base;
   entry->ppBase = pp_base;
   entry->free = false;
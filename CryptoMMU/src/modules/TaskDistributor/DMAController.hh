@@ -18,11 +18,13 @@ typedef prftch_direct_interface prftch_direct_interface_t;
 class TLBEntry
 {
 public:
+  unsigned int asid;
+  int deviceID;
   uint64_t vpBase;
   uint64_t ppBase;
   bool free;
   uint64_t mruTick;
-  TLBEntry() : vpBase(0), ppBase(0), free(true), mruTick(0) {}
+  TLBEntry() : asid(0), deviceID(-1), vpBase(0), ppBase(0), free(true), mruTick(0) {}
   void setMRU()
   {
     mruTick = GetSystemTime();
@@ -32,9 +34,14 @@ public:
 class BaseTLBMemory
 {
 public:
-  virtual bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true) = 0;
-  virtual void insert(uint64_t vp_base, uint64_t pp_base) = 0;
+  // entries are tagged with the owning process (asid), so translations of
+  // several programs can live side by side without a flush in between, and
+  // with the device whose miss installed them for targeted invalidation
+  virtual bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true) = 0;
+  virtual void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base) = 0;
   virtual void flushAll() = 0;
+  virtual void flushASID(unsigned int asid) = 0;
+  virtual void flushDevice(int deviceID) = 0;
 };
 
 class TLBMemory : public BaseTLBMemory
@@ -73,35 +80,61 @@ public:
     delete [] entries;
   }
 
-  virtual bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true);
-  virtual void insert(uint64_t vp_base, uint64_t pp_base);
+  virtual bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true);
+  virtual void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base);
   virtual void flushAll();
+  virtual void flushASID(unsigned int asid);
+  virtual void flushDevice(int deviceID);
 };
 
 class InfiniteTLBMemory : public BaseTLBMemory
 {
-  std::map<uint64_t, uint64_t> entries;
+  //key <asid, virtual page>
+  std::map<std::pair<unsigned int, uint64_t>, TLBEntry> entries;
 public:
   InfiniteTLBMemory() {}
   ~InfiniteTLBMemory() {}
 
-  bool lookup(uint64_t vp_base, uint64_t& pp_base, bool set_mru = true)
+  bool lookup(unsigned int asid, uint64_t vp_base, uint64_t& pp_base, bool set_mru = true)
   {
-    auto it = entries.find(vp_base);
+    auto it = entries.find(std::make_pair(asid, vp_base));
 
     if (it != entries.end()) {
-      pp_base = it->second;
+      pp_base = it->second.ppBase;
       return true;
     } else {
       pp_base = 0;
       return false;
     }
   }
-  void insert(uint64_t vp_base, uint64_t pp_base)
+  void insert(unsigned int asid, int deviceID, uint64_t vp_base, uint64_t pp_base)
   {
-    entries[vp_base] = pp_base;
+    TLBEntry& e = entries[std::make_pair(asid, vp_base)];
+    e.asid = asid;
+    e.deviceID = deviceID;
+    e.vpBase = vp_base;
+    e.ppBase = pp_base;
+    e.free = false;
   }
   void flushAll() {}
+  void flushASID(unsigned int asid)
+  {
+    auto it = entries.lower_bound(std::make_pair(asid, (uint64_t)0));
+
+    while (it != entries.end() && it->first.first == asid) {
+      entries.erase(it++);
+    }
+  }
+  void flushDevice(int deviceID)
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->second.deviceID == deviceID) {
+        entries.erase(it++);
+      } else {
+        it++;
+      }
+    }
+  }
 };
 
 class DMAController
@@ -128,7 +161,10 @@ class DMAController
   SPMInterface* spm;
   NetworkInterface* network;
   Arg1CallbackBase<uint64_t>* onAccViolation;
-  Arg1CallbackBase<uint64_t>* onTLBMiss;
+  Arg2CallbackBase<uint64_t, unsigned int>* onTLBMiss;
+  //key spm base address of a program slot, value process loading into it
+  std::map<uint64_t, unsigned int> spmRegionASID;
+  unsigned int GetASID(TransferData* td) const;
   // std::map<uint64_t, uint64_t> tlbMap;
   void OnAccessError(uint64_t logicalAddr);
   void OnNetworkMsg(int src, const void* buffer, unsigned int bufSize);
@@ -136,7 +172,7 @@ class DMAController
   typedef Arg1MemberCallback<DMAController, uint64_t, &DMAController::OnAccessError> OnAccessErrorCB;
   typedef Arg3MemberCallback<DMAController, int, const void*, unsigned int, &DMAController::OnNetworkMsg> OnNetworkMsgCB;
 public:
-  DMAController(NetworkInterface* ni, SPMInterface* spmInterface, Arg1CallbackBase<uint64_t>* TLBMiss, Arg1CallbackBase<uint64_t>* accessViolation);
+  DMAController(NetworkInterface* ni, SPMInterface* spmInterface, Arg2CallbackBase<uint64_t, unsigned int>* TLBMiss, Arg1CallbackBase<uint64_t>* accessViolation);
   ~DMAController();
 
   void BeginTransfer(int srcSpm, uint64_t srcAddr, const std::vector<unsigned int>& srcSize, const std::vector<int>& srcStride, int dstSpm, uint64_t dstAddr, const std::vector<unsigned int>& dstSize, const std::vector<int>& dstStride, size_t elementSize, CallbackBase* finishedCB);
@@ -146,7 +182,11 @@ public:
   void BeginSingleElementTransfer(int srcSpm, uint64_t src, int dstSpm, uint64_t dst, uint32_t size, int priority, CallbackBase* finishedCB);
 
   void FlushTLB();
-  void AddTLBEntry(uint64_t vAddr, uint64_t pAddr);
+  void FlushASID(unsigned int asid);
+  void AddTLBEntry(unsigned int asid, uint64_t vAddr, uint64_t pAddr);
+  // transfers landing at or above spmBase (up to the next region) translate
+  // in the address space of asid
+  void SetRegionASID(uint64_t spmBase, unsigned int asid);
 
   inline std::string GetDeviceName()
   {
@@ -175,13 +215,16 @@ public:
 
   BaseTLBMemory *tlbMemory;
 
-  std::map<uint64_t, std::list<TransferData*> > MSHRs;
+  //key asid, value outstanding misses per virtual page
+  std::map<unsigned int, std::map<uint64_t, std::list<TransferData*> > > MSHRs;
 
   void beginTranslateTiming(TransferData* td);
 
   void translateTiming(TransferData* td);
 
-  void finishTranslation(uint64_t vp_base, uint64_t pp_base);
+  void finishTranslation(unsigned int asid, uint64_t vp_base, uint64_t pp_base);
+
+  bool IsTranslationPending(unsigned int asid, uint64_t vp_base);
 
   void flushAll();
 
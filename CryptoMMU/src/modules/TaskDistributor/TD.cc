@@ -1,6 +1,7 @@
 #include "TD.hh"
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 #include "../MsgLogger/MsgLogger.hh"
 #include "../Common/TransferDescription.hh"
 #include "../Common/ComputeDescription.hh"
@@ -18,6 +19,12 @@
 #include "config/the_isa.hh"
 #include "mem/ruby/common/Global.hh"
 #include "arch/vtophys.hh"
+#include "mem/translation_trace.hh"
+#include "arch/x86/pagetable_walker.hh"
+#include "base/bitfield.hh"
+#include "cpu/thread_context.hh"
+#include "sim/system.hh"
+#include "../NetworkInterrupt/NetworkInterrupts.hh"
 
 #define NO_SPM_ID -1
 #define PAGE_SIZE (TheISA::PageBytes)
@@ -125,6 +132,405 @@ TD::ExtractMemoryManifest(const TransferDescription& td, uint32_t task)
   return accSet;
 }
 
+// Collect the pages touched by one task of a polyhedral transfer. Runs
+// along the innermost dimension are expanded page by page rather than
+// element by element, so a dense task costs O(pages) instead of O(elements).
+static void
+AddTaskPages(uint64_t base, const std::vector<uint32_t>& size,
+             const std::vector<int32_t>& stride, unsigned int split,
+             uint32_t elementSize, uint32_t task, std::set<uint64_t>& pages)
+{
+  if (size.empty()) {
+    return;
+  }
+
+  PolyhedralAddresser pa(base, size, stride);
+  size_t dims = size.size();
+  uint32_t factor = 1;
+
+  for (size_t i = split; i < dims; i++) {
+    factor *= size[i];
+  }
+
+  uint32_t runLength = (split < dims) ? size[dims - 1] : 1;
+  int64_t runStride = stride[dims - 1];
+  uint64_t runSpan = (runStride < 0) ? -runStride : runStride;
+  uint64_t first = (uint64_t)task * factor;
+
+  for (uint64_t i = first; i < first + factor; i += runLength) {
+    assert(i < pa.TotalSize());
+
+    if (runLength == 1 || runSpan < PAGE_SIZE) {
+      uint64_t lo = pa.GetAddr((uint32_t)i);
+      uint64_t hi = lo + (int64_t)(runLength - 1) * runStride;
+
+      if (hi < lo) {
+        std::swap(lo, hi);
+      }
+
+      hi += elementSize ? elementSize - 1 : 0;
+
+      for (uint64_t page = (lo / PAGE_SIZE) * PAGE_SIZE; page <= hi;
+           page += PAGE_SIZE) {
+        pages.insert(page);
+      }
+    } else {
+      for (uint32_t j = 0; j < runLength; j++) {
+        uint64_t addr = pa.GetAddr((uint32_t)(i + j));
+        pages.insert((addr / PAGE_SIZE) * PAGE_SIZE);
+        pages.insert(((addr + elementSize - 1) / PAGE_SIZE) * PAGE_SIZE);
+      }
+    }
+  }
+}
+
+void
+TD::ExtractPageManifest(const TransferDescription& td, uint32_t task,
+                        std::set<uint64_t>& pages)
+{
+  if (td.srcDevice == TransferDescription::MemoryDevice) {
+    AddTaskPages(td.srcBaseAddress, td.srcSize, td.srcStride, td.srcSplit,
+                 td.elementSize, task, pages);
+  }
+
+  if (td.dstDevice == TransferDescription::MemoryDevice) {
+    AddTaskPages(td.dstBaseAddress, td.dstSize, td.dstStride, td.dstSplit,
+                 td.elementSize, task, pages);
+  }
+
+  // page zero is never a valid accelerator buffer
+  pages.erase(0);
+}
+
+void
+TD::AdvancePrefetchWindow(unsigned int process, uint32_t taskLimit)
+{
+  if (!prefetchEnabled || programSet.find(process) == programSet.end()) {
+    return;
+  }
+
+  TDProgram* tdp = programSet[process];
+  uint32_t& nextTask = prefetchNextTask[process];
+  taskLimit = std::min(taskLimit, tdp->taskCount);
+
+  for (; nextTask < taskLimit; nextTask++) {
+    std::set<uint64_t> pages;
+
+    for (size_t edge = 0; edge < tdp->edgeSet.size(); edge++) {
+      ExtractPageManifest(tdp->edgeSet[edge].transferDesc, nextTask, pages);
+    }
+
+    for (std::set<uint64_t>::iterator it = pages.begin(); it != pages.end(); it++) {
+      uint64_t pp_base;
+
+      if (prefetchedPages[process].find(*it) != prefetchedPages[process].end()
+          || cfuTlbMisses[process].find(*it) != cfuTlbMisses[process].end()
+          || tlb->lookup(process, *it, pp_base, false)) {
+        continue;
+      }
+
+      prefetchQueue[process].push_back(*it);
+    }
+  }
+
+  IssuePrefetches();
+}
+
+void
+TD::IssuePrefetches()
+{
+  std::map<unsigned int, std::deque<uint64_t> >::iterator it = prefetchQueue.begin();
+
+  while (prefetchesInFlight < prefetchMaxInflight && it != prefetchQueue.end()) {
+    if (it->second.empty()) {
+      it++;
+      continue;
+    }
+
+    unsigned int process = it->first;
+    uint64_t logicalPage = it->second.front();
+    it->second.pop_front();
+    uint64_t pp_base;
+
+    // the page may have been demanded or prefetched since it was queued
+    if (lastKnownCore.find(process) == lastKnownCore.end()
+        || prefetchedPages[process].find(logicalPage) != prefetchedPages[process].end()
+        || cfuTlbMisses[process].find(logicalPage) != cfuTlbMisses[process].end()
+        || tlb->lookup(process, logicalPage, pp_base, false)) {
+      continue;
+    }
+
+    // requester 0 marks a walk nobody is waiting on yet
+    cfuTlbMisses[process][logicalPage].push_back(0);
+    prefetchInFlight[process].insert(logicalPage);
+    prefetchesInFlight++;
+    prefetchIssued++;
+    // the host checks the walk against the device that will use the page;
+    // before any CFU of the process asked, only the TD is known
+    uint64_t node_id = netPort->GetNodeID();
+
+    if (prefetchNodeID.find(process) != prefetchNodeID.end()) {
+      node_id = prefetchNodeID[process];
+    }
+
+    SendTranslationRequest(process, logicalPage, 0, 0, node_id, 0);
+  }
+}
+
+bool
+TD::CompletePrefetch(unsigned int process, uint64_t logicalPage,
+                     uint64_t physicalPage)
+{
+  if (prefetchInFlight.find(process) == prefetchInFlight.end()
+      || prefetchInFlight[process].erase(logicalPage) == 0) {
+    return false;
+  }
+
+  assert(prefetchesInFlight > 0);
+  prefetchesInFlight--;
+
+  // CFUs that missed while the walk was outstanding are served by the
+  // regular reply path; only untouched pages are remembered
+  bool demanded = false;
+  std::vector<int>& requesters = cfuTlbMisses[process][logicalPage];
+
+  for (size_t i = 0; i < requesters.size(); i++) {
+    if (requesters[i] != 0) {
+      demanded = true;
+    }
+  }
+
+  if (!demanded && programSet.find(process) != programSet.end()) {
+    prefetchedPages[process].insert(logicalPage);
+
+    // a verification on behalf of the TD would not warm the device's
+    // protection state, so it waits until a CFU of the process is known
+    if (prefetchVerify && prefetchNodeID.find(process) != prefetchNodeID.end()) {
+      prefetchVerifyInFlight[process].insert(logicalPage);
+      prefetchVerifies++;
+      SendTranslationRequest(process, logicalPage, physicalPage, 1,
+                             prefetchNodeID[process], 20);
+    }
+  }
+
+  return true;
+}
+
+bool
+TD::ServeFromPrefetch(int src, unsigned int process, uint64_t logicalPage,
+                      uint64_t node_id)
+{
+  std::map<unsigned int, std::set<uint64_t> >::iterator inFlight =
+    prefetchInFlight.find(process);
+
+  if (inFlight != prefetchInFlight.end()
+      && inFlight->second.find(logicalPage) != inFlight->second.end()) {
+    // walk already on its way, piggyback on it
+    prefetchLate++;
+    cfuTlbMisses[process][logicalPage].push_back(src);
+    return true;
+  }
+
+  std::map<unsigned int, std::set<uint64_t> >::iterator prefetched =
+    prefetchedPages.find(process);
+
+  if (prefetched == prefetchedPages.end()
+      || prefetched->second.erase(logicalPage) == 0) {
+    return false;
+  }
+
+  uint64_t pp_base;
+
+  if (!tlb->lookup(process, logicalPage, pp_base)) {
+    // evicted from the TD TLB before anyone used it
+    prefetchUseless++;
+    return false;
+  }
+
+  prefetchUseful++;
+  BitConverter bc;
+  uint32_t outMsg[10];
+  outMsg[0] = LCACC_CMD_TLB_SERVICE;
+  outMsg[1] = myThreadID;
+  bc.u64[0] = logicalPage;
+  outMsg[2] = bc.u32[0];
+  outMsg[3] = bc.u32[1];
+  bc.u64[0] = pp_base;
+  outMsg[4] = bc.u32[0];
+  outMsg[5] = bc.u32[1];
+  bc.u64[0] = 0;
+  outMsg[6] = bc.u32[0];
+  outMsg[7] = bc.u32[1];
+  bc.u64[0] = node_id;
+  outMsg[8] = bc.u32[0];
+  outMsg[9] = bc.u32[1];
+  // MAC generation, as for a reply to a walk
+  netPort->SendMessage(src, outMsg, sizeof(outMsg), 20);
+  return true;
+}
+
+void
+TD::DropPrefetchState(unsigned int process)
+{
+  if (prefetchedPages.find(process) != prefetchedPages.end()) {
+    prefetchUseless += prefetchedPages[process].size();
+    prefetchedPages.erase(process);
+  }
+
+  // replies to verifications still in flight find nobody waiting
+  prefetchVerifyInFlight.erase(process);
+  prefetchQueue.erase(process);
+  prefetchNextTask.erase(process);
+  prefetchNodeID.erase(process);
+}
+
+void
+TD::ReleaseProcess(unsigned int process)
+{
+  tlb->flushASID(process);
+  // a process reusing the id starts from the system virtual time
+  virtualTime.erase(process);
+  warmedCore.erase(process);
+
+  if (dma) {
+    dma->FlushASID(process);
+  }
+}
+
+void
+TD::SendTranslationRequest(unsigned int process, uint64_t logicalPage,
+                           uint64_t phyAddr, uint64_t MAC, uint64_t node_id,
+                           int delay)
+{
+  assert(lastKnownCore.find(process) != lastKnownCore.end());
+
+  if (MAC != 0 && warmedCore.find(process) != warmedCore.end()
+      && warmedCore[process] != lastKnownCore[process]) {
+    // the process moved since the warm-up, this NI's BCC is cold
+    warmupCoreMoved++;
+  }
+
+  BitConverter bc;
+  uint32_t outMsg[10];
+  outMsg[0] = LCACC_CMD_TLB_MISS;
+  outMsg[1] = process;
+  bc.u64[0] = logicalPage;
+  outMsg[2] = bc.u32[0];
+  outMsg[3] = bc.u32[1];
+  bc.u64[0] = phyAddr;
+  outMsg[4] = bc.u32[0];
+  outMsg[5] = bc.u32[1];
+  bc.u64[0] = MAC;
+  outMsg[6] = bc.u32[0];
+  outMsg[7] = bc.u32[1];
+  bc.u64[0] = node_id;
+  outMsg[8] = bc.u32[0];
+  outMsg[9] = bc.u32[1];
+  std::map<std::pair<unsigned int, uint64_t>, uint64_t>& sent =
+    (MAC == 0) ? walkSent : verifySent;
+  sent.insert(std::make_pair(std::make_pair(process, logicalPage),
+                             GetSystemTime()));
+
+  if (delay > 0) {
+    netPort->SendMessage(lastKnownCore[process], outMsg, sizeof(outMsg), delay);
+  } else {
+    netPort->SendMessage(lastKnownCore[process], outMsg, sizeof(outMsg));
+  }
+}
+
+bool
+TD::FunctionalTranslate(unsigned int process, uint64_t logicalPage,
+                        uint64_t& physicalPage)
+{
+  // walk the page table of the core the process runs on, as
+  // NetworkInterrupts::HostPTWalk does
+  if (lastKnownCore.find(process) == lastKnownCore.end()) {
+    return false;
+  }
+
+  NetworkInterrupts* ni =
+    NetworkInterrupts::LookupNIByDevice(lastKnownCore[process]);
+
+  if (ni == NULL) {
+    return false;
+  }
+
+  System *m5_system = *(System::systemList.begin());
+  ThreadContext* cpu = m5_system->getThreadContext(ni->GetHandle()->procID);
+  X86ISA::Walker* walker = cpu->getDTBPtr()->getWalker();
+  Addr addr = logicalPage;
+  unsigned logBytes;
+
+  // pages the program has not touched yet are left to the timed walk
+  if (walker->startFunctional(cpu, addr, logBytes, BaseTLB::Read) != NoFault) {
+    return false;
+  }
+
+  physicalPage = addr | (logicalPage & mask(logBytes));
+  return true;
+}
+
+void
+TD::WarmTranslations(unsigned int process, const JobDescription& job,
+                     int localCFU, int cfuID, PacketBuilder& pb)
+{
+  std::set<uint64_t> pages;
+  uint32_t taskEnd = std::min(job.taskEnd, warmupTasks);
+
+  for (size_t i = 0; i < job.hostProgram->edgeSet.size(); i++) {
+    if (job.hostProgram->edgeSet[i].from == localCFU
+        || job.hostProgram->edgeSet[i].to == localCFU) {
+      for (uint32_t task = job.taskStart; task < taskEnd; task++) {
+        ExtractPageManifest(job.hostProgram->edgeSet[i].transferDesc, task,
+                            pages);
+      }
+    }
+  }
+
+  NetworkInterrupts* ni = NULL;
+
+  if (lastKnownCore.find(process) != lastKnownCore.end()) {
+    ni = NetworkInterrupts::LookupNIByDevice(lastKnownCore[process]);
+    warmedCore[process] = lastKnownCore[process];
+  }
+
+  //key virtual page, value physical page
+  std::map<uint64_t, uint64_t> preload;
+
+  for (std::set<uint64_t>::iterator it = pages.begin(); it != pages.end(); it++) {
+    uint64_t pp_base;
+
+    if (!tlb->lookup(process, *it, pp_base)) {
+      if (!FunctionalTranslate(process, *it, pp_base)) {
+        continue;
+      }
+
+      tlb->insert(process, netPort->GetNodeID(), *it, pp_base);
+    }
+
+    if (ni) {
+      ni->Bcc->insert(pp_base, cfuID);
+    }
+
+    preload[*it] = pp_base;
+  }
+
+  warmupPages += preload.size();
+
+  if (preload.empty()) {
+    return;
+  }
+
+  // read back by LCAccDevice::ParseTaskSignature as TLB preload entries
+  pb.Write((uint32_t)preload.size());
+
+  for (std::map<uint64_t, uint64_t>::iterator it = preload.begin();
+       it != preload.end(); it++) {
+    pb.Write(it->first);
+    pb.Write(it->second);
+  }
+}
+
 bool
 TD::TryAllocateFpga(std::vector<CFUIdentifier>& cfuSet,
                     const std::vector<int>& opCodeSet, int minLatency,
@@ -320,6 +726,7 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
     readData.logicalAddr = logicalAddr;
     readData.physicalAddr = physicalAddr;
     readData.size = msg[6];
+    readData.requestTime = GetSystemTime();
 
     if (selectedBiNSize.find(process) != selectedBiNSize.end()) {
       readData.useSharedBuffer = true;
@@ -327,7 +734,7 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
       selectedBiNSize.erase(process);
     }
 
-    pendingTaskReads.push(readData);
+    pendingTaskReads.push_back(readData);
     StartProgramRead();
   }
   break;
@@ -396,6 +803,7 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
       delete programSet[userProcess];
       pendingJobSet.erase(userProcess);
       programSet.erase(userProcess);
+      DropPrefetchState(userProcess);
       requiredBufferSize.erase(userProcess);
 
       if (stalledTaskReads.find(userProcess)
@@ -443,6 +851,10 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
     //std::cout <<"Node id in TD  " << node_id << std::endl;
     //std::cout <<"TD_LCACC_CMD_TLB_MISS : logica_addr : MAC : phyAddr " << logicalAddr  <<phyAddr  << MAC_td;
     uint64_t logicalPage = (logicalAddr / PAGE_SIZE) * PAGE_SIZE;
+    TranslationTrace::record(TranslationTrace::TDArrive, node_id,
+                             logicalPage, phyAddr,
+                             MAC_td == 1 ? TranslationTrace::Verify :
+                             TranslationTrace::TLBMiss, process);
 
    /* 
     if(MAC_td==1)
@@ -512,70 +924,94 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
     uint64_t logicalPage = (logicalAddr / PAGE_SIZE) * PAGE_SIZE;
     assert(physicalAddr % PAGE_SIZE == 0);
     uint64_t physicalPage = (physicalAddr / PAGE_SIZE) * PAGE_SIZE;
+    std::map<std::pair<unsigned int, uint64_t>, uint64_t>& sent =
+      (MAC == 0) ? walkSent : verifySent;
+    std::map<std::pair<unsigned int, uint64_t>, uint64_t>::iterator it =
+      sent.find(std::make_pair(process, logicalPage));
+
+    if (it != sent.end()) {
+      ((MAC == 0) ? walkLatencyHist : verifyLatencyHist)
+        .sample(GetSystemTime() - it->second);
+      sent.erase(it);
+    }
+
+    if (MAC != 0 && prefetchVerifyInFlight.find(process) != prefetchVerifyInFlight.end()
+        && prefetchVerifyInFlight[process].erase(logicalPage)) {
+      // verification issued ahead of time by the prefetcher, nobody waits
+      break;
+    }
+
     if(MAC==0)
     {
-      tlb->insert(logicalPage, physicalPage);
+      tlb->insert(process, (int)node_id, logicalPage, physicalPage);
     }
     
+    if (MAC == 0) {
+      CompletePrefetch(process, logicalPage, physicalPage);
+    }
 
-    if (programSet.find(process) == programSet.end() && MAC==0) {
-      // no program loaded, thus the miss must be on loading the
-      // program
+    if (MAC == 0 && dma->IsTranslationPending(process, logicalPage)) {
+      // the miss was taken by a program read of this process
       // insert into TD DMA TLB
-      dma->finishTranslation(logicalPage, physicalPage);
+      dma->finishTranslation(process, logicalPage, physicalPage);
 
       //ML_LOG(GetDeviceName(),
       //       "TLB miss was serviced for program loading");
       ///ML_LOG(GetDeviceName(), "Translated 0x" << std::hex
       //       << logicalPage << " -> 0x" << physicalPage);
-    } else {
-    //  assert(cfuTlbMisses[process].find(logicalPage)!= cfuTlbMisses[process].end());
-      uint32_t outMsg[10];
-      outMsg[0] = LCACC_CMD_TLB_SERVICE;
-      outMsg[1] = myThreadID;
-      BitConverter bc;
-      bc.u64[0] = logicalPage;
-      outMsg[2] = bc.u32[0];
-      outMsg[3] = bc.u32[1];
-      bc.u64[0] = physicalPage;
-      outMsg[4] = bc.u32[0];
-      outMsg[5] = bc.u32[1];
-      bc.u64[0] = MAC;
-      outMsg[6] = bc.u32[0];
-      outMsg[7] = bc.u32[1];
-      bc.u64[0] = node_id;
-      outMsg[8] = bc.u32[0];
-      outMsg[9] = bc.u32[1];
-      // ML_LOG(GetDeviceName(), "LCAcc TLB miss serviced 0x"
-      //         << std::hex << logicalPage << " -> 0x" << physicalPage);
-      if (MAC == 0) {
-        // service all requesters
-        for (size_t i = 0; i < cfuTlbMisses[process][logicalPage].size(); i++) {
-          if (cfuTlbMisses[process][logicalPage][i] != 0) {
-            int requester = cfuTlbMisses[process][logicalPage][i];
-            netPort->SendMessage(requester, outMsg, sizeof(outMsg),20); /*MAC generation after the page walk has finished*/
-          }
-        }
+    }
 
-        cfuTlbMisses[process].erase(logicalPage);
-    
-      } 
-      else
-      {
-
-        for (size_t i = 0; i < cfuTlbMisses[process][logicalPage].size(); i++) {
-          if (cfuTlbMisses[process][logicalPage][i] != 0) {
-            int requester = cfuTlbMisses[process][logicalPage][i];
-            //std::cout<<"sent to LCAcc" << node_id << "MAC value in TD" << MAC<< std::endl;
-            netPort->SendMessage(requester, outMsg, sizeof(outMsg)); /*Page walk miss in BCC, search latency and memeory access*/
-                                                                     
-          }
+    //assert(cfuTlbMisses[process].find(logicalPage)!= cfuTlbMisses[process].end());
+    uint32_t outMsg[10];
+    outMsg[0] = LCACC_CMD_TLB_SERVICE;
+    outMsg[1] = myThreadID;
+    bc.u64[0] = logicalPage;
+    outMsg[2] = bc.u32[0];
+    outMsg[3] = bc.u32[1];
+    bc.u64[0] = physicalPage;
+    outMsg[4] = bc.u32[0];
+    outMsg[5] = bc.u32[1];
+    bc.u64[0] = MAC;
+    outMsg[6] = bc.u32[0];
+    outMsg[7] = bc.u32[1];
+    bc.u64[0] = node_id;
+    outMsg[8] = bc.u32[0];
+    outMsg[9] = bc.u32[1];
+    // ML_LOG(GetDeviceName(), "LCAcc TLB miss serviced 0x"
+    //         << std::hex << logicalPage << " -> 0x" << physicalPage);
+    if (MAC == 0) {
+      // service all requesters
+      for (size_t i = 0; i < cfuTlbMisses[process][logicalPage].size(); i++) {
+        if (cfuTlbMisses[process][logicalPage][i] != 0) {
+          int requester = cfuTlbMisses[process][logicalPage][i];
+          netPort->SendMessage(requester, outMsg, sizeof(outMsg),20); /*MAC generation after the page walk has finished*/
         }
-        cfuTlbMisses[process].erase(logicalPage);
-
       }
 
+      cfuTlbMisses[process].erase(logicalPage);
+  
+    } 
+    else
+    {
+
+      // only the device the page was checked for gets the reply
+      std::pair<uint64_t, uint64_t> key = std::make_pair(logicalPage, node_id);
+
+      for (size_t i = 0; i < cfuVerifyMisses[process][key].size(); i++) {
+        if (cfuVerifyMisses[process][key][i] != 0) {
+          int requester = cfuVerifyMisses[process][key][i];
+          //std::cout<<"sent to LCAcc" << node_id << "MAC value in TD" << MAC<< std::endl;
+          netPort->SendMessage(requester, outMsg, sizeof(outMsg)); /*Page walk miss in BCC, search latency and memeory access*/
+                                                                   
+        }
       }
+      cfuVerifyMisses[process].erase(key);
+
+    }
+
+    if (prefetchEnabled) {
+      IssuePrefetches();
+    }
        
     
   }
@@ -591,7 +1027,7 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
     break;
 
   default:
-    ML_LOG(GetDeviceName(), "Error receiving unsupported message");
+    ML_ERROR(GetDeviceName(), "Error receiving unsupported message");
     assert(0);
   }
 }
@@ -599,13 +1035,18 @@ TD::MsgHandler(int src, const void* packet, unsigned int packetSize)
 void
 TD::translate(int src, uint64_t vp_base, uint64_t phy_addr, uint64_t MAC, uint64_t node_id)
 {
-   /*
-  uint64_t pp_base;
-  //if (tlb->lookup(vp_base, pp_base) && MAC==0)
-  if (0)
-  {
-    hits++;
-    if (numEntries == 1) tlb->flushAll();
+  unsigned int userProcess = cfuUseMap[src];
+
+  if (prefetchEnabled) {
+    prefetchNodeID[userProcess] = node_id;
+  }
+
+  if (MAC == 0 && prefetchEnabled
+      && ServeFromPrefetch(src, userProcess, vp_base, node_id)) {
+    return;
+  }
+
+  if (MAC == 2) {
     BitConverter bc;
     uint32_t outMsg[10];
     outMsg[0] = LCACC_CMD_TLB_SERVICE;
@@ -613,73 +1054,47 @@ TD::translate(int src, uint64_t vp_base, uint64_t phy_addr, uint64_t MAC, uint64
     bc.u64[0] = vp_base;
     outMsg[2] = bc.u32[0];
     outMsg[3] = bc.u32[1];
-    bc.u64[0] = pp_base;
+    bc.u64[0] = 0;
     outMsg[4] = bc.u32[0];
     outMsg[5] = bc.u32[1];
-    BitConverter bmc;
-    MAC=0;
-    bmc.u64[0] = MAC;
-    outMsg[6] = bmc.u32[0];
-    outMsg[7] = bmc.u32[1];
+    bc.u64[0] = MAC;
+    outMsg[6] = bc.u32[0];
+    outMsg[7] = bc.u32[1];
     bc.u64[0] = node_id;
     outMsg[8] = bc.u32[0];
     outMsg[9] = bc.u32[1];
-    BCCMshrhits++;
-    netPort->SendMessage(src, outMsg, sizeof(outMsg));
-    // ML_LOG(GetDeviceName(), "TD TLB hit 0x" << std::hex << vp_base << " -> 0x" << pp_base);
-      
-  } 
-  else {
-      int core = lastKnownCore[cfuUseMap[src]];
-      unsigned int userProcess = cfuUseMap[src];
-      if (cfuTlbMisses[userProcess].find(vp_base)!= cfuTlbMisses[userProcess].end() && numEntries > 1 && MAC==0) {
-        //std::cout << "Map Size" << cfuTlbMisses.size()<<std::endl;
-        //mshrhits++;
-        BCCMshrhits++;
-        cfuTlbMisses[userProcess][vp_base].push_back(src);
-        cfuTlbMisses[userProcess][vp_base].push_back(src);
-      // ML_LOG(GetDeviceName(), "Redundant TD TLB miss");
-      } 
-      else 
-      {
-      //cout++;
-      //std::cout<<"MAC in sending to core   "  <<  MAC  << " acc_data " << cout << std::endl;
-      misses++;
-      cfuTlbMisses[userProcess][vp_base].push_back(src);
-      BitConverter bc;
-      uint32_t outMsg[10];
-      outMsg[0] = LCACC_CMD_TLB_MISS;
-      outMsg[1] = userProcess;
-      bc.u64[0] = vp_base;
-      outMsg[2] = bc.u32[0];
-      outMsg[3] = bc.u32[1];
-      bc.u64[0] = phy_addr;
-      outMsg[4] = bc.u32[0];
-      outMsg[5] = bc.u32[1];
-      bc.u64[0] = MAC;
-      outMsg[6] = bc.u32[0];
-      outMsg[7] = bc.u32[1];
-      bc.u64[0] = node_id;
-      outMsg[8] = bc.u32[0];
-      outMsg[9] = bc.u32[1];
-     
-      if(MAC==0)
-      {
-         netPort->SendMessage(core, outMsg, sizeof(outMsg));
-      }
-      else
-      {
-         netPort->SendMessage(core, outMsg, sizeof(outMsg),10); /* BCC cache hit Latency*/
-                                                                /*TLB hit verifcation traffic*/
-    //  }
-      
-     
-  //  }
-  //}
-      //std::cout << "MAC" << MAC << std::endl;
-    if(MAC==2)
-    {
-    uint64_t pp_base=0;
+    netPort->SendMessage(src, outMsg, sizeof(outMsg), 20);
+    return;
+  }
+
+  if (MAC != 0) {
+    // a verification checks the permission of one device, so it is only
+    // shared by requests of that device for the page
+    std::vector<int>& verifying =
+      cfuVerifyMisses[userProcess][std::make_pair(vp_base, node_id)];
+
+    if (!verifying.empty()) {
+      BCCMshrhits++;
+      verifying.push_back(src);
+      return;
+    }
+
+    verifying.push_back(src);
+    SendTranslationRequest(userProcess, vp_base, phy_addr, MAC, node_id, 20);
+    return;
+  }
+
+  // walks are merged only with walks, their reply answers every CFU of
+  // the process waiting for the page
+  std::map<uint64_t, std::vector<int> >& waiting = cfuTlbMisses[userProcess];
+  std::map<uint64_t, std::vector<int> >::iterator pending =
+    waiting.find(vp_base);
+
+  uint64_t pp_base;
+
+  if (tlb->lookup(userProcess, vp_base, pp_base)) {
+    // another CFU of this process already translated the page
+    hits++;
     BitConverter bc;
     uint32_t outMsg[10];
     outMsg[0] = LCACC_CMD_TLB_SERVICE;
@@ -690,47 +1105,27 @@ TD::translate(int src, uint64_t vp_base, uint64_t phy_addr, uint64_t MAC, uint64
     bc.u64[0] = pp_base;
     outMsg[4] = bc.u32[0];
     outMsg[5] = bc.u32[1];
-    BitConverter bmc;
-    MAC=2;
-    bmc.u64[0] = MAC;
-    outMsg[6] = bmc.u32[0];
-    outMsg[7] = bmc.u32[1];
+    bc.u64[0] = 0;
+    outMsg[6] = bc.u32[0];
+    outMsg[7] = bc.u32[1];
     bc.u64[0] = node_id;
     outMsg[8] = bc.u32[0];
     outMsg[9] = bc.u32[1];
-    netPort->SendMessage(src, outMsg, sizeof(outMsg),20);
-                                               /*ADD 20 cycles here*/
-    // ML_LOG(GetDeviceName(), "TD TLB hit 0x" << std::hex << vp_base << " -> 0x" << pp_base);
-    }
-    else
-    {
-      uint64_t pp_base;
-      int core = lastKnownCore[cfuUseMap[src]];
-      unsigned int userProcess = cfuUseMap[src];
-      misses++;
-      cfuTlbMisses[userProcess][vp_base].push_back(src);
-      BitConverter bc;
-      uint32_t outMsg[10];
-      outMsg[0] = LCACC_CMD_TLB_MISS;
-      outMsg[1] = userProcess;
-      bc.u64[0] = vp_base;
-      outMsg[2] = bc.u32[0];
-      outMsg[3] = bc.u32[1];
-      bc.u64[0] = phy_addr;
-      outMsg[4] = bc.u32[0];
-      outMsg[5] = bc.u32[1];
-      bc.u64[0] = MAC;
-      outMsg[6] = bc.u32[0];
-      outMsg[7] = bc.u32[1];
-      bc.u64[0] = node_id;
-      outMsg[8] = bc.u32[0];
-      outMsg[9] = bc.u32[1];
-      if(MAC==0)
-          netPort->SendMessage(core, outMsg, sizeof(outMsg));
-      else 
-          netPort->SendMessage(core, outMsg, sizeof(outMsg),20); /*20 cycles for verification*/
-      }
-      
+    // the reply carries a fresh MAC, as one after a walk does
+    netPort->SendMessage(src, outMsg, sizeof(outMsg), 20);
+    return;
+  }
+
+  if (pending != waiting.end()) {
+    // walk already outstanding, wait for its reply
+    mshrhits++;
+    pending->second.push_back(src);
+    return;
+  }
+
+  misses++;
+  waiting[vp_base].push_back(src);
+  SendTranslationRequest(userProcess, vp_base, phy_addr, MAC, node_id, 0);
 }
 
 
@@ -755,6 +1150,14 @@ TD::ExecuteProgram(TaskReadData& trd)
 
   requiredBufferSize[trd.process] = trd.sharedBufferSize;
   assert(pr.SizeRemaining() < 4);
+
+  int slot = GetTenantSlot(trd.process);
+  tenantPrograms[slot]++;
+  tenantProgramWait[slot] += GetSystemTime() - trd.requestTime;
+
+  // a process that was idle does not get credit for the time it was away
+  virtualTime[trd.process] = std::max(virtualTime[trd.process],
+                                      systemVirtualTime);
   uint32_t totalJobId = (tdp->taskCount + (tdp->taskGrain - 1)) / tdp->taskGrain;
 
   //ML_LOG(GetDeviceName(), "total task count: " << tdp->taskCount);
@@ -766,6 +1169,7 @@ TD::ExecuteProgram(TaskReadData& trd)
     j.hostProgram = tdp;
     j.taskStart = i * tdp->taskGrain;
     j.taskEnd = std::min((i + 1) * tdp->taskGrain, tdp->taskCount);
+    j.readyTime = GetSystemTime();
     pendingJobSet[trd.process].push(j);
   }
 
@@ -808,19 +1212,36 @@ TD::ExecuteProgram(TaskReadData& trd)
 
 #endif
   programSet[trd.process] = tdp;
+
+  if (prefetchEnabled) {
+    prefetchNextTask[trd.process] = 0;
+    AdvancePrefetchWindow(trd.process, prefetchTasks);
+  }
+
   TryNewAllocation();
 }
 
+int
+TD::GetTenantSlot(unsigned int process)
+{
+  if (tenantSlot.find(process) == tenantSlot.end()) {
+    int slot = std::min((int)tenantSlot.size(), TD_MAX_TENANTS - 1);
+    tenantSlot[process] = slot;
+  }
+
+  return tenantSlot[process];
+}
+
 void
-TD::ReadProgramDone()
+TD::ReadProgramDone(uint64_t spmBase)
 {
-  assert(!pendingTaskReads.empty());
-  TaskReadData& trd = pendingTaskReads.front();
+  assert(activeTaskReads.find(spmBase) != activeTaskReads.end());
+  TaskReadData& trd = activeTaskReads[spmBase];
   //ML_LOG(GetDeviceName(), "END program read for userthread " << trd.process);
   assert(trd.loadedPacket == NULL);
   uint8_t* buf = new uint8_t[trd.size];
 
-  spm->Read(0, trd.size, buf);
+  spm->Read(spmBase, trd.size, buf);
 
   trd.loadedPacket = new PacketReader(buf, trd.size);
   delete [] buf;
@@ -838,55 +1259,95 @@ TD::ReadProgramDone()
     stalledTaskReads[trd.process].push(trd);
   }
 
-  pendingTaskReads.pop();
-  currentlyReadingTask = false;
+  activeTaskReads.erase(spmBase);
   StartProgramRead();
 }
 
 void
 TD::StartProgramRead()
 {
-  if (pendingTaskReads.size() == 0 || currentlyReadingTask) {
-    return;
-  }
+  std::list<TaskReadData>::iterator it = pendingTaskReads.begin();
+
+  while (activeTaskReads.size() < concurrentLoads
+         && it != pendingTaskReads.end()) {
+    // a process reads one program at a time so its programs stay in order
+    bool loading = false;
+    bool exclusive = false;
+
+    for (std::map<uint64_t, TaskReadData>::iterator a = activeTaskReads.begin();
+         a != activeTaskReads.end(); a++) {
+      if (a->second.process == it->process) {
+        loading = true;
+      }
 
-  currentlyReadingTask = true;
+      if (a->second.size > spmSlotSize) {
+        exclusive = true;
+      }
+    }
 
-  TaskReadData& trd = pendingTaskReads.front();
-  //ML_LOG(GetDeviceName(), "BEGIN program read for userthread "
-  //       << trd.process);
+    if (exclusive) {
+      // a program larger than a slot has the whole SPM to itself
+      break;
+    }
 
-  std::vector<unsigned int> size;
-  std::vector<int> stride;
-  size.push_back(trd.size);
-  stride.push_back(1);
+    if (loading) {
+      it++;
+      continue;
+    }
+
+    uint64_t spmSize = spmSlotSize * concurrentLoads;
+    fatal_if(it->size > spmSize,
+             "%s: program of process %d is %d bytes, the TD SPM holds %d\n",
+             GetDeviceName(), it->process, it->size, spmSize);
+
+    uint64_t spmBase = 0;
+
+    if (it->size > spmSlotSize) {
+      // too large for a slot: wait for the loads in flight to drain, then
+      // load it alone; later reads wait behind it so it is not starved
+      if (!activeTaskReads.empty()) {
+        break;
+      }
+    } else {
+      while (activeTaskReads.find(spmBase) != activeTaskReads.end()) {
+        spmBase += spmSlotSize;
+      }
+    }
 
-  dma->FlushTLB();
-  dma->AddTLBEntry(trd.logicalAddr, trd.physicalAddr);
+    assert(spmBase < spmSize);
 
-  dma->BeginTransfer(NO_SPM_ID, trd.logicalAddr, size, stride, spm->GetID(),
-                     0, size, stride, 1, ReadProgramDoneCB::Create(this));
+    TaskReadData& trd = activeTaskReads[spmBase];
+    trd = *it;
+    trd.spmBase = spmBase;
+    it = pendingTaskReads.erase(it);
+    //ML_LOG(GetDeviceName(), "BEGIN program read for userthread "
+    //       << trd.process);
+
+    std::vector<unsigned int> size;
+    std::vector<int> stride;
+    size.push_back(trd.size);
+    stride.push_back(1);
+
+    // translations are tagged with the process, so entries of the other
+    // loads in flight stay valid
+    dma->SetRegionASID(spmBase, trd.process);
+    dma->AddTLBEntry(trd.process, trd.logicalAddr, trd.physicalAddr);
+
+    dma->BeginTransfer(NO_SPM_ID, trd.logicalAddr, size, stride, spm->GetID(),
+                       spmBase, size, stride, 1,
+                       ReadProgramDoneCB::Create(this, spmBase));
+  }
 }
 
 void
-TD::HandleTLBMiss(uint64_t addr)
+TD::HandleTLBMiss(uint64_t addr, unsigned int process)
 {
-  uint32_t msg[4];
-  assert(!pendingTaskReads.empty());
-
-  TaskReadData& trd = pendingTaskReads.front();
+  assert(lastKnownCore.find(process) != lastKnownCore.end());
 
-  assert(lastKnownCore.find(trd.process) != lastKnownCore.end());
-
-  msg[0] = LCACC_CMD_TLB_MISS;
-  msg[1] = trd.process;
-  BitConverter bc;
-  bc.u64[0] = (addr / PAGE_SIZE) * PAGE_SIZE;
-  msg[2] = bc.u32[0];
-  msg[3] = bc.u32[1];
   //ML_LOG(GetDeviceName(), "TLB miss on TD DMA vaddr 0x"
-  //       << std::hex << bc.u64[0]);
-  netPort->SendMessage(lastKnownCore[trd.process], msg, sizeof(msg));
+  //       << std::hex << addr);
+  SendTranslationRequest(process, (addr / PAGE_SIZE) * PAGE_SIZE, 0, 0,
+                         netPort->GetNodeID(), 0);
 }
 
 void
@@ -976,7 +1437,7 @@ TD::AllocateBufferComplete(bool success, int bufferSize, int bufferID,
     stalledPrograms.insert(process);
 
     if (cfuUseMap.empty()) {
-      ML_LOG(GetDeviceName(), "This buffer can NEVER be allocated");
+      ML_ERROR(GetDeviceName(), "This buffer can NEVER be allocated");
       assert(!cfuUseMap.empty());
     }
 
@@ -1049,11 +1510,32 @@ TD::AllocateBufferComplete(bool success, int bufferSize, int bufferID,
 
 #endif
 
+    if (job.taskStart < warmupTasks) {
+      WarmTranslations(process, job, (int)x, selected[x].cfuID, pb);
+    }
+
     netPort->SendMessage(selected[x].cfuID, pb.GetBuffer(),
                          pb.GetBufferSize(), patternSelector->GetLastCalculationDelay());
   }
 
+  int slot = GetTenantSlot(process);
+  tenantJobs[slot]++;
+  tenantJobWait[slot] += GetSystemTime() - job.readyTime;
+
+  // charge the job to its process; the dispatched job's start time is the
+  // system virtual time
+  systemVirtualTime = virtualTime[process];
+  virtualTime[process] += (double)(job.taskEnd - job.taskStart)
+                          / RubySystem::getTDTenantWeight(process);
+
+  uint32_t dispatchedTaskEnd = job.taskEnd;
   pendingJobSet[process].pop();
+
+  if (prefetchEnabled) {
+    // keep the window prefetchTasks ahead of the dispatched work
+    AdvancePrefetchWindow(process, dispatchedTaskEnd + prefetchTasks);
+  }
+
   TryNewAllocation();
 }
 
@@ -1064,18 +1546,23 @@ TD::TryNewAllocation()
     return;
   }
 
-  static size_t selectorBias = 0;
   bool allEmpty = true;
   unsigned int delay = 1;
   bool foundAny = false;
 
-  for (size_t i = 0; i < pendingJobSet.size(); i++) {
-    std::map<unsigned int, std::queue<JobDescription> >::iterator it
-      = pendingJobSet.begin();
+  // offer processes in order of virtual time, ties broken by process id
+  std::vector<std::pair<double, unsigned int> > order;
 
-    for (size_t x = 0; x < (i + selectorBias) % pendingJobSet.size(); x++) {
-      it++;
-    }
+  for (std::map<unsigned int, std::queue<JobDescription> >::iterator it
+       = pendingJobSet.begin(); it != pendingJobSet.end(); it++) {
+    order.push_back(std::make_pair(virtualTime[it->first], it->first));
+  }
+
+  std::sort(order.begin(), order.end());
+
+  for (size_t i = 0; i < order.size(); i++) {
+    std::map<unsigned int, std::queue<JobDescription> >::iterator it
+      = pendingJobSet.find(order[i].second);
 
     if (busyPrograms.find(it->first) != busyPrograms.end()
         || stalledPrograms.find(it->first) != stalledPrograms.end()) {
@@ -1173,7 +1660,6 @@ TD::TryNewAllocation()
 
       if (placedAll) {
         assert(!selected.empty());
-        selectorBias++;
         foundAny = true;
         busyPrograms.insert(it->first);
         int bufferID = -1;
@@ -1229,7 +1715,12 @@ TD::TryNewAllocation()
       }
 
       delay = patternSelector->GetLastCalculationDelay();
-      break;
+
+      // a process that cannot be placed right now does not block the
+      // processes behind it
+      if (foundAny) {
+        break;
+      }
     }
   }
 
@@ -1363,6 +1854,7 @@ TD::Initialize()
   assert(netPort);
 
   spm = new SPMInterface(netPort->GetNetworkPort(), 1024 * 1024 * 8);
+  spmSlotSize = (1024 * 1024 * 8) / concurrentLoads;
   dma = new DMAController(netPort, spm, HandleTLBMissCB::Create(this),
                           HandleAccessViolationCB::Create(this));
   netPort->RegisterRecvHandler(MsgHandlerCB::Create(this));
@@ -1373,7 +1865,6 @@ TD::TD()
   spm = NULL;
   netPort = NULL;
   dma = NULL;
-  currentlyReadingTask = false;
   currentlyAllocating = false;
   patternSelector = new DumbSelector();
   myThreadID = 0;
@@ -1398,4 +1889,32 @@ TD::TD()
   mshrhits = 0;
   flushTlb = 0;
   BCCMshrhits=0;
+
+  prefetchEnabled = RubySystem::TDPrefetch();
+  prefetchVerify = RubySystem::TDPrefetchVerify();
+  prefetchTasks = RubySystem::getTDPrefetchTasks();
+  prefetchMaxInflight = RubySystem::getTDPrefetchMaxInflight();
+  prefetchesInFlight = 0;
+  prefetchIssued = 0;
+  prefetchUseful = 0;
+  prefetchLate = 0;
+  prefetchUseless = 0;
+  prefetchVerifies = 0;
+  warmupTasks = RubySystem::getTranslationWarmupTasks();
+  warmupPages = 0;
+  warmupCoreMoved = 0;
+  walkLatencyHist.init(10);
+  verifyLatencyHist.init(10);
+
+  concurrentLoads = RubySystem::getTDConcurrentLoads();
+  assert(concurrentLoads > 0);
+  spmSlotSize = 0;
+  systemVirtualTime = 0;
+
+  for (int i = 0; i < TD_MAX_TENANTS; i++) {
+    tenantPrograms[i] = 0;
+    tenantProgramWait[i] = 0;
+    tenantJobs[i] = 0;
+    tenantJobWait[i] = 0;
+  }
 }
\ No newline at end of file
@@ -3,7 +3,9 @@
 
 #include <map>
 #include <set>
+#include <list>
 #include <queue>
+#include <deque>
 #include <vector>
 #include <string>
 #include <cstdio>
@@ -13,6 +15,11 @@
 #include "../Common/TransferDescription.hh"
 #include "NetworkInterface.hh"
 #include "CFUIdentifier.hh"
+#include "base/statistics.hh"
+
+// per-tenant stats are kept for the first TD_MAX_TENANTS processes seen; any
+// further process is folded into the last slot
+#define TD_MAX_TENANTS 16
 
 class DMAController;
 class BaseTLBMemory;
@@ -27,6 +34,7 @@ class TD
     const TDProgram* hostProgram;
     uint32_t taskStart;
     uint32_t taskEnd;
+    uint64_t readyTime;
     void WriteJobSegment(int logicalCFU,
                          const std::map<int, int>& logicalToPhysCFUs,
                          PacketBuilder& pb) const;
@@ -34,6 +42,7 @@ class TD
     {
       hostProgram = NULL;
       taskStart = taskEnd = 0;
+      readyTime = 0;
     }
   };
 
@@ -47,11 +56,15 @@ class TD
     bool useSharedBuffer;
     uint32_t sharedBufferSize;
     PacketReader* loadedPacket;
+    uint64_t spmBase;
+    uint64_t requestTime;
     inline TaskReadData()
     {
       loadedPacket = NULL;
       process = 0;
       logicalAddr = physicalAddr = 0;
+      spmBase = 0;
+      requestTime = 0;
       size = 0;
       useSharedBuffer = false;
       sharedBufferSize = 0;
@@ -61,12 +74,29 @@ class TD
   SPMInterface* spm;
   NetworkInterface* netPort;
   DMAController* dma;
-  bool currentlyReadingTask;
   bool currentlyAllocating;
   uint32_t myThreadID;
   uint32_t defaultTaskGrain;
   bool addingFpgaAccelerators;
-  std::queue<TaskReadData> pendingTaskReads;
+  std::list<TaskReadData> pendingTaskReads;
+
+  // Program reads in flight, at most one per process.  The SPM is split into
+  // concurrentLoads equal slots, one per outstanding read.
+  uint32_t concurrentLoads;
+  uint64_t spmSlotSize;
+  //key spm slot base, value program being read into it
+  std::map<uint64_t, TaskReadData> activeTaskReads;
+
+  // Start-time fair queueing across processes: a job is charged
+  // (tasks / weight) of virtual time to its process, and the process with the
+  // smallest virtual time is offered to the selector first.
+  //key process, value virtual start time of its next job
+  std::map<unsigned int, double> virtualTime;
+  double systemVirtualTime;
+
+  //key process, value slot in the per-tenant stats
+  std::map<unsigned int, int> tenantSlot;
+  int GetTenantSlot(unsigned int process);
 
   //key process, value size in bytes
   std::map<unsigned int, unsigned int> selectedBiNSize;
@@ -102,6 +132,9 @@ class TD
   std::map<int, int> cfuIndexMap;
   //key process, value <key logical addr, value vector of cfu ids>
   std::map<int, std::map<uint64_t, std::vector<int> > > cfuTlbMisses;
+  //as cfuTlbMisses, for verifications of pages the CFUs already hold;
+  //keyed by <logical addr, node id> as each checks one device
+  std::map<int, std::map<std::pair<uint64_t, uint64_t>, std::vector<int> > > cfuVerifyMisses;
   std::map<int, std::map<uint64_t, std::vector<int> > > IOMMUmacreq;
   //key process, value job queue
   std::map<unsigned int, std::queue<JobDescription> > pendingJobSet;
@@ -119,6 +152,45 @@ class TD
   std::map<unsigned int, std::set<int> > cfuUseFilter;
 
   std::vector<uint32_t> ExtractMemoryManifest(const TransferDescription& td, uint32_t task);
+  void ExtractPageManifest(const TransferDescription& td, uint32_t task, std::set<uint64_t>& pages);
+
+  // Translation prefetch: pages of the next tasks are walked ahead of the
+  // accelerators so that the host walk overlaps the current task's compute.
+  bool prefetchEnabled;
+  bool prefetchVerify;
+  uint32_t prefetchTasks;
+  uint32_t prefetchMaxInflight;
+  uint32_t prefetchesInFlight;
+  //key process, value next task whose pages are not yet queued
+  std::map<unsigned int, uint32_t> prefetchNextTask;
+  //key process, value pages waiting to be prefetched
+  std::map<unsigned int, std::deque<uint64_t> > prefetchQueue;
+  //key process, value pages with an outstanding walk / verification
+  std::map<unsigned int, std::set<uint64_t> > prefetchInFlight;
+  std::map<unsigned int, std::set<uint64_t> > prefetchVerifyInFlight;
+  //key process, value prefetched pages not yet demanded by any CFU
+  std::map<unsigned int, std::set<uint64_t> > prefetchedPages;
+  //key process, value node id of the last CFU of the process to translate
+  std::map<unsigned int, uint64_t> prefetchNodeID;
+  void AdvancePrefetchWindow(unsigned int process, uint32_t taskLimit);
+  void IssuePrefetches();
+  bool CompletePrefetch(unsigned int process, uint64_t logicalPage, uint64_t physicalPage);
+  bool ServeFromPrefetch(int src, unsigned int process, uint64_t logicalPage, uint64_t node_id);
+  void DropPrefetchState(unsigned int process);
+  void SendTranslationRequest(unsigned int process, uint64_t logicalPage, uint64_t phyAddr, uint64_t MAC, uint64_t node_id, int delay);
+
+  // Functional warm-up: the pages of the first warmupTasks tasks of a
+  // program are translated without timing when their job is dispatched,
+  // and installed in the TD TLB, the CFU TLB and the host BCC. The BCC is
+  // that of the NI of the core the process last ran on; verifications
+  // sent after the process moved to another core find it cold and are
+  // counted in warmupCoreMoved. Stats are left for the run script to
+  // reset.
+  uint32_t warmupTasks;
+  //key process, value core whose NI BCC the warm-up filled
+  std::map<unsigned int, int> warmedCore;
+  bool FunctionalTranslate(unsigned int process, uint64_t logicalPage, uint64_t& physicalPage);
+  void WarmTranslations(unsigned int process, const JobDescription& job, int localCFU, int cfuID, PacketBuilder& pb);
   
   int cfusPerIsland;
   //added for FPGA work
@@ -150,9 +222,9 @@ class TD
   void MsgHandler(int, const void*, unsigned int);
   void TransferComplete();
   void ExecuteProgram(TaskReadData& trd);
-  void ReadProgramDone();
+  void ReadProgramDone(uint64_t spmBase);
   void StartProgramRead();
-  void HandleTLBMiss(uint64_t);
+  void HandleTLBMiss(uint64_t, unsigned int);
   void HandleAccessViolation(uint64_t);
   void FreeBuffer(int bufferID, bool silent);
   int AcquireBufferID(uint32_t node);
@@ -176,8 +248,8 @@ class TD
   typedef Arg3MemberCallback<TD, int, const void*, unsigned int, &TD::MsgHandler> MsgHandlerCB;
   typedef MemberCallback0<TD, &TD::TransferComplete> TransferCompleteCB;
   typedef MemberCallback0<TD, &TD::StartProgramRead> StartProgramReadCB;
-  typedef MemberCallback0<TD, &TD::ReadProgramDone> ReadProgramDoneCB;
-  typedef Arg1MemberCallback<TD, uint64_t, &TD::HandleTLBMiss> HandleTLBMissCB;
+  typedef MemberCallback1<TD, uint64_t, &TD::ReadProgramDone> ReadProgramDoneCB;
+  typedef Arg2MemberCallback<TD, uint64_t, unsigned int, &TD::HandleTLBMiss> HandleTLBMissCB;
   typedef Arg1MemberCallback<TD, uint64_t, &TD::HandleAccessViolation> HandleAccessViolationCB;
   typedef MemberCallback5<TD, int, uint64_t, uint64_t, uint64_t,uint64_t, &TD::translate> translateCB;
   typedef MemberCallback3<TD, int, const void*, int, &TD::SerialMAC> SerialMACCB;
@@ -196,6 +268,8 @@ public:
   void AddFpgaRecipe(int opCode, int area, int ii, int pipelineDepth, int cycleMult);
   void ClearCFUFilter(uint32_t thread);
   void AddCFUFilter(uint32_t thread, int cfuID);
+  // drops the translations of a process that exited or whose id is reused
+  void ReleaseProcess(unsigned int process);
   void Initialize();
 
 protected:
@@ -205,6 +279,24 @@ protected:
   uint64_t mshrhits;
   uint64_t flushTlb;
   uint64_t BCCMshrhits;
+  uint64_t prefetchIssued;
+  uint64_t prefetchUseful;
+  uint64_t prefetchLate;
+  uint64_t prefetchUseless;
+  uint64_t prefetchVerifies;
+  uint64_t warmupPages;
+  uint64_t warmupCoreMoved;
+  // per-tenant stats, indexed by tenant slot
+  uint64_t tenantPrograms[TD_MAX_TENANTS];
+  uint64_t tenantProgramWait[TD_MAX_TENANTS];
+  uint64_t tenantJobs[TD_MAX_TENANTS];
+  uint64_t tenantJobWait[TD_MAX_TENANTS];
+  //key <process, virtual page>, value cycle the request left for the core
+  std::map<std::pair<unsigned int, uint64_t>, uint64_t> walkSent;
+  std::map<std::pair<unsigned int, uint64_t>, uint64_t> verifySent;
+  // round trip of requests forwarded to the core
+  Stats::Histogram walkLatencyHist;
+  Stats::Histogram verifyLatencyHist;
 
 public:
   // shared TLB entries
@@ -224,7 +316,11 @@ public:
 
   uint64_t getTlbHits()
   {
-    return hits + mshrhits;
+    return hits;
+  }
+  uint64_t getTlbMshrHits()
+  {
+    return mshrhits;
   }
   uint64_t getTlbMisses()
   {
@@ -238,6 +334,58 @@ public:
   {
     return BCCMshrhits;
   }
+  uint64_t getPrefetchIssued()
+  {
+    return prefetchIssued;
+  }
+  uint64_t getWarmupPages()
+  {
+    return warmupPages;
+  }
+  uint64_t getWarmupCoreMoved()
+  {
+    return warmupCoreMoved;
+  }
+  uint64_t getPrefetchUseful()
+  {
+    return prefetchUseful;
+  }
+  uint64_t getPrefetchLate()
+  {
+    return prefetchLate;
+  }
+  uint64_t getPrefetchUseless()
+  {
+    return prefetchUseless;
+  }
+  uint64_t getPrefetchVerifies()
+  {
+    return prefetchVerifies;
+  }
+  Stats::Histogram& getWalkLatencyHist()
+  {
+    return walkLatencyHist;
+  }
+  Stats::Histogram& getVerifyLatencyHist()
+  {
+    return verifyLatencyHist;
+  }
+  uint64_t getTenantPrograms(int slot)
+  {
+    return tenantPrograms[slot];
+  }
+  uint64_t getTenantProgramWait(int slot)
+  {
+    return tenantProgramWait[slot];
+  }
+  uint64_t getTenantJobs(int slot)
+  {
+    return tenantJobs[slot];
+  }
+  uint64_t getTenantJobWait(int slot)
+  {
+    return tenantJobWait[slot];
+  }
 
 
 };
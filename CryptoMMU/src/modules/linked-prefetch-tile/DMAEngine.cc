@@ -1,4 +1,5 @@
 #include "DMAEngine.hh"
+#include <algorithm>
 #include "../MsgLogger/MsgLogger.hh"
 #include "../Common/mf_api.hh"
 #include "arch/isa_traits.hh"
@@ -102,7 +103,12 @@ DMAEngine::DMAEngine()
   lastEmit = 0;
   inflight = 0;
   issueWidth = RubySystem::getDMAIssueWidth();
+  prefetchInflight = 0;
+  maxPrefetchInflight = std::max(issueWidth / 4, 1u);
   scheduled = false;
+  retryPending = false;
+  prefetchesIssued = 0;
+  prefetchesMerged = 0;
 }
 
 DMAEngine::~DMAEngine()
@@ -110,6 +116,7 @@ DMAEngine::~DMAEngine()
   assert(pendingReads.empty());
   assert(pendingWrites.empty());
   assert(waitingTransferSets.empty());
+  assert(blockedTransfers.empty());
 }
 
 void
@@ -143,30 +150,38 @@ DMAEngine::IsRedirectingToMemory() const
   return memObject != NULL;
 }
 
-bool
-DMAEngine::IsReady(uint64_t lAddr, uint64_t pAddr, RubyRequestType direction)
+int
+DMAEngine::L1CacheID() const
 {
-  if (!IsRedirectingToMemory()) {
 #ifdef SIM_ARC
-    int L1CacheID = RubySystem::accIDtoL1CacheID(
-                      RubySystem::deviceIDtoAccID(nodeID));
+  int id = RubySystem::accIDtoL1CacheID(RubySystem::deviceIDtoAccID(nodeID));
 #endif
 #ifdef SIM_TD
-    int L1CacheID;
+  int id;
 
-    if (nodeID < RubySystem::numberOfTDs()) {
-      L1CacheID = RubySystem::tdIDtoL1CacheID(nodeID);
-    } else {
-      L1CacheID = RubySystem::accIDtoL1CacheID(
-                    RubySystem::deviceIDtoAccID(nodeID));
-    }
+  if (nodeID < RubySystem::numberOfTDs()) {
+    id = RubySystem::tdIDtoL1CacheID(nodeID);
+  } else {
+    id = RubySystem::accIDtoL1CacheID(RubySystem::deviceIDtoAccID(nodeID));
+  }
 
 #endif
-    //std::cout << "[DMAEngine::MakeRequest]nodeID " << nodeID << ", L1CacheID " << L1CacheID << std::endl;
-    AbstractController* L1Controller =
-      g_abs_controls[MachineType_L1Cache][L1CacheID];
-    Sequencer* seq = L1Controller->getSequencer();
-    return seq->isReady(pAddr);
+  return id;
+}
+
+Sequencer*
+DMAEngine::L1Sequencer() const
+{
+  AbstractController* L1Controller =
+    g_abs_controls[MachineType_L1Cache][L1CacheID()];
+  return L1Controller->getSequencer();
+}
+
+bool
+DMAEngine::IsReady(uint64_t lAddr, uint64_t pAddr, RubyRequestType direction)
+{
+  if (!IsRedirectingToMemory()) {
+    return L1Sequencer()->isReady(pAddr);
   } else {
     assert(memInterface);
     assert(memObject);
@@ -187,28 +202,22 @@ DMAEngine::IsBufferReady(int bufferId, uint64_t addr, uint64_t dstAddr,
   return true;
 }
 
-void
+// Returns false when the L1 sequencer turns the line away. Nothing is then
+// in flight and cb is still owned by the caller.
+bool
 DMAEngine::MakeRequest(uint64_t lAddr, uint64_t pAddr,
                        RubyRequestType direction, CallbackBase* cb)
 {
   if (!IsRedirectingToMemory()) {
-#ifdef SIM_ARC
-    int L1CacheID = RubySystem::accIDtoL1CacheID(RubySystem::deviceIDtoAccID(nodeID));
-#endif
-#ifdef SIM_TD
-    int L1CacheID;
-
-    if (nodeID < RubySystem::numberOfTDs())
-      L1CacheID = RubySystem::tdIDtoL1CacheID(nodeID);
-    else
-      L1CacheID = RubySystem::accIDtoL1CacheID(RubySystem::deviceIDtoAccID(nodeID));
-
-#endif
-    AbstractController* L1Controller =
-      g_abs_controls[MachineType_L1Cache][L1CacheID];
-    Sequencer* seq = L1Controller->getSequencer();
+    Sequencer* seq = L1Sequencer();
     Request::Flags flags = 0;
-    RequestPtr req = new Request(pAddr, BLOCK_SIZE, flags, L1CacheID);
+    // stores write whole lines, so they can bypass the L1 without an RFO
+    if (direction == RubyRequestType_ST && RubySystem::DMAStreamStores())
+      flags.set(Request::BYPASS_CACHE);
+    RequestPtr req = new Request(pAddr, BLOCK_SIZE, flags, L1CacheID());
+    // the request carries no device id, so the memory controllers would
+    // otherwise count accelerator traffic as CPU traffic
+    req->setRequestorClass(ReqClassAccelerator);
     MemCmd cmd;
     //std::cout << "Timing Request in DMA Engine pAddr value" <<pAddr <<std::endl;
     if (direction == RubyRequestType_ST)
@@ -220,7 +229,15 @@ DMAEngine::MakeRequest(uint64_t lAddr, uint64_t pAddr,
     // RubyPort::SenderState *senderState = new RubyPort::SenderState(NULL);
     // pkt->pushSenderState(senderState);
     RequestStatus status = seq->makeRequest(pkt, RubyExecuteCB, cb);
-    assert(status == RequestStatus_Issued);
+
+    if (status != RequestStatus_Issued) {
+      // full or aliased, both clear once an outstanding line completes
+      assert(status == RequestStatus_BufferFull ||
+             status == RequestStatus_Aliased);
+      delete req;
+      delete pkt;
+      return false;
+    }
 
    //ML_LOG("DMAEngine", "memory request issued 0x" << std::hex << lAddr);
   } else {
@@ -235,12 +252,92 @@ DMAEngine::MakeRequest(uint64_t lAddr, uint64_t pAddr,
       memInterface->IssueWrite(memObject, pAddr, BLOCK_SIZE, NULL, cb);
     }
   }
+
+  return true;
 }
 
 void
 DMAEngine::MakePrefetch(uint64_t lAddr, uint64_t pAddr)
 {
-  //do nothing
+  uint64_t pBlockAddr = AddrRound(pAddr, BLOCK_SIZE);
+
+  // prefetches only warm the accelerator L1. They hold a sequencer entry
+  // like a demand transfer, so they take one of the issueWidth slots, and
+  // at most a quarter of them
+  if (IsRedirectingToMemory() || !HasFreeSlot() ||
+      prefetchInflight >= maxPrefetchInflight ||
+      pendingReads.find(pBlockAddr) != pendingReads.end() ||
+      pendingWrites.find(pBlockAddr) != pendingWrites.end() ||
+      emitTime.find(pBlockAddr) != emitTime.end() ||
+      !IsReady(lAddr, pBlockAddr, RubyRequestType_LD)) {
+    return;
+  }
+
+  CallbackBase* onResponse = OnPrefetchResponseCB::Create(this, pBlockAddr);
+
+  if (!MakeRequest(lAddr, pBlockAddr, RubyRequestType_LD, onResponse)) {
+    // a prefetch is only a hint, drop it rather than wait
+    onResponse->Dispose();
+    return;
+  }
+
+  prefetchesIssued++;
+  prefetchInflight++;
+  pendingReads[pBlockAddr] = NULL;
+  pendingPrefetches[pBlockAddr] = false;
+  emitTime[pBlockAddr] = GetSystemTime();
+}
+
+void
+DMAEngine::PrefetchBlock(uint64_t lAddr, uint64_t pAddr)
+{
+  MakePrefetch(lAddr, pAddr);
+}
+
+bool
+DMAEngine::HasFreeSlot() const
+{
+  return inflight + prefetchInflight < issueWidth;
+}
+
+void
+DMAEngine::OnPrefetchResponse(uint64_t addr)
+{
+  assert(emitTime.find(addr) != emitTime.end());
+  emitTime.erase(addr);
+
+  assert(pendingPrefetches.find(addr) != pendingPrefetches.end());
+
+  if (pendingPrefetches[addr]) {
+    // the demand read that merged into this prefetch was counted in
+    // flight when it was issued
+    assert(inflight);
+    inflight--;
+  }
+
+  pendingPrefetches.erase(addr);
+  assert(prefetchInflight);
+  prefetchInflight--;
+
+  if (pendingReads.find(addr) != pendingReads.end()) {
+    // nothing to copy unless a demand read merged in, the line now sits
+    // in the L1
+    if (pendingReads[addr]) {
+      ScheduleCB(0, pendingReads[addr]);
+    }
+
+    pendingReads.erase(addr);
+  }
+
+  if (pendingWrites.find(addr) != pendingWrites.end()) {
+    ScheduleCB(0, pendingWrites[addr]);
+    pendingWrites.erase(addr);
+  }
+
+  if (!scheduled && transferLeft()) {
+    ScheduleCB(1, TryTransfersCB::Create(this));
+    scheduled = true;
+  }
 }
 
 void
@@ -391,10 +488,19 @@ DMAEngine::finishTranslation(TransferData* td)
     (!td->isRead()) ? pendingReads : pendingWrites;
 
   if (pendingType.find(pBlockAddr) != pendingType.end()) {
-    pendingType[pBlockAddr] = SpliceCB::Create(this,
-                              pendingType[pBlockAddr], (td->isRead() ?
-                                  (CallbackBase*)ReadBlockCB::Create(this, pAddr, lAddr, td->dstLAddr, td->elementSize) :
-                                  (CallbackBase*)WriteBlockCB::Create(this, td->srcLAddr, pAddr, lAddr, td->elementSize)));
+    if (td->isRead() &&
+        pendingPrefetches.find(pBlockAddr) != pendingPrefetches.end() &&
+        !pendingPrefetches[pBlockAddr]) {
+      pendingPrefetches[pBlockAddr] = true;
+      prefetchesMerged++;
+    }
+
+    CallbackBase* access = (td->isRead() ?
+                            (CallbackBase*)ReadBlockCB::Create(this, pAddr, lAddr, td->dstLAddr, td->elementSize) :
+                            (CallbackBase*)WriteBlockCB::Create(this, td->srcLAddr, pAddr, lAddr, td->elementSize));
+    pendingType[pBlockAddr] = pendingType[pBlockAddr] ?
+                              SpliceCB::Create(this, pendingType[pBlockAddr], access) :
+                              access;
 
     pendingType[pBlockAddr] = SpliceCB::Create(this,
                               pendingType[pBlockAddr], td->onFinish);
@@ -403,8 +509,10 @@ DMAEngine::finishTranslation(TransferData* td)
   }
 
   if (pendingOpposite.find(pBlockAddr) != pendingOpposite.end()) {
-    pendingOpposite[pBlockAddr] = SpliceCB::Create(this,
-                                  pendingOpposite[pBlockAddr], reFinishTranslationCB::Create(this, td));
+    CallbackBase* retry = reFinishTranslationCB::Create(this, td);
+    pendingOpposite[pBlockAddr] = pendingOpposite[pBlockAddr] ?
+                                  SpliceCB::Create(this, pendingOpposite[pBlockAddr], retry) :
+                                  retry;
     return;
   }
 
@@ -424,38 +532,100 @@ DMAEngine::finishTranslation(TransferData* td)
                             (td->isRead()) ? td->dstLAddr : td->srcLAddr, requestType);
   }
   if (!isReady) {
-    waitingTransfers.push(td);
+    BlockTransfer(td);
     return;
   }
-  lastEmit = GetSystemTime();
-  pendingType[pBlockAddr] = SpliceCB::Create(this,
-                            (td->isRead() ?
-                             (CallbackBase*)ReadBlockCB::Create(this, pAddr, lAddr, td->dstLAddr, td->elementSize) :
-                             (CallbackBase*)WriteBlockCB::Create(this, td->srcLAddr, pAddr, lAddr, td->elementSize)),
-                            td->onFinish);
   if (td->buffer == -1) {
     // this is the no buffer case
     assert(emitTime.find(pBlockAddr) == emitTime.end());
+    CallbackBase* onResponse =
+      OnMemoryResponseCB::Create(this, pBlockAddr, GetSystemTime());
+
+    if (!MakeRequest(lAddr, pBlockAddr, requestType, onResponse)) {
+      onResponse->Dispose();
+      BlockTransfer(td);
+      return;
+    }
+
+    lastEmit = GetSystemTime();
     emitTime[pBlockAddr] = GetSystemTime();
-    MakeRequest(lAddr, pBlockAddr, requestType,
-                OnMemoryResponseCB::Create(this, pBlockAddr, lastEmit));
   } else {
     // a shared buffer is being used.  access that instead
     assert(emitTime.find(pBlockAddr) == emitTime.end());
+    lastEmit = GetSystemTime();
     emitTime[pBlockAddr] = GetSystemTime();
     MakeBufferCopy(pBlockAddr, (td->isRead()) ? td->dstLAddr : td->srcLAddr,
                    td->buffer, requestType,
                    OnMemoryResponseCB::Create(this, pBlockAddr, lastEmit));
   }
 
+  // responses come back no earlier than the next cycle, so the completion
+  // can be recorded after the issue
+  pendingType[pBlockAddr] = SpliceCB::Create(this,
+                            (td->isRead() ?
+                             (CallbackBase*)ReadBlockCB::Create(this, pAddr, lAddr, td->dstLAddr, td->elementSize) :
+                             (CallbackBase*)WriteBlockCB::Create(this, td->srcLAddr, pAddr, lAddr, td->elementSize)),
+                            td->onFinish);
   delete td;
 }
 
+void
+DMAEngine::BlockTransfer(TransferData* td)
+{
+  // td is already translated and counted in flight, so it waits here for
+  // the L1 rather than going back through TryTransfers
+  blockedTransfers.push_back(td);
+
+  if (retryPending) {
+    return;
+  }
+
+  retryPending = true;
+
+  if (IsRedirectingToMemory()) {
+    // the memory device has no wakeup, poll it
+    ScheduleCB(1, RetryBlockedCB::Create(this));
+  } else {
+    L1Sequencer()->addReadyCallback(RubyExecuteCB,
+                                    OnSequencerReadyCB::Create(this));
+  }
+}
+
+void
+DMAEngine::OnSequencerReady()
+{
+  // called from inside the sequencer's completion, issue from a fresh event
+  ScheduleCB(0, RetryBlockedCB::Create(this));
+}
+
+void
+DMAEngine::RetryBlocked()
+{
+  assert(retryPending);
+  retryPending = false;
+
+  std::deque<TransferData*> blocked;
+  blocked.swap(blockedTransfers);
+
+  // keep the arrival order: once one transfer blocks again, the rest queue
+  // up behind it without trying
+  while (!blocked.empty()) {
+    TransferData* td = blocked.front();
+    blocked.pop_front();
+
+    if (retryPending) {
+      blockedTransfers.push_back(td);
+    } else {
+      finishTranslation(td);
+    }
+  }
+}
+
 
 void
 DMAEngine::TryTransfers()
 {
-  if (inflight >= issueWidth) {
+  if (!HasFreeSlot()) {
     scheduled = false;
     return;
   }
@@ -487,7 +657,7 @@ DMAEngine::TryTransfers()
 
   inflight++;
 
-  if (inflight < issueWidth && transferLeft()) {
+  if (HasFreeSlot() && transferLeft()) {
     ScheduleCB(1, TryTransfersCB::Create(this));
     scheduled = true;
   } else {
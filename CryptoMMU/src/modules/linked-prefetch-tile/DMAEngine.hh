@@ -6,6 +6,7 @@
 #include <map>
 #include <vector>
 #include <queue>
+#include <deque>
 #include "SimicsInterface.hh"
 #include "../Common/BaseCallbacks.hh"
 #include "../Common/PolyhedralAddresser.hh"
@@ -14,6 +15,8 @@
 #include "../scratch-pad/scratch-pad.hh"
 #include "mem/protocol/RubyRequestType.hh"
 
+class Sequencer;
+
 #define BLOCK_SIZE 64
 #define NO_SPM_ID -1
 
@@ -151,8 +154,12 @@ class DMAEngine
 
   uint32_t inflight;
   uint32_t issueWidth;
+  // prefetches in flight, they count against issueWidth with inflight
+  uint32_t prefetchInflight;
+  uint32_t maxPrefetchInflight;
   uint64_t lastEmit;
   bool scheduled;
+  bool retryPending;
 
   Arg1CallbackBase<uint64_t>* onError;
   Arg1CallbackBase<TransferData*>* beginTranslateTiming;
@@ -166,13 +173,21 @@ class DMAEngine
 
   // key address, value cycle time
   std::map<uint64_t, uint64_t> emitTime;
-  // key physical addr, value CB to mark completion & delete transfer data
+  // key physical addr, value CB to mark completion & delete transfer data;
+  // NULL for a prefetch no demand read has merged into yet
   std::map<uint64_t, CallbackBase*> pendingReads;
   // key physical addr, value CB to mark completion & delete transfer data
   std::map<uint64_t, CallbackBase*> pendingWrites;
+  // key physical block addr, value true once a demand read merged into it
+  std::map<uint64_t, bool> pendingPrefetches;
+  uint64_t prefetchesIssued;
+  uint64_t prefetchesMerged;
 
   std::priority_queue<TransferData*, std::vector<TransferData*>, PtrLess<TransferData> > waitingTransfers;
   std::priority_queue<TransferSetDesc*, std::vector<TransferSetDesc*>, PtrLess<TransferSetDesc> > waitingTransferSets;
+  // translated transfers the L1 could not take yet, in arrival order; they
+  // keep their inflight slot until they issue
+  std::deque<TransferData*> blockedTransfers;
 
   template<class T> T AddrRound(T addr, int mod)
   {
@@ -180,30 +195,41 @@ class DMAEngine
   }
   //adding redirects for port retargetting
   bool IsRedirectingToMemory() const;
+  int L1CacheID() const;
+  Sequencer* L1Sequencer() const;
   bool IsReady(uint64_t lAddr, uint64_t pAddr, RubyRequestType direction);
   bool IsBufferReady(int bufferId, uint64_t addr, uint64_t dstAddr, RubyRequestType direction);
-  void MakeRequest(uint64_t lAddr, uint64_t pAddr, RubyRequestType direction, CallbackBase* cb);
+  bool MakeRequest(uint64_t lAddr, uint64_t pAddr, RubyRequestType direction, CallbackBase* cb);
   void MakePrefetch(uint64_t lAddr, uint64_t pAddr);
   void MakeBufferCopy(uint64_t cacheAddr, uint64_t bufferAddr, int bufferId, RubyRequestType direction, CallbackBase* cb);
   void MemDevInterfaceIntercept(const void*, CallbackBase* cb);
   typedef Stored1Arg1MemberCallback<DMAEngine, const void*, CallbackBase*, &DMAEngine::MemDevInterfaceIntercept> MemDevInterfaceInterceptCB;
   //end redirects for port retargetting
   void reFinishTranslation(TransferData* td);
+  void BlockTransfer(TransferData* td);
+  void OnSequencerReady();
+  void RetryBlocked();
   void TryTransfers();
   void OnMemoryResponse(uint64_t addr, uint64_t emitTime);
+  void OnPrefetchResponse(uint64_t addr);
+  bool HasFreeSlot() const;
   void WriteBlock(uint64_t spmAddr, uint64_t pMemAddr, uint64_t lMemAddr, size_t size);
   void ReadBlock(uint64_t pMemAddr, uint64_t lMemAddr, uint64_t spmAddr, size_t size);
   void Splice(CallbackBase* cb1, CallbackBase* cb2);
   typedef MemberCallback2<DMAEngine, CallbackBase*, CallbackBase*, &DMAEngine::Splice> SpliceCB;
   typedef MemberCallback2<DMAEngine, uint64_t, uint64_t, &DMAEngine::OnMemoryResponse> OnMemoryResponseCB;
+  typedef MemberCallback1<DMAEngine, uint64_t, &DMAEngine::OnPrefetchResponse> OnPrefetchResponseCB;
   typedef MemberCallback1<DMAEngine, TransferData*, &DMAEngine::reFinishTranslation> reFinishTranslationCB;
   typedef MemberCallback4<DMAEngine, uint64_t, uint64_t, uint64_t, size_t, &DMAEngine::WriteBlock> WriteBlockCB;
   typedef MemberCallback4<DMAEngine, uint64_t, uint64_t, uint64_t, size_t, &DMAEngine::ReadBlock> ReadBlockCB;
   typedef MemberCallback0<DMAEngine, &DMAEngine::TryTransfers> TryTransfersCB;
+  typedef MemberCallback0<DMAEngine, &DMAEngine::OnSequencerReady> OnSequencerReadyCB;
+  typedef MemberCallback0<DMAEngine, &DMAEngine::RetryBlocked> RetryBlockedCB;
 
 public:
   void AddTransferSet(int srcDevice, uint64_t srcAddr, unsigned int srcDimensions, const unsigned int* srcElementSize, const int* srcElementStride, int dstDevice, uint64_t dstAddr, unsigned int dstDimensions, const unsigned int* dstElementSize, const int* dstElementStride, size_t transferSize, int priority, int buffer, CallbackBase* onFinish);
   void PrefetchSet(uint64_t addr, unsigned int dimensions, const unsigned int* elementSize, const int* elementStride, size_t transferSize);
+  void PrefetchBlock(uint64_t lAddr, uint64_t pAddr);
   void AddSingleTransfer(int srcDevice, uint64_t srcAddr, int dstDevice, uint64_t dstAddr, size_t transferSize, int priority, int buffer, CallbackBase* onFinish);
   void HookToMemoryPort(const char* deviceName);
   void UnhookMemoryPort();
@@ -213,6 +239,14 @@ public:
   void finishTranslation(TransferData* td);
   void protectionTableAccess();
   bool transferLeft();
+  uint64_t getPrefetchesIssued()
+  {
+    return prefetchesIssued;
+  }
+  uint64_t getPrefetchesMerged()
+  {
+    return prefetchesMerged;
+  }
 };
 
 #endif
@@ -18,6 +18,8 @@ void StartTransferPrio(DMAEngineHandle* dma, int srcDevice, uint64_t srcAddr,
 void Prefetch(DMAEngineHandle* dma, uint64_t addr, unsigned int dimensions,
               const unsigned int* elementSize, const int* elementStride, size_t transferSize);
 
+void PrefetchBlock(DMAEngineHandle* dma, uint64_t lAddr, uint64_t pAddr);
+
 void StartSingleTransfer(DMAEngineHandle* dma, int srcSpm, uint64_t src,
                          int dstSpm, uint64_t dst, uint32_t size, int buffer, CallbackBase* onFinish);
 
@@ -89,6 +91,15 @@ Prefetch(DMAEngineHandle* dma, uint64_t addr, unsigned int dimensions,
   x->ptd->PrefetchSet(addr, dimensions, elementSize, elementStride, transferSize);
 }
 
+void
+PrefetchBlock(DMAEngineHandle* dma, uint64_t lAddr, uint64_t pAddr)
+{
+  DMAEngineHandle* x = (DMAEngineHandle*)dma;
+  assert(x);
+  assert(x->ptd);
+  x->ptd->PrefetchBlock(lAddr, pAddr);
+}
+
 void
 StartSingleTransfer(DMAEngineHandle* dma, int srcSpm, uint64_t src,
                     int dstSpm, uint64_t dst, uint32_t size, int buffer, CallbackBase* onFinish)
@@ -154,6 +165,7 @@ CreateDMAEngineInterface()
   prftch_direct_interface->StartTransfer = StartTransfer;
   prftch_direct_interface->StartTransferPrio = StartTransferPrio;
   prftch_direct_interface->Prefetch = Prefetch;
+  prftch_direct_interface->PrefetchBlock = PrefetchBlock;
   prftch_direct_interface->Configure = Configure;
   prftch_direct_interface->StartSingleTransfer = StartSingleTransfer;
   prftch_direct_interface->StartSingleTransferPrio = StartSingleTransferPrio;
@@ -34,6 +34,8 @@ typedef struct prftch_direct_interface {
                    unsigned int srcDimensions, const unsigned int* srcElementSize,
                    const int* srcStride, size_t transferSize);
 
+  void (*PrefetchBlock)(DMAEngineHandle* dma, uint64_t lAddr, uint64_t pAddr);
+
   void (*StartSingleTransfer)(DMAEngineHandle* dma, int srcSpm, uint64_t src,
                               int dstSpm, uint64_t dst, uint32_t size, int buffer,
                               CallbackBase* onFinish);
@@ -628,6 +628,11 @@ workbegin(ThreadContext *tc, uint64_t workid, uint64_t threadid)
     DPRINTF(WorkItems, "Work Begin workid: %d, threadid %d\n", workid,
             threadid);
 
+    // the benchmarks tag their accelerator work with this thread id; a new
+    // process reusing it must not see what the accelerators kept for the
+    // previous one
+    LCAccReleaseProcess(threadid);
+
     //
     // If specified, determine if this is the specific work item the user
     // identified
@@ -685,6 +690,9 @@ workend(ThreadContext *tc, uint64_t workid, uint64_t threadid)
 
     DPRINTF(WorkItems, "Work End workid: %d, threadid %d\n", workid, threadid);
 
+    // the process is done with the accelerators
+    LCAccReleaseProcess(threadid);
+
     //
     // If specified, determine if this is the specific work item the user
     // identified
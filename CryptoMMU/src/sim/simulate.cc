@@ -50,6 +50,7 @@
 #define SIM_NET_PORTS
 #ifdef SIM_NET_PORTS
 #include "modules/NetworkInterrupt/NetworkInterrupts.hh"
+#include "modules/LCAcc/ComputePool.hh"
 #include "modules/Synchronize/Synchronize.hh"
 #include "mem/ruby/common/Global.hh"
 #include "system.hh"
@@ -233,13 +234,17 @@ doSimLoop(EventQueue *eventq)
 #if defined(SIM_NET_PORTS) && !defined(SIM_SW)
         //advance our private event queue for local CBs
 	while( lastCycle < m5_system->ticksToCycles(eventq->nextTick()) ) {
-	  while(localCBsForCycle(lastCycle)) {
-	      std::queue<CBContainer>& cycleQueue = getCurrentCycleQueue(lastCycle);
-	      CBContainer cb = cycleQueue.front();
-	      cycleQueue.pop();
-	      cb.call();
-	      //don't retire so that the next check will retire this sequence.
-	  }
+	  //accelerator compute kernels deferred by this quantum's callbacks run
+	  //in parallel once its last cycle drains, their continuations may add more
+	  do {
+	    while(localCBsForCycle(lastCycle)) {
+	        std::queue<CBContainer>& cycleQueue = getCurrentCycleQueue(lastCycle);
+	        CBContainer cb = cycleQueue.front();
+	        cycleQueue.pop();
+	        cb.call();
+	        //don't retire so that the next check will retire this sequence.
+	    }
+	  } while(LCAcc::ComputePool::Instance()->Run(lastCycle));
 	  ++lastCycle;
 	  eventq->setCurTick(eventq->getCurTick() + m5_system->clockPeriod());
 	}
@@ -0,0 +1,116 @@
+/*
+ * Lookup throughput of the Ruby cache tag index layouts.
+ *
+ * Replays the same random access stream against a hash and a flat
+ * CacheTagIndex: every access looks its line up, a miss evicts a random
+ * way of the set and inserts the line there, the way CacheMemory does.
+ * Both runs must find every line in the same way, otherwise the test
+ * fails.
+ *
+ * Usage: tagindextime [sets [assoc [accesses]]]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "mem/ruby/structures/CacheTagIndex.hh"
+
+using namespace std;
+
+namespace {
+
+struct Result
+{
+    double seconds;
+    uint64_t hits;
+    uint64_t checksum;
+};
+
+Result
+run(CacheTagIndex::Kind kind, int sets, int assoc,
+    const vector<Addr>& stream, const vector<int>& victims)
+{
+    const int block_bits = 6;
+    CacheTagIndex index;
+    index.init(kind, sets, assoc);
+
+    // the tag each way holds, as CacheMemory's entries would
+    vector<Addr> ways((size_t)sets * assoc, 0);
+    vector<bool> valid((size_t)sets * assoc, false);
+
+    Result result = { 0, 0, 0 };
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < stream.size(); i++) {
+        Addr line = stream[i];
+        int64_t set = (line >> block_bits) & (sets - 1);
+        int way = index.find(set, line);
+
+        if (way != -1) {
+            result.hits++;
+        } else {
+            way = victims[i];
+            size_t slot = set * assoc + way;
+
+            if (valid[slot])
+                index.erase(set, way, ways[slot]);
+
+            index.insert(set, way, line);
+            ways[slot] = line;
+            valid[slot] = true;
+        }
+
+        result.checksum = result.checksum * 31 + way;
+    }
+
+    result.seconds = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char *argv[])
+{
+    int sets = argc > 1 ? atoi(argv[1]) : 128;
+    int assoc = argc > 2 ? atoi(argv[2]) : 8;
+    size_t accesses = argc > 3 ? atol(argv[3]) : 20000000;
+
+    if (sets <= 0 || (sets & (sets - 1)) != 0 || assoc <= 0) {
+        cerr << "sets must be a power of two and assoc positive" << endl;
+        return 1;
+    }
+
+    // a working set of twice the capacity, with a hot quarter taking
+    // most of the accesses, gives a mix of hits and misses
+    size_t lines = (size_t)sets * assoc * 2;
+    vector<Addr> stream(accesses);
+    vector<int> victims(accesses);
+    srand(1);
+
+    for (size_t i = 0; i < accesses; i++) {
+        size_t line = rand() % 4 ? rand() % (lines / 4) : rand() % lines;
+        stream[i] = (Addr)line << 6;
+        victims[i] = rand() % assoc;
+    }
+
+    Result hash = run(CacheTagIndex::Hash, sets, assoc, stream, victims);
+    Result flat = run(CacheTagIndex::Flat, sets, assoc, stream, victims);
+
+    cout << sets << " sets, " << assoc << " ways, " << accesses
+         << " accesses, " << hash.hits << " hits" << endl;
+    cout << "hash: " << accesses / hash.seconds / 1e6 << " M lookups/s"
+         << endl;
+    cout << "flat: " << accesses / flat.seconds / 1e6 << " M lookups/s"
+         << endl;
+
+    if (hash.hits != flat.hits || hash.checksum != flat.checksum) {
+        cerr << "hash and flat tag indexes disagree" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python
+
+# This script decodes the binary translation pipeline trace written by
+# src/mem/translation_trace.cc (--translation_trace) and prints a latency
+# breakdown of accelerator translations.
+#
+# Records of a page are grouped by (device, vpn). A lifecycle opens at
+# the Issue of a TLB miss or of a verification request and closes at the
+# matching Finish; later issues for the same page while it is open merge
+# into it, like the accelerator MSHRs do. For every pair of consecutive
+# stages seen in a lifecycle the script prints a log2 histogram of the
+# latency between them, plus the end to end latency per outcome.
+#
+# Usage: decode_translation_trace.py [--csv out.csv] <trace>
+
+from __future__ import print_function
+
+import optparse
+import struct
+import sys
+
+HEADER = struct.Struct('=8sII')
+RECORD = struct.Struct('=QQQIBBH')
+MAGIC = b'CMMUTRC'
+VERSION = 1
+
+EVENTS = ['Issue', 'TDArrive', 'BCCLookup', 'WalkStart', 'WalkEnd',
+          'MACDone', 'Finish']
+OUTCOMES = ['None', 'TLBHit', 'TLBMiss', 'Verify', 'BCCHit', 'BCCMiss',
+            'Walked', 'Verified']
+
+ISSUE, TD_ARRIVE, BCC_LOOKUP, WALK_START, WALK_END, MAC_DONE, FINISH = \
+    range(len(EVENTS))
+TLB_HIT, TLB_MISS, VERIFY = 1, 2, 3
+
+def read_records(path):
+    with open(path, 'rb') as f:
+        header = f.read(HEADER.size)
+
+        if len(header) != HEADER.size:
+            sys.exit("%s: truncated header" % path)
+
+        magic, version, record_size = HEADER.unpack(header)
+
+        if magic.rstrip(b'\0') != MAGIC:
+            sys.exit("%s: not a translation trace" % path)
+
+        if version != VERSION or record_size != RECORD.size:
+            sys.exit("%s: unsupported trace version %d (record size %d)" %
+                     (path, version, record_size))
+
+        while True:
+            data = f.read(RECORD.size)
+
+            if len(data) < RECORD.size:
+                break
+
+            yield RECORD.unpack(data)
+
+class Histogram(object):
+    def __init__(self):
+        self.samples = []
+
+    def add(self, value):
+        self.samples.append(value)
+
+    def dump(self, title):
+        s = sorted(self.samples)
+        n = len(s)
+        print("%s: samples %d mean %.1f p50 %d p99 %d max %d" %
+              (title, n, float(sum(s)) / n, s[n // 2],
+               s[min(n - 1, (n * 99) // 100)], s[-1]))
+
+        buckets = {}
+
+        for v in s:
+            b = 0 if v == 0 else v.bit_length()
+            buckets[b] = buckets.get(b, 0) + 1
+
+        width = 50
+        peak = max(buckets.values())
+
+        for b in sorted(buckets):
+            lo = 0 if b == 0 else 1 << (b - 1)
+            hi = 0 if b == 0 else (1 << b) - 1
+            bar = '#' * max(1, (buckets[b] * width) // peak)
+            print("  %10d-%-10d %8d %s" % (lo, hi, buckets[b], bar))
+
+def main():
+    parser = optparse.OptionParser(usage="%prog [options] <trace>")
+    parser.add_option("--csv", metavar="FILE",
+                      help="also write one line per completed lifecycle")
+    (options, args) = parser.parse_args()
+
+    if len(args) != 1:
+        parser.error("expected one trace file")
+
+    # key (device, vpn), value list of (event, tick, outcome)
+    open_walks = {}
+    stages = {}
+    totals = {}
+    events = [0] * len(EVENTS)
+    tlb_hits = 0
+    merged = 0
+    unmatched = 0
+    csv = open(options.csv, 'w') if options.csv else None
+
+    if csv:
+        csv.write("device,vpn,ppn,outcome,issue,finish,stages\n")
+
+    for tick, vpn, ppn, device, event, outcome, context in \
+            read_records(args[0]):
+        events[event] += 1
+        key = (device, vpn)
+
+        if event == ISSUE:
+            if outcome == TLB_HIT:
+                tlb_hits += 1
+            elif key in open_walks:
+                merged += 1
+            else:
+                open_walks[key] = [(ISSUE, tick, outcome)]
+            continue
+
+        life = open_walks.get(key)
+
+        if life is None:
+            # prefetch replies and records of walks issued before the
+            # trace started
+            unmatched += 1
+            continue
+
+        if event != FINISH:
+            # keep the first time a lifecycle reaches each stage
+            if all(e != event for e, _, _ in life):
+                life.append((event, tick, outcome))
+            continue
+
+        life.append((FINISH, tick, outcome))
+        del open_walks[key]
+
+        for (e0, t0, _), (e1, t1, _) in zip(life, life[1:]):
+            name = "%s->%s" % (EVENTS[e0], EVENTS[e1])
+            stages.setdefault(name, Histogram()).add(t1 - t0)
+
+        total = "total (%s)" % OUTCOMES[outcome]
+        totals.setdefault(total, Histogram()).add(tick - life[0][1])
+
+        if csv:
+            csv.write("%d,%#x,%#x,%s,%d,%d,%s\n" %
+                      (device, vpn, ppn, OUTCOMES[outcome], life[0][1], tick,
+                       '|'.join(EVENTS[e] for e, _, _ in life)))
+
+    print("records: " + ", ".join("%s %d" % (EVENTS[i], events[i])
+                                  for i in range(len(EVENTS))))
+    print("tlb hits %d, merged issues %d, unmatched records %d, "
+          "unfinished lifecycles %d" %
+          (tlb_hits, merged, unmatched, len(open_walks)))
+    print()
+
+    for name in sorted(totals):
+        totals[name].dump(name)
+        print()
+
+    for name in sorted(stages, key=lambda n: -sum(stages[n].samples)):
+        stages[name].dump(name)
+        print()
+
+    if csv:
+        csv.close()
+
+if __name__ == "__main__":
+    main()
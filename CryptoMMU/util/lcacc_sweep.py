@@ -0,0 +1,280 @@
+#!/usr/bin/env python
+
+# This script runs a design-space sweep of the accelerator system. It
+# takes a grid over the benchmarks, the number of accelerator instances,
+# L2 banks, LCAcc TLB entries, BCC entries, host walkers and MMU policy,
+# runs one gem5 process per point in parallel and collects the stats of
+# all points into one table.
+#
+# Every job restores from the same checkpoint directory, the way
+# run_bench.sh does. A restore only reads that directory (the disk COW
+# layers are loaded from it and never saved back), so the jobs share it
+# without copies.
+#
+# Each point gets its own output directory under the sweep directory,
+# named after its parameters. A job that exits cleanly leaves a
+# sweep.status file there; running the same sweep again skips those
+# points, so an interrupted sweep resumes where it stopped. Failed points
+# are rerun with --retry-failed.
+#
+# Usage: lcacc_sweep.py [options] <sweep dir>
+#
+# For example:
+#   lcacc_sweep.py --bench Denoise,BlackScholes --tlb 16,32,64 \
+#       --mmu cryptommu_serial,border_control -j 16 result/tlb_sweep
+
+from __future__ import print_function
+
+import csv
+import itertools
+import multiprocessing
+import optparse
+import os
+import re
+import subprocess
+import threading
+import time
+
+# option name, command line flag, default grid, prefix in the directory name
+DIMENSIONS = [
+    ('bench', None, 'BlackScholes', ''),
+    ('acc', '--num_accinstances', '8', 'acc'),
+    ('l2_banks', '--num-l2caches', '32', 'l2'),
+    ('tlb', '--lcacc_tlb_size', '32', 'tlb'),
+    ('bcc', '--bcc_entries', '10', 'bcc'),
+    ('walkers', '--host_ptw_walkers', '1', 'w'),
+    ('mmu', '--mmu_policy', 'cryptommu_serial', ''),
+]
+
+BENCH_SUFFIX = 'td'
+
+# the fixed part of the run_bench.sh command line
+BASE_OPTIONS = ['--restore-with-cpu=detailed', '-r', '1', '-n', '1',
+                '--l2_size=64kB', '--mem-size=2GB', '--num-dirs=4', '--ruby',
+                '--lcacc', '--garnet=fixed', '--topology=Mesh',
+                '--mesh-rows=4', '--host_ptw_latency=1', '--lcacc_tlb_mshr=0',
+                '--work-end-exit-count=1']
+
+DEFAULT_STATS = [r'^sim_ticks$', r'^sim_seconds$', r'^host_seconds$']
+
+STATUS_FILE = 'sweep.status'
+
+class Job(object):
+    def __init__(self, point, options):
+        self.point = point
+        self.name = '-'.join(prefix + str(point[dim])
+                             for dim, _, _, prefix in DIMENSIONS)
+        self.outdir = os.path.join(options.sweep_dir, self.name)
+
+    def command(self, options):
+        bench = self.point['bench']
+        bcc = int(self.point['bcc'])
+        cmd = [options.binary, '--outdir=' + self.outdir,
+               os.path.join(options.m5_path, 'configs', 'example',
+                            'fs_tlb.py'),
+               '--checkpoint-dir=' + options.checkpoint_dir]
+        cmd += BASE_OPTIONS
+
+        for dim, flag, _, _ in DIMENSIONS:
+            if flag:
+                cmd.append('%s=%s' % (flag, self.point[dim]))
+
+        cmd.append('--bcc_assoc=%d' % (options.bcc_assoc or bcc))
+        cmd.append('--acc_type=' + bench)
+        cmd.append('--script=' + os.path.join(
+            options.m5_path, 'configs', 'boot',
+            '%s.%s.rcS' % (bench, BENCH_SUFFIX)))
+        cmd += options.extra.split()
+        return cmd
+
+    def status(self):
+        try:
+            with open(os.path.join(self.outdir, STATUS_FILE)) as f:
+                return int(f.read().split()[0])
+        except (IOError, OSError, ValueError, IndexError):
+            return None
+
+    def run(self, options):
+        if not os.path.isdir(self.outdir):
+            os.makedirs(self.outdir)
+
+        status_path = os.path.join(self.outdir, STATUS_FILE)
+
+        if os.path.exists(status_path):
+            os.remove(status_path)
+
+        cmd = self.command(options)
+
+        with open(os.path.join(self.outdir, 'cmd.txt'), 'w') as f:
+            f.write(' '.join(cmd) + '\n')
+
+        start = time.time()
+
+        with open(os.path.join(self.outdir, 'result.txt'), 'w') as out:
+            code = subprocess.call(cmd, stdout=out, stderr=subprocess.STDOUT)
+
+        wall = time.time() - start
+
+        # written last, so its presence means the run is complete
+        with open(status_path + '.tmp', 'w') as f:
+            f.write('%d %.1f\n' % (code, wall))
+
+        os.rename(status_path + '.tmp', status_path)
+        return code
+
+def parse_stats(path, patterns):
+    # values of the last dump in the file, key stat name
+    values = {}
+
+    try:
+        f = open(path)
+    except IOError:
+        return values
+
+    with f:
+        for line in f:
+            if line.startswith('---------- Begin Simulation Statistics'):
+                values = {}
+                continue
+
+            fields = line.split()
+
+            if len(fields) < 2 or fields[0].startswith('-'):
+                continue
+
+            if any(p.search(fields[0]) for p in patterns):
+                values[fields[0]] = fields[1]
+
+    return values
+
+def collect(jobs, options):
+    patterns = [re.compile(s) for s in DEFAULT_STATS + options.stat]
+    rows = []
+    names = set()
+
+    for job in jobs:
+        stats = parse_stats(os.path.join(job.outdir, 'stats.txt'), patterns)
+        names.update(stats)
+        status = job.status()
+        row = dict(job.point)
+        row['status'] = 'missing' if status is None else status
+        row.update(stats)
+        rows.append(row)
+
+    columns = [dim for dim, _, _, _ in DIMENSIONS] + ['status'] + \
+        sorted(names)
+    path = options.table or os.path.join(options.sweep_dir, 'results.csv')
+
+    with open(path, 'w') as f:
+        writer = csv.writer(f)
+        writer.writerow(columns)
+
+        for row in rows:
+            writer.writerow([row.get(c, '') for c in columns])
+
+    print("wrote %d points to %s" % (len(rows), path))
+
+def main():
+    parser = optparse.OptionParser(usage="%prog [options] <sweep dir>")
+
+    for dim, flag, default, _ in DIMENSIONS:
+        parser.add_option("--" + dim.replace('_', '-'), dest=dim,
+                          default=default, metavar="V[,V]",
+                          help="values to sweep%s (default %s)" %
+                          (" for " + flag if flag else "", default))
+
+    parser.add_option("--bcc-assoc", type="int", default=0,
+                      help="BCC associativity, 0 for fully associative")
+    parser.add_option("--extra", default="",
+                      help="options appended to every command line")
+    parser.add_option("-j", "--jobs", type="int",
+                      default=multiprocessing.cpu_count(),
+                      help="number of simulations to run at once")
+    parser.add_option("--m5-path", default=os.environ.get('M5_PATH', '.'),
+                      help="gem5 tree (default $M5_PATH)")
+    parser.add_option("--binary", default=None,
+                      help="gem5 binary (default build/X86/gem5.opt)")
+    parser.add_option("--checkpoint-dir", default=None,
+                      help="checkpoint to restore from (default ckpt-1core)")
+    parser.add_option("--stat", action="append", default=[],
+                      metavar="REGEX", help="extra stats to collect")
+    parser.add_option("--table", default=None,
+                      help="output table (default <sweep dir>/results.csv)")
+    parser.add_option("--retry-failed", action="store_true",
+                      help="rerun points whose simulation failed")
+    parser.add_option("--collect-only", action="store_true",
+                      help="only collect the stats of finished points")
+    parser.add_option("-n", "--dry-run", action="store_true",
+                      help="print the commands of the pending points")
+    (options, args) = parser.parse_args()
+
+    if len(args) != 1:
+        parser.error("expected a sweep directory")
+
+    options.sweep_dir = args[0]
+    options.binary = options.binary or \
+        os.path.join(options.m5_path, 'build', 'X86', 'gem5.opt')
+    options.checkpoint_dir = options.checkpoint_dir or \
+        os.path.join(options.m5_path, 'ckpt-1core')
+
+    grid = [getattr(options, dim).split(',') for dim, _, _, _ in DIMENSIONS]
+    jobs = []
+
+    for values in itertools.product(*grid):
+        point = dict(zip([dim for dim, _, _, _ in DIMENSIONS], values))
+        jobs.append(Job(point, options))
+
+    done = [job for job in jobs if job.status() == 0]
+    failed = [job for job in jobs if job.status() not in (None, 0)]
+    pending = [job for job in jobs if job.status() is None or
+               (job.status() != 0 and options.retry_failed)]
+    print("%d points, %d done, %d failed, %d to run" %
+          (len(jobs), len(done), len(failed), len(pending)))
+
+    if options.dry_run:
+        for job in pending:
+            print(' '.join(job.command(options)))
+        return
+
+    if not options.collect_only and pending:
+        lock = threading.Lock()
+        queue = list(pending)
+        failed = []
+
+        def worker():
+            while True:
+                with lock:
+                    if not queue:
+                        return
+                    job = queue.pop(0)
+                    print("start %s" % job.name)
+
+                code = job.run(options)
+
+                with lock:
+                    print("%s %s (exit %d)" %
+                          ("done" if code == 0 else "FAILED", job.name, code))
+
+                    if code != 0:
+                        failed.append(job)
+
+        threads = [threading.Thread(target=worker)
+                   for i in range(max(1, min(options.jobs, len(pending))))]
+
+        for t in threads:
+            t.daemon = True
+            t.start()
+
+        # join with a timeout so ctrl-c reaches the main thread
+        for t in threads:
+            while t.is_alive():
+                t.join(1)
+
+        if failed:
+            print("%d points failed, see result.txt in their directories" %
+                  len(failed))
+
+    collect(jobs, options)
+
+if __name__ == "__main__":
+    main()